@@ -29,26 +29,84 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #------------------------------------------------------------------------------
 
+# Replaces the global allocation operators to count heap allocations, used by
+# the streaming benchmark to verify that the chunk pools cover streaming.
+option(VOXEL_TRACK_ALLOCATIONS "Count heap allocations" OFF)
+if (VOXEL_TRACK_ALLOCATIONS)
+	add_definitions(-DVOXEL_TRACK_ALLOCATIONS)
+endif()
+
 set(VOXEL_SRC
+	src/core/aabb.hpp
 	src/core/algorithm.hpp
 	src/core/cube.hpp
+	src/core/fixedPool.cpp
+	src/core/fixedPool.hpp
+	src/core/frameArena.cpp
+	src/core/frameArena.hpp
+	src/core/frustum.hpp
+	src/core/linearArena.cpp
+	src/core/linearArena.hpp
+	src/core/memoryStats.cpp
+	src/core/memoryStats.hpp
+	src/core/rangeAllocator.cpp
+	src/core/rangeAllocator.hpp
 	src/core/types.hpp
 	src/core/screenspaceTiling.hpp
+	src/core/simd.hpp
+	src/core/spscQueue.hpp
+	src/core/threadPool.cpp
+	src/core/threadPool.hpp
+	src/core/virtualMemory.cpp
+	src/core/virtualMemory.hpp
 
+	src/game/blockPicker.cpp
+	src/game/blockPicker.hpp
 	src/game/camera.cpp
 	src/game/camera.hpp
+	src/game/entity/entityStore.cpp
+	src/game/entity/entityStore.hpp
+	src/game/entity/spatialHash.cpp
+	src/game/entity/spatialHash.hpp
+	src/game/entity/transformSystem.cpp
+	src/game/entity/transformSystem.hpp
 	src/game/gameObject.cpp
 	src/game/gameObject.hpp
+	src/game/gameSession.cpp
+	src/game/gameSession.hpp
+	src/game/physicsObject.cpp
+	src/game/physicsObject.hpp
 
+	src/graphics/bufferHeap.cpp
+	src/graphics/bufferHeap.hpp
+	src/graphics/chunkVisibility.cpp
+	src/graphics/chunkVisibility.hpp
+	src/graphics/commandList.hpp
 	src/graphics/context.cpp
 	src/graphics/context.hpp
+	src/graphics/imageLoader.cpp
+	src/graphics/imageLoader.hpp
+	src/graphics/occlusionBuffer.cpp
+	src/graphics/occlusionBuffer.hpp
+	src/graphics/renderQueue.cpp
+	src/graphics/renderQueue.hpp
 	src/graphics/renderer.cpp
 	src/graphics/renderer.hpp
+	src/graphics/OpenGL/GLBufferHeap.cpp
+	src/graphics/OpenGL/GLBufferHeap.hpp
 	src/graphics/OpenGL/GLContext.cpp
 	src/graphics/OpenGL/GLContext.hpp
 	src/graphics/OpenGL/GLRenderer.cpp
 	src/graphics/OpenGL/GLRenderer.hpp
+	src/graphics/OpenGL/GLShaderManager.cpp
+	src/graphics/OpenGL/GLShaderManager.hpp
+	src/graphics/OpenGL/GLStateCache.cpp
+	src/graphics/OpenGL/GLStateCache.hpp
+	src/graphics/OpenGL/GLTextureUploader.cpp
+	src/graphics/OpenGL/GLTextureUploader.hpp
 
+	src/main/benchmark.cpp
+	src/main/benchmark.hpp
 	src/main/main.cpp
 
 	src/platform/event/eventManager.cpp
@@ -66,6 +124,42 @@ set(VOXEL_SRC
 	src/platform/timer.hpp
 	src/platform/window.cpp
 	src/platform/window.hpp
+
+	src/world/block.hpp
+	src/world/blockBehaviours.cpp
+	src/world/blockBehaviours.hpp
+	src/world/blockMaterials.cpp
+	src/world/blockMaterials.hpp
+	src/world/blockTickScheduler.cpp
+	src/world/blockTickScheduler.hpp
+	src/world/chunk.cpp
+	src/world/chunk.hpp
+	src/world/chunkMesher.cpp
+	src/world/chunkMesher.hpp
+	src/world/chunkPool.cpp
+	src/world/chunkPool.hpp
+	src/world/editLog.cpp
+	src/world/editLog.hpp
+	src/world/fluidSimulation.cpp
+	src/world/fluidSimulation.hpp
+	src/world/lodTerrain.cpp
+	src/world/lodTerrain.hpp
+	src/world/raycast.cpp
+	src/world/raycast.hpp
+	src/world/regionFile.cpp
+	src/world/regionFile.hpp
+	src/world/smoothMesher.cpp
+	src/world/smoothMesher.hpp
+	src/world/smoothTerrain.cpp
+	src/world/smoothTerrain.hpp
+	src/world/structuralIntegrity.cpp
+	src/world/structuralIntegrity.hpp
+	src/world/terrainGenerator.cpp
+	src/world/terrainGenerator.hpp
+	src/world/voxelCollision.cpp
+	src/world/voxelCollision.hpp
+	src/world/world.cpp
+	src/world/world.hpp
 )
 
 if (WIN32)
@@ -100,10 +194,27 @@ if (WIN32)
 		D3D11
 		D3DCompiler
 	)
+else()
+	# The edit log and the thread pool need the platform thread library.
+	find_package(Threads REQUIRED)
+	set (VOXEL_LIBRARIES
+		${VOXEL_LIBRARIES}
+		${CMAKE_THREAD_LIBS_INIT}
+	)
 endif()
 
 add_executable(Voxel ${VOXEL_SRC})
 target_link_libraries(Voxel ${VOXEL_LIBRARIES})
+
+# The renderer loads its shaders and textures from next to the executable.
+add_custom_command(TARGET Voxel POST_BUILD
+	COMMAND ${CMAKE_COMMAND} -E copy_directory ${CMAKE_SOURCE_DIR}/shaders $<TARGET_FILE_DIR:Voxel>/shaders
+)
+if (EXISTS ${CMAKE_SOURCE_DIR}/textures)
+	add_custom_command(TARGET Voxel POST_BUILD
+		COMMAND ${CMAKE_COMMAND} -E copy_directory ${CMAKE_SOURCE_DIR}/textures $<TARGET_FILE_DIR:Voxel>/textures
+	)
+endif()
 include_directories(include ${VOXEL_INCLUDE})
 
 if (APPLE)
@@ -113,10 +224,12 @@ endif()
 # Project solution folders organization
 source_group("core" REGULAR_EXPRESSION core/.*)
 source_group("game" REGULAR_EXPRESSION game/.*)
+source_group("game\\entity" REGULAR_EXPRESSION game/entity/.*)
 source_group("graphics" REGULAR_EXPRESSION graphics/.*)
 source_group("graphics\\D3D11" REGULAR_EXPRESSION graphics/D3D11/.*)
 source_group("graphics\\OpenGL" REGULAR_EXPRESSION graphics/OpenGL/.*)
 source_group("main" REGULAR_EXPRESSION main/.*)
 source_group("platform" REGULAR_EXPRESSION platform/.*)
 source_group("platform\\event" REGULAR_EXPRESSION platform/event/.*)
-source_group("platform\\event\\interface" REGULAR_EXPRESSION platform/event/interface/.*)
\ No newline at end of file
+source_group("platform\\event\\interface" REGULAR_EXPRESSION platform/event/interface/.*)
+source_group("world" REGULAR_EXPRESSION world/.*)
\ No newline at end of file
@@ -0,0 +1,54 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#version 330 core
+
+// x, y, z and face of the packed ChunkVertex.
+layout (location = 0) in uvec4 position;
+layout (location = 1) in uint layer;
+
+uniform mat4 viewProjection;
+// Origin of the chunk in xyz, scale of the vertices of downsampled chunks in w.
+uniform vec4 chunkTransform;
+
+out vec3 fragTexCoord;
+flat out uint fragFace;
+
+void main() {
+	vec3 worldPosition = chunkTransform.xyz + vec3(position.xyz) * chunkTransform.w;
+	gl_Position = viewProjection * vec4(worldPosition, 1);
+
+	// Textures repeat every block, projected along the axis of the face with
+	// the top row of the side textures upwards.
+	uint axis = position.w / 2u;
+	vec2 uv = axis == 0u ? vec2(worldPosition.z, -worldPosition.y) : (axis == 1u ? worldPosition.xz : vec2(worldPosition.x, -worldPosition.y));
+	fragTexCoord = vec3(uv, float(layer));
+	fragFace = position.w;
+}
@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_AABB_HPP_
+#define _CORE_AABB_HPP_
+
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+
+	AABB() {}
+	AABB(const glm::vec3 &minPoint, const glm::vec3 &maxPoint) : min(minPoint), max(maxPoint) {}
+
+	static AABB fromCenter(const glm::vec3 &center, const glm::vec3 &halfExtents) {
+		return AABB(center - halfExtents, center + halfExtents);
+	}
+
+	glm::vec3 getCenter() const {
+		return (min + max) * 0.5f;
+	}
+
+	glm::vec3 getHalfExtents() const {
+		return (max - min) * 0.5f;
+	}
+
+	AABB translate(const glm::vec3 &offset) const {
+		return AABB(min + offset, max + offset);
+	}
+
+	/**
+	 * Grows the box in the direction of motion so that it covers every point
+	 * the box passes through while moving.
+	 */
+	AABB sweep(const glm::vec3 &motion) const {
+		return AABB(glm::min(min, min + motion), glm::max(max, max + motion));
+	}
+
+	bool intersects(const AABB &other) const {
+		return min.x < other.max.x && max.x > other.min.x &&
+		       min.y < other.max.y && max.y > other.min.y &&
+		       min.z < other.max.z && max.z > other.min.z;
+	}
+
+	bool contains(const glm::vec3 &point) const {
+		return point.x >= min.x && point.x <= max.x &&
+		       point.y >= min.y && point.y <= max.y &&
+		       point.z >= min.z && point.z <= max.z;
+	}
+};
+
+#endif // _CORE_AABB_HPP_
@@ -0,0 +1,107 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <assert.h>
+#include <stdio.h>
+#include "core/fixedPool.hpp"
+#include "core/virtualMemory.hpp"
+
+#define POOL_ALIGNMENT 16
+
+FixedPool::FixedPool(size_t elementSize, U32 elementsPerSlab, bool hugePages) {
+	assert(elementsPerSlab > 0);
+
+	mElementSize = (elementSize + POOL_ALIGNMENT - 1) & ~static_cast<size_t>(POOL_ALIGNMENT - 1);
+	if (mElementSize < sizeof(FreeElement))
+		mElementSize = sizeof(FreeElement);
+	mElementsPerSlab = elementsPerSlab;
+	mHugePages = hugePages;
+	mFreeList = nullptr;
+	mUsedCount = 0;
+
+	// Round the slab up to whole pages, and fill the slack with elements.
+	const size_t pageSize = hugePages ? VirtualMemory::getHugePageSize() : VirtualMemory::getPageSize();
+	mSlabSize = (mElementSize * elementsPerSlab + pageSize - 1) / pageSize * pageSize;
+	mElementsPerSlab = static_cast<U32>(mSlabSize / mElementSize);
+}
+
+FixedPool::~FixedPool() {
+	assert(mUsedCount == 0);
+	for (void *slab : mSlabs)
+		VirtualMemory::release(slab, mSlabSize);
+}
+
+void* FixedPool::allocate() {
+	if (mFreeList == nullptr)
+		allocateSlab();
+	if (mFreeList == nullptr)
+		return nullptr;
+
+	FreeElement *element = mFreeList;
+	mFreeList = element->next;
+	++mUsedCount;
+	return element;
+}
+
+void FixedPool::free(void *element) {
+	if (element == nullptr)
+		return;
+
+	assert(mUsedCount > 0);
+	FreeElement *freed = static_cast<FreeElement*>(element);
+	freed->next = mFreeList;
+	mFreeList = freed;
+	--mUsedCount;
+}
+
+void FixedPool::reserve(U32 count) {
+	while (getCapacity() < count) {
+		U32 slabs = getSlabCount();
+		allocateSlab();
+		if (getSlabCount() == slabs)
+			break;
+	}
+}
+
+void FixedPool::allocateSlab() {
+	U8 *slab = static_cast<U8*>(VirtualMemory::allocate(mSlabSize, mHugePages));
+	if (slab == nullptr) {
+		printf("Unable to allocate a %u byte pool slab\n", static_cast<U32>(mSlabSize));
+		return;
+	}
+	mSlabs.push_back(slab);
+
+	// Thread the new elements onto the free list in address order.
+	for (U32 i = mElementsPerSlab; i > 0; --i) {
+		FreeElement *element = reinterpret_cast<FreeElement*>(slab + (i - 1) * mElementSize);
+		element->next = mFreeList;
+		mFreeList = element;
+	}
+}
@@ -0,0 +1,157 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_FIXEDPOOL_HPP_
+#define _CORE_FIXEDPOOL_HPP_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "core/types.hpp"
+
+/**
+ * Pool of equally sized elements carved out of large slabs. Freed elements go
+ * on a free list and are handed out again before a new slab is allocated, so
+ * once the pool has grown to the working set it never touches the heap.
+ * Slabs are only returned to the system when the pool is destroyed.
+ */
+class FixedPool {
+public:
+	/**
+	 * @param elementSize Size of every element, rounded up to 16 bytes.
+	 * @param elementsPerSlab How many elements each slab holds.
+	 * @param hugePages Back the slabs with huge pages where possible.
+	 */
+	FixedPool(size_t elementSize, U32 elementsPerSlab, bool hugePages = false);
+	~FixedPool();
+
+	void* allocate();
+	void free(void *element);
+
+	/**
+	 * Grows the pool until it can hold count elements.
+	 */
+	void reserve(U32 count);
+
+	bool hasFreeElement() const {
+		return mFreeList != nullptr;
+	}
+
+	size_t getElementSize() const {
+		return mElementSize;
+	}
+
+	U32 getUsedCount() const {
+		return mUsedCount;
+	}
+
+	U32 getCapacity() const {
+		return static_cast<U32>(mSlabs.size()) * mElementsPerSlab;
+	}
+
+	/**
+	 * The amount of slabs that have been allocated over the pool's lifetime.
+	 */
+	U32 getSlabCount() const {
+		return static_cast<U32>(mSlabs.size());
+	}
+
+private:
+	struct FreeElement {
+		FreeElement *next;
+	};
+
+	size_t mElementSize;
+	size_t mSlabSize;
+	U32 mElementsPerSlab;
+	bool mHugePages;
+
+	std::vector<void*> mSlabs;
+	FreeElement *mFreeList;
+	U32 mUsedCount;
+
+	void allocateSlab();
+
+	FixedPool(const FixedPool&) = delete;
+	FixedPool& operator=(const FixedPool&) = delete;
+};
+
+/**
+ * Standard library allocator for node based containers. Single element
+ * allocations that fit come from the pool, anything else such as the bucket
+ * array of a hash map goes to the heap.
+ */
+template<typename T>
+class PoolAllocator {
+public:
+	typedef T value_type;
+
+	PoolAllocator(FixedPool &pool) : mPool(&pool) {}
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U> &other) : mPool(other.getPool()) {}
+
+	T* allocate(size_t count) {
+		if (count == 1 && sizeof(T) <= mPool->getElementSize())
+			return static_cast<T*>(mPool->allocate());
+		return static_cast<T*>(::operator new(count * sizeof(T)));
+	}
+
+	void deallocate(T *pointer, size_t count) {
+		if (count == 1 && sizeof(T) <= mPool->getElementSize())
+			mPool->free(pointer);
+		else
+			::operator delete(pointer);
+	}
+
+	FixedPool* getPool() const {
+		return mPool;
+	}
+
+	template<typename U>
+	struct rebind {
+		typedef PoolAllocator<U> other;
+	};
+
+private:
+	FixedPool *mPool;
+};
+
+template<typename T, typename U>
+inline bool operator==(const PoolAllocator<T> &a, const PoolAllocator<U> &b) {
+	return a.getPool() == b.getPool();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const PoolAllocator<T> &a, const PoolAllocator<U> &b) {
+	return a.getPool() != b.getPool();
+}
+
+#endif // _CORE_FIXEDPOOL_HPP_
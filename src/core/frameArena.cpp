@@ -0,0 +1,77 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <assert.h>
+#include <mutex>
+#include "core/frameArena.hpp"
+
+// Arenas live as long as the process, the threads that own them are expected
+// to do so too.
+static LinearArena *sArenas[MAX_FRAME_ARENAS];
+static U32 sArenaCount = 0;
+static std::mutex sArenaMutex;
+static thread_local LinearArena *tArena = nullptr;
+
+#ifndef NDEBUG
+static U32 sReportedOverflows[MAX_FRAME_ARENAS];
+#endif
+
+LinearArena& FrameArena::get() {
+	if (tArena == nullptr) {
+		std::lock_guard<std::mutex> lock(sArenaMutex);
+		assert(sArenaCount < MAX_FRAME_ARENAS);
+		tArena = new LinearArena(FRAME_ARENA_SIZE);
+		sArenas[sArenaCount++] = tArena;
+	}
+	return *tArena;
+}
+
+void FrameArena::beginFrame() {
+	std::lock_guard<std::mutex> lock(sArenaMutex);
+	for (U32 i = 0; i < sArenaCount; ++i) {
+#ifndef NDEBUG
+		// Report every frame that had to fall back to the heap.
+		if (sArenas[i]->getOverflowCount() != sReportedOverflows[i]) {
+			printf("Frame arena %u overflowed its %u bytes, %u bytes were in use\n", i, static_cast<U32>(sArenas[i]->getCapacity()), static_cast<U32>(sArenas[i]->getUsed()));
+			sReportedOverflows[i] = sArenas[i]->getOverflowCount();
+		}
+#endif
+		sArenas[i]->reset();
+	}
+}
+
+void FrameArena::printStats() {
+	std::lock_guard<std::mutex> lock(sArenaMutex);
+	for (U32 i = 0; i < sArenaCount; ++i) {
+		const LinearArena *arena = sArenas[i];
+		printf("Frame arena %u: %u of %u bytes high-water mark, %u heap fallbacks\n", i, static_cast<U32>(arena->getHighWaterMark()), static_cast<U32>(arena->getCapacity()), arena->getOverflowCount());
+	}
+}
@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_FRAMEARENA_HPP_
+#define _CORE_FRAMEARENA_HPP_
+
+#include "core/linearArena.hpp"
+
+/**
+ * Initial size of every thread's frame arena.
+ */
+#define FRAME_ARENA_SIZE (1 << 20)
+
+/**
+ * Maximum amount of threads that can own a frame arena.
+ */
+#define MAX_FRAME_ARENAS 64
+
+/**
+ * Per thread arenas for transient work that only lives until the end of the
+ * frame. Every thread, including the thread pool workers, gets its own arena
+ * so allocating never needs a lock.
+ */
+namespace FrameArena {
+	/**
+	 * Returns the calling thread's arena, creating it on first use.
+	 */
+	LinearArena& get();
+
+	/**
+	 * Resets the arena of every thread. Called by the renderer at the start of
+	 * a frame, when no parallel work is in flight.
+	 */
+	void beginFrame();
+
+	/**
+	 * Prints the high-water mark and heap fallbacks of every arena.
+	 */
+	void printStats();
+}
+
+#endif // _CORE_FRAMEARENA_HPP_
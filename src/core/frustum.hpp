@@ -0,0 +1,78 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_FRUSTUM_HPP_
+#define _CORE_FRUSTUM_HPP_
+
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "core/aabb.hpp"
+
+/**
+ * The six planes of a view frustum, facing inwards, taken from a combined
+ * view projection matrix.
+ */
+struct Frustum {
+	glm::vec4 planes[6];
+
+	Frustum() {}
+
+	explicit Frustum(const glm::mat4 &viewProjection) {
+		// Gribb and Hartmann, on the rows of the matrix.
+		const glm::mat4 m = glm::transpose(viewProjection);
+		planes[0] = m[3] + m[0];
+		planes[1] = m[3] - m[0];
+		planes[2] = m[3] + m[1];
+		planes[3] = m[3] - m[1];
+		planes[4] = m[3] + m[2];
+		planes[5] = m[3] - m[2];
+	}
+
+	/**
+	 * Conservative, a box near a corner of the frustum may be reported as
+	 * intersecting when it's just outside.
+	 */
+	bool intersects(const AABB &box) const {
+		for (U32 i = 0; i < 6; ++i) {
+			// Test the corner of the box furthest along the plane normal.
+			const glm::vec3 normal = glm::vec3(planes[i]);
+			const glm::vec3 corner = glm::vec3(
+				normal.x >= 0.0f ? box.max.x : box.min.x,
+				normal.y >= 0.0f ? box.max.y : box.min.y,
+				normal.z >= 0.0f ? box.max.z : box.min.z
+			);
+			if (glm::dot(normal, corner) + planes[i].w < 0.0f)
+				return false;
+		}
+		return true;
+	}
+};
+
+#endif // _CORE_FRUSTUM_HPP_
@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include "core/linearArena.hpp"
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+LinearArena::LinearArena(size_t capacity) {
+	mBlock = static_cast<U8*>(malloc(capacity));
+	mCapacity = capacity;
+	mOffset = 0;
+	mOverflowBytes = 0;
+	mHighWaterMark = 0;
+	mOverflowCount = 0;
+}
+
+LinearArena::~LinearArena() {
+	reset();
+	free(mBlock);
+}
+
+void* LinearArena::allocate(size_t size, size_t alignment) {
+	assert((alignment & (alignment - 1)) == 0);
+
+	// Align the address rather than the offset as malloc only guarantees
+	// max_align_t alignment for the block itself.
+	uintptr_t base = reinterpret_cast<uintptr_t>(mBlock);
+	size_t start = alignUp(base + mOffset, alignment) - base;
+	void *memory;
+	if (mBlock != nullptr && start + size <= mCapacity) {
+		memory = mBlock + start;
+		mOffset = start + size;
+	} else {
+		U8 *overflow = static_cast<U8*>(malloc(size + alignment));
+		mOverflow.push_back(overflow);
+		mOverflowBytes += size + alignment;
+		++mOverflowCount;
+		memory = overflow + (alignUp(reinterpret_cast<uintptr_t>(overflow), alignment) - reinterpret_cast<uintptr_t>(overflow));
+	}
+
+	if (getUsed() > mHighWaterMark)
+		mHighWaterMark = getUsed();
+	return memory;
+}
+
+void LinearArena::reset() {
+	if (!mOverflow.empty()) {
+		for (void *overflow : mOverflow)
+			free(overflow);
+		mOverflow.clear();
+		mOverflowBytes = 0;
+
+		// Grow to fit everything that was in use at once.
+		size_t capacity = mCapacity > 0 ? mCapacity : 4096;
+		while (capacity < mHighWaterMark)
+			capacity *= 2;
+		free(mBlock);
+		mBlock = static_cast<U8*>(malloc(capacity));
+		mCapacity = capacity;
+	}
+	mOffset = 0;
+}
@@ -0,0 +1,149 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_LINEARARENA_HPP_
+#define _CORE_LINEARARENA_HPP_
+
+#include <cstddef>
+#include <vector>
+#include "core/types.hpp"
+
+/**
+ * Bump allocator for short lived allocations. Allocating is a pointer bump,
+ * individual frees are no-ops and everything is released at once by reset().
+ *
+ * Allocations that don't fit fall back to the heap until the next reset,
+ * which then grows the block to the high-water mark so the same workload fits
+ * from then on without touching the heap.
+ */
+class LinearArena {
+public:
+	LinearArena(size_t capacity);
+	~LinearArena();
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<typename T>
+	T* allocate(size_t count) {
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	void reset();
+
+	/**
+	 * Bytes handed out since the last reset, including heap fallbacks.
+	 */
+	size_t getUsed() const {
+		return mOffset + mOverflowBytes;
+	}
+
+	size_t getCapacity() const {
+		return mCapacity;
+	}
+
+	/**
+	 * The most bytes that were ever in use between two resets.
+	 */
+	size_t getHighWaterMark() const {
+		return mHighWaterMark;
+	}
+
+	/**
+	 * Amount of allocations that had to fall back to the heap.
+	 */
+	U32 getOverflowCount() const {
+		return mOverflowCount;
+	}
+
+private:
+	U8 *mBlock;
+	size_t mCapacity;
+	size_t mOffset;
+
+	std::vector<void*> mOverflow;
+	size_t mOverflowBytes;
+
+	size_t mHighWaterMark;
+	U32 mOverflowCount;
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+};
+
+/**
+ * Standard library allocator that allocates from a LinearArena, so containers
+ * can be used for scratch work without hitting the heap. Memory is only
+ * reclaimed when the arena is reset, the container must not outlive that.
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+
+	ArenaAllocator(LinearArena &arena) : mArena(&arena) {}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : mArena(other.getArena()) {}
+
+	T* allocate(size_t count) {
+		return mArena->allocate<T>(count);
+	}
+
+	void deallocate(T *, size_t) {
+		// Released by the arena reset.
+	}
+
+	LinearArena* getArena() const {
+		return mArena;
+	}
+
+	template<typename U>
+	struct rebind {
+		typedef ArenaAllocator<U> other;
+	};
+
+private:
+	LinearArena *mArena;
+};
+
+template<typename T, typename U>
+inline bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+	return a.getArena() == b.getArena();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+	return a.getArena() != b.getArena();
+}
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif // _CORE_LINEARARENA_HPP_
@@ -0,0 +1,274 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <assert.h>
+#include "core/rangeAllocator.hpp"
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+const U32 RangeAllocator::INVALID_RANGE;
+const U32 RangeAllocator::GRANULARITY;
+
+static U32 findLowestBit(U32 value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return index;
+#else
+	return static_cast<U32>(__builtin_ctz(value));
+#endif
+}
+
+static U32 findHighestBit(U32 value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, value);
+	return index;
+#else
+	return 31 - static_cast<U32>(__builtin_clz(value));
+#endif
+}
+
+RangeAllocator::RangeAllocator(U32 size) {
+	mCapacity = size / GRANULARITY * GRANULARITY;
+	mFreeSize = 0;
+	mFirstLevelMap = 0;
+	for (U32 i = 0; i < RANGE_FL_COUNT; ++i) {
+		mSecondLevelMap[i] = 0;
+		for (U32 j = 0; j < RANGE_SL_COUNT; ++j)
+			mFreeLists[i][j] = INVALID_RANGE;
+	}
+
+	// Start out with a single free range spanning everything.
+	U32 node = createNode();
+	mNodes[node].offset = 0;
+	mNodes[node].size = mCapacity;
+	mLastNode = node;
+	if (mCapacity > 0)
+		insertFree(node);
+}
+
+U32 RangeAllocator::allocate(U32 size) {
+	if (size == 0)
+		size = GRANULARITY;
+	size = (size + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+
+	U32 node = findFree(size);
+	if (node == INVALID_RANGE)
+		return INVALID_RANGE;
+	removeFree(node);
+
+	// Return what we don't need as a new free range right after this one.
+	const U32 remainder = mNodes[node].size - size;
+	if (remainder >= GRANULARITY) {
+		U32 split = createNode();
+		Node &n = mNodes[node];
+		Node &s = mNodes[split];
+		s.offset = n.offset + size;
+		s.size = remainder;
+		s.prevPhysical = node;
+		s.nextPhysical = n.nextPhysical;
+		if (n.nextPhysical != INVALID_RANGE)
+			mNodes[n.nextPhysical].prevPhysical = split;
+		else
+			mLastNode = split;
+		n.nextPhysical = split;
+		n.size = size;
+		insertFree(split);
+	}
+	return node;
+}
+
+void RangeAllocator::free(U32 range) {
+	assert(range < mNodes.size() && !mNodes[range].free);
+
+	// Merge with the free neighbours on either side.
+	U32 node = range;
+	U32 next = mNodes[node].nextPhysical;
+	if (next != INVALID_RANGE && mNodes[next].free) {
+		removeFree(next);
+		mNodes[node].size += mNodes[next].size;
+		mNodes[node].nextPhysical = mNodes[next].nextPhysical;
+		if (mNodes[next].nextPhysical != INVALID_RANGE)
+			mNodes[mNodes[next].nextPhysical].prevPhysical = node;
+		else
+			mLastNode = node;
+		mUnusedNodes.push_back(next);
+	}
+
+	U32 prev = mNodes[node].prevPhysical;
+	if (prev != INVALID_RANGE && mNodes[prev].free) {
+		removeFree(prev);
+		mNodes[prev].size += mNodes[node].size;
+		mNodes[prev].nextPhysical = mNodes[node].nextPhysical;
+		if (mNodes[node].nextPhysical != INVALID_RANGE)
+			mNodes[mNodes[node].nextPhysical].prevPhysical = prev;
+		else
+			mLastNode = prev;
+		mUnusedNodes.push_back(node);
+		node = prev;
+	}
+
+	insertFree(node);
+}
+
+U32 RangeAllocator::getLastRange() const {
+	if (!mNodes[mLastNode].free)
+		return mLastNode;
+	return getPreviousRange(mLastNode);
+}
+
+U32 RangeAllocator::getPreviousRange(U32 range) const {
+	// Free neighbours are always merged, so this skips at most one free range.
+	for (U32 node = mNodes[range].prevPhysical; node != INVALID_RANGE; node = mNodes[node].prevPhysical) {
+		if (!mNodes[node].free)
+			return node;
+	}
+	return INVALID_RANGE;
+}
+
+U32 RangeAllocator::getLargestFreeRange() const {
+	if (mFirstLevelMap == 0)
+		return 0;
+
+	// Every range in the highest non-empty list is within one second level
+	// step of the largest, so only that list has to be walked.
+	const U32 fl = findHighestBit(mFirstLevelMap);
+	const U32 sl = findHighestBit(mSecondLevelMap[fl]);
+	U32 largest = 0;
+	for (U32 node = mFreeLists[fl][sl]; node != INVALID_RANGE; node = mNodes[node].nextFree) {
+		if (mNodes[node].size > largest)
+			largest = mNodes[node].size;
+	}
+	return largest;
+}
+
+F32 RangeAllocator::getFragmentation() const {
+	if (mFreeSize == 0)
+		return 0.0f;
+	return 1.0f - static_cast<F32>(getLargestFreeRange()) / static_cast<F32>(mFreeSize);
+}
+
+U32 RangeAllocator::createNode() {
+	U32 node;
+	if (!mUnusedNodes.empty()) {
+		node = mUnusedNodes.back();
+		mUnusedNodes.pop_back();
+	} else {
+		node = static_cast<U32>(mNodes.size());
+		mNodes.push_back(Node());
+	}
+
+	Node &n = mNodes[node];
+	n.offset = 0;
+	n.size = 0;
+	n.free = false;
+	n.prevPhysical = INVALID_RANGE;
+	n.nextPhysical = INVALID_RANGE;
+	n.prevFree = INVALID_RANGE;
+	n.nextFree = INVALID_RANGE;
+	return node;
+}
+
+void RangeAllocator::insertFree(U32 node) {
+	U32 fl, sl;
+	mapping(mNodes[node].size, fl, sl);
+
+	Node &n = mNodes[node];
+	n.free = true;
+	n.prevFree = INVALID_RANGE;
+	n.nextFree = mFreeLists[fl][sl];
+	if (n.nextFree != INVALID_RANGE)
+		mNodes[n.nextFree].prevFree = node;
+	mFreeLists[fl][sl] = node;
+
+	mFirstLevelMap |= 1U << fl;
+	mSecondLevelMap[fl] |= 1U << sl;
+	mFreeSize += n.size;
+}
+
+void RangeAllocator::removeFree(U32 node) {
+	U32 fl, sl;
+	mapping(mNodes[node].size, fl, sl);
+
+	Node &n = mNodes[node];
+	if (n.prevFree != INVALID_RANGE)
+		mNodes[n.prevFree].nextFree = n.nextFree;
+	else
+		mFreeLists[fl][sl] = n.nextFree;
+	if (n.nextFree != INVALID_RANGE)
+		mNodes[n.nextFree].prevFree = n.prevFree;
+
+	if (mFreeLists[fl][sl] == INVALID_RANGE) {
+		mSecondLevelMap[fl] &= ~(1U << sl);
+		if (mSecondLevelMap[fl] == 0)
+			mFirstLevelMap &= ~(1U << fl);
+	}
+
+	n.free = false;
+	mFreeSize -= n.size;
+}
+
+U32 RangeAllocator::findFree(U32 size) const {
+	// Round the size up to the next list so that any range in the list found
+	// is large enough, without having to search it.
+	U32 search = size;
+	const U32 fl0 = findHighestBit(size);
+	if (fl0 >= RANGE_SL_BITS) {
+		const U32 round = (1U << (fl0 - RANGE_SL_BITS)) - 1;
+		if (search > 0xFFFFFFFF - round)
+			return INVALID_RANGE;
+		search += round;
+	}
+
+	U32 fl, sl;
+	mapping(search, fl, sl);
+
+	U32 slMap = mSecondLevelMap[fl] & (~0U << sl);
+	if (slMap == 0) {
+		if (fl + 1 >= RANGE_FL_COUNT)
+			return INVALID_RANGE;
+		const U32 flMap = mFirstLevelMap & (~0U << (fl + 1));
+		if (flMap == 0)
+			return INVALID_RANGE;
+		fl = findLowestBit(flMap);
+		slMap = mSecondLevelMap[fl];
+	}
+	sl = findLowestBit(slMap);
+	return mFreeLists[fl][sl];
+}
+
+void RangeAllocator::mapping(U32 size, U32 &fl, U32 &sl) {
+	// Sizes are at least GRANULARITY, which is 1 << RANGE_SL_BITS.
+	fl = findHighestBit(size);
+	sl = (size >> (fl - RANGE_SL_BITS)) ^ (1U << RANGE_SL_BITS);
+}
@@ -0,0 +1,134 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_RANGEALLOCATOR_HPP_
+#define _CORE_RANGEALLOCATOR_HPP_
+
+#include <vector>
+#include "core/types.hpp"
+
+#define RANGE_FL_COUNT 32
+#define RANGE_SL_BITS 4
+#define RANGE_SL_COUNT (1 << RANGE_SL_BITS)
+
+/**
+ * Two level segregated fit (TLSF) allocator over an abstract range of bytes,
+ * for sub-allocating memory the allocator can't touch itself such as GPU
+ * buffers. Allocation and free are O(1): free ranges are kept in lists
+ * bucketed by size, and a free range is merged with free neighbours straight
+ * away.
+ */
+class RangeAllocator {
+public:
+	static const U32 INVALID_RANGE = 0xFFFFFFFF;
+
+	/**
+	 * Every range is a multiple of this many bytes and aligned to it.
+	 */
+	static const U32 GRANULARITY = 16;
+
+	RangeAllocator(U32 size);
+
+	/**
+	 * Returns a handle of the allocated range, or INVALID_RANGE if there is no
+	 * free range large enough.
+	 */
+	U32 allocate(U32 size);
+	void free(U32 range);
+
+	U32 getOffset(U32 range) const {
+		return mNodes[range].offset;
+	}
+
+	U32 getSize(U32 range) const {
+		return mNodes[range].size;
+	}
+
+	/**
+	 * Returns the allocated range that ends last, or INVALID_RANGE when empty.
+	 */
+	U32 getLastRange() const;
+
+	/**
+	 * Returns the allocated range before range in address order, or
+	 * INVALID_RANGE if there is none.
+	 */
+	U32 getPreviousRange(U32 range) const;
+
+	U32 getCapacity() const {
+		return mCapacity;
+	}
+
+	U32 getFreeSize() const {
+		return mFreeSize;
+	}
+
+	U32 getLargestFreeRange() const;
+
+	/**
+	 * 0 when all free space is one contiguous range, approaching 1 the more
+	 * it is split up.
+	 */
+	F32 getFragmentation() const;
+
+private:
+	struct Node {
+		U32 offset;
+		U32 size;
+		bool free;
+
+		// Neighbouring ranges in address order.
+		U32 prevPhysical;
+		U32 nextPhysical;
+
+		// Links of the free list the range is in.
+		U32 prevFree;
+		U32 nextFree;
+	};
+
+	std::vector<Node> mNodes;
+	std::vector<U32> mUnusedNodes;
+	U32 mCapacity;
+	U32 mFreeSize;
+	U32 mLastNode;
+
+	U32 mFirstLevelMap;
+	U32 mSecondLevelMap[RANGE_FL_COUNT];
+	U32 mFreeLists[RANGE_FL_COUNT][RANGE_SL_COUNT];
+
+	U32 createNode();
+	void insertFree(U32 node);
+	void removeFree(U32 node);
+	U32 findFree(U32 size) const;
+
+	static void mapping(U32 size, U32 &fl, U32 &sl);
+};
+
+#endif // _CORE_RANGEALLOCATOR_HPP_
@@ -0,0 +1,98 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_SPSCQUEUE_HPP_
+#define _CORE_SPSCQUEUE_HPP_
+
+#include <assert.h>
+#include <atomic>
+#include <vector>
+#include "core/types.hpp"
+
+/**
+ * Bounded lock free ring buffer for exactly one producer thread and one
+ * consumer thread. The capacity must be a power of two.
+ */
+template<typename T>
+class SPSCQueue {
+public:
+	SPSCQueue(U32 capacity) : mBuffer(capacity), mMask(capacity - 1), mHead(0), mTail(0) {
+		assert((capacity & (capacity - 1)) == 0);
+	}
+
+	/**
+	 * Called by the producer. Returns false if the queue is full.
+	 */
+	bool push(const T &value) {
+		U32 tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mHead.load(std::memory_order_acquire) > mMask)
+			return false;
+
+		mBuffer[tail & mMask] = value;
+		mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Called by the consumer. Returns false if the queue is empty.
+	 */
+	bool pop(T &value) {
+		U32 head = mHead.load(std::memory_order_relaxed);
+		if (head == mTail.load(std::memory_order_acquire))
+			return false;
+
+		value = mBuffer[head & mMask];
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Called by the consumer. The producer may have pushed more by the time
+	 * this returns, never less.
+	 */
+	U32 getSize() const {
+		return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_relaxed);
+	}
+
+	bool isEmpty() const {
+		return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::vector<T> mBuffer;
+	const U32 mMask;
+
+	// Keep the indices on separate cache lines so the two threads don't
+	// fight over the same line.
+	alignas(64) std::atomic<U32> mHead;
+	alignas(64) std::atomic<U32> mTail;
+};
+
+#endif // _CORE_SPSCQUEUE_HPP_
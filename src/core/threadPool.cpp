@@ -0,0 +1,155 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "core/threadPool.hpp"
+
+ThreadPool gThreadPool;
+
+static thread_local bool sIsWorkerThread = false;
+
+ThreadPool::ThreadPool() {
+	mJob = nullptr;
+	mJobGeneration = 0;
+	mQuit = false;
+}
+
+ThreadPool::~ThreadPool() {
+	shutdown();
+}
+
+void ThreadPool::init(U32 workerCount) {
+	shutdown();
+
+	if (workerCount == 0) {
+		U32 hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	mQuit = false;
+	for (U32 i = 0; i < workerCount; ++i)
+		mWorkers.push_back(std::thread(&ThreadPool::workerThread, this));
+}
+
+void ThreadPool::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWorkCondition.notify_all();
+
+	for (std::thread &worker : mWorkers)
+		worker.join();
+	mWorkers.clear();
+}
+
+void ThreadPool::parallelFor(U32 count, U32 batchSize, const RangeFunction &fn) {
+	if (count == 0)
+		return;
+	if (batchSize == 0)
+		batchSize = 1;
+
+	if (mWorkers.empty() || sIsWorkerThread || count <= batchSize) {
+		fn(0, count);
+		return;
+	}
+
+	// Only one job is in flight at a time.
+	std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
+
+	Job job;
+	job.fn = &fn;
+	job.count = count;
+	job.batchSize = batchSize;
+	job.next = 0;
+	job.remaining = (count + batchSize - 1) / batchSize;
+	job.workers = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJob = &job;
+		++mJobGeneration;
+	}
+	mWorkCondition.notify_all();
+
+	runBatches(&job);
+
+	// Wait for the batches that the workers picked up to finish.
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDoneCondition.wait(lock, [&job]() {
+		return job.remaining.load() == 0 && job.workers == 0;
+	});
+	mJob = nullptr;
+}
+
+void ThreadPool::runBatches(Job *job) {
+	for (;;) {
+		U32 start = job->next.fetch_add(job->batchSize);
+		if (start >= job->count)
+			break;
+
+		U32 end = start + job->batchSize;
+		if (end > job->count)
+			end = job->count;
+		(*job->fn)(start, end);
+
+		if (job->remaining.fetch_sub(1) == 1) {
+			// Take the lock so the notify can't slip in between the dispatching
+			// thread testing the predicate and going to sleep.
+			std::lock_guard<std::mutex> lock(mMutex);
+			mDoneCondition.notify_all();
+		}
+	}
+}
+
+void ThreadPool::workerThread() {
+	sIsWorkerThread = true;
+
+	U64 generation = 0;
+	for (;;) {
+		Job *job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkCondition.wait(lock, [this, generation]() {
+				return mQuit || (mJob != nullptr && mJobGeneration != generation);
+			});
+			if (mQuit)
+				break;
+
+			job = mJob;
+			generation = mJobGeneration;
+			++job->workers;
+		}
+		runBatches(job);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (--job->workers == 0)
+			mDoneCondition.notify_all();
+	}
+}
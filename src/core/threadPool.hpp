@@ -0,0 +1,103 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _CORE_THREADPOOL_HPP_
+#define _CORE_THREADPOOL_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include "core/types.hpp"
+
+/**
+ * A fixed set of worker threads used to split data parallel work such as
+ * batched ray casts across every core.
+ */
+class ThreadPool {
+public:
+	typedef std::function<void(U32 start, U32 end)> RangeFunction;
+
+	ThreadPool();
+	~ThreadPool();
+
+	/**
+	 * Starts the worker threads. A worker count of 0 uses one worker per
+	 * hardware thread, minus the calling thread.
+	 */
+	void init(U32 workerCount = 0);
+	void shutdown();
+
+	U32 getWorkerCount() const {
+		return static_cast<U32>(mWorkers.size());
+	}
+
+	/**
+	 * Calls fn over [0, count) split into ranges of at most batchSize, spread
+	 * across the workers and the calling thread. Blocks until every range has
+	 * been processed. Runs inline when there are no workers or when called
+	 * from a worker thread.
+	 */
+	void parallelFor(U32 count, U32 batchSize, const RangeFunction &fn);
+
+private:
+	struct Job {
+		const RangeFunction *fn;
+		U32 count;
+		U32 batchSize;
+		std::atomic<U32> next;
+		std::atomic<U32> remaining;
+
+		/**
+		 * Workers that hold a pointer to the job, guarded by mMutex. The job
+		 * lives on the dispatching thread's stack so it can't return before
+		 * this drops to zero.
+		 */
+		U32 workers;
+	};
+
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mWorkCondition;
+	std::condition_variable mDoneCondition;
+	std::mutex mDispatchMutex;
+	Job *mJob;
+	U64 mJobGeneration;
+	bool mQuit;
+
+	void workerThread();
+	void runBatches(Job *job);
+};
+
+extern ThreadPool gThreadPool;
+
+#endif // _CORE_THREADPOOL_HPP_
@@ -0,0 +1,65 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "game/blockPicker.hpp"
+#include "game/camera.hpp"
+#include "world/raycast.hpp"
+#include "world/world.hpp"
+
+// Furthest block the crosshair reaches, in blocks.
+#define BLOCK_PICK_DISTANCE 8.0f
+
+BlockPicker::BlockPicker(World *world, Camera *camera) {
+	mWorld = world;
+	mCamera = camera;
+	mPlaceBlock = BlockType::STONE;
+}
+
+void BlockPicker::processMouseButton(const MouseButtonEvent &e) {
+	if (!e.isPressedDown)
+		return;
+
+	RaycastHit hit;
+	if (!Raycast::castRay(mWorld, mCamera->getPosition(), mCamera->getFrontVector(), BLOCK_PICK_DISTANCE, hit))
+		return;
+
+	if (e.leftClick) {
+		mWorld->setBlock(hit.position, BlockType::AIR);
+	} else if (e.rightClick) {
+		// Can't place a block if we are standing inside of the hit block.
+		if (hit.normal == glm::ivec3(0))
+			return;
+		mWorld->setBlock(hit.position + hit.normal, mPlaceBlock);
+	}
+}
+
+void BlockPicker::setPlaceBlock(BlockID block) {
+	mPlaceBlock = block;
+}
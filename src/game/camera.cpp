@@ -54,8 +54,20 @@ glm::vec3 Camera::getUpVector() const {
 }
 
 void Camera::processMouseMovement(const MouseMovementEvent &e) {
-	mYaw += e.mouseDelta.x * MOUSE_SENSATIVITY;
-	mPitch += e.mouseDelta.y * MOUSE_SENSATIVITY;
+	rotate(e.mouseDelta);
+}
+
+void Camera::processMouseMovements(const MouseMovementEvent *events, U32 count) {
+	// Only the summed delta matters, so rebuild the front vector once.
+	glm::vec2 mouseDelta(0.0f);
+	for (U32 i = 0; i < count; ++i)
+		mouseDelta += events[i].mouseDelta;
+	rotate(mouseDelta);
+}
+
+void Camera::rotate(const glm::vec2 &mouseDelta) {
+	mYaw += mouseDelta.x * MOUSE_SENSATIVITY;
+	mPitch += mouseDelta.y * MOUSE_SENSATIVITY;
 	
 	// Cap pitch
 	mPitch = glm::clamp(mPitch, -89.999f, 89.999f);
@@ -43,6 +43,7 @@ public:
 	Camera();
 	
 	virtual void processMouseMovement(const MouseMovementEvent &e) override;
+	virtual void processMouseMovements(const MouseMovementEvent *events, U32 count) override;
 	virtual void processKeyboard(const KeyboardEvent &e) override;
 	
 	void getYawPitch(float &yaw, float &pitch) const;
@@ -65,6 +66,8 @@ private:
 	
 	glm::vec3 mFrontVector;
 	glm::vec3 mUpVector;
+
+	void rotate(const glm::vec2 &mouseDelta);
 };
 
 #endif // _GAME_CAMERA_HPP_
\ No newline at end of file
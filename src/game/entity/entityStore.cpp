@@ -0,0 +1,157 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <assert.h>
+#include "game/entity/entityStore.hpp"
+
+const U32 EntityStore::INVALID_SLOT;
+
+Entity EntityStore::create() {
+	Entity entity;
+	if (mFreeIndices.empty()) {
+		entity.index = static_cast<U32>(mSlots.size());
+		entity.generation = 0;
+		mSlots.push_back(INVALID_SLOT);
+		mGenerations.push_back(0);
+	} else {
+		entity.index = mFreeIndices.back();
+		entity.generation = mGenerations[entity.index];
+		mFreeIndices.pop_back();
+	}
+
+	mSlots[entity.index] = static_cast<U32>(mEntities.size());
+	mEntities.push_back(entity.index);
+
+	for (U32 i = 0; i < FIELD_COUNT; ++i)
+		mFields[i].push_back(0.0f);
+	mFields[ROTATION_W].back() = 1.0f;
+	mFields[SCALE_X].back() = 1.0f;
+	mFields[SCALE_Y].back() = 1.0f;
+	mFields[SCALE_Z].back() = 1.0f;
+	mFlags.push_back(0);
+
+	return entity;
+}
+
+void EntityStore::destroy(const Entity &entity) {
+	U32 slot = getSlot(entity);
+	assert(slot != INVALID_SLOT);
+	if (slot == INVALID_SLOT)
+		return;
+
+	// Move the last entity into the hole to keep the arrays dense.
+	U32 last = static_cast<U32>(mEntities.size()) - 1;
+	if (slot != last) {
+		for (U32 i = 0; i < FIELD_COUNT; ++i)
+			mFields[i][slot] = mFields[i][last];
+		mFlags[slot] = mFlags[last];
+		mEntities[slot] = mEntities[last];
+		mSlots[mEntities[slot]] = slot;
+	}
+
+	for (U32 i = 0; i < FIELD_COUNT; ++i)
+		mFields[i].pop_back();
+	mFlags.pop_back();
+	mEntities.pop_back();
+
+	mSlots[entity.index] = INVALID_SLOT;
+	++mGenerations[entity.index];
+	mFreeIndices.push_back(entity.index);
+}
+
+bool EntityStore::isAlive(const Entity &entity) const {
+	return getSlot(entity) != INVALID_SLOT;
+}
+
+U32 EntityStore::getSlot(const Entity &entity) const {
+	if (entity.index >= mSlots.size() || mGenerations[entity.index] != entity.generation)
+		return INVALID_SLOT;
+	return mSlots[entity.index];
+}
+
+Entity EntityStore::getEntity(U32 slot) const {
+	Entity entity;
+	entity.index = mEntities[slot];
+	entity.generation = mGenerations[entity.index];
+	return entity;
+}
+
+void EntityStore::setVector(const Entity &entity, Field first, const glm::vec3 &value) {
+	U32 slot = getSlot(entity);
+	assert(slot != INVALID_SLOT);
+	mFields[first + 0][slot] = value.x;
+	mFields[first + 1][slot] = value.y;
+	mFields[first + 2][slot] = value.z;
+}
+
+glm::vec3 EntityStore::getVector(const Entity &entity, Field first) const {
+	U32 slot = getSlot(entity);
+	assert(slot != INVALID_SLOT);
+	return glm::vec3(mFields[first + 0][slot], mFields[first + 1][slot], mFields[first + 2][slot]);
+}
+
+void EntityStore::setPosition(const Entity &entity, const glm::vec3 &position) {
+	setVector(entity, POSITION_X, position);
+}
+
+glm::vec3 EntityStore::getPosition(const Entity &entity) const {
+	return getVector(entity, POSITION_X);
+}
+
+void EntityStore::setVelocity(const Entity &entity, const glm::vec3 &velocity) {
+	setVector(entity, VELOCITY_X, velocity);
+}
+
+glm::vec3 EntityStore::getVelocity(const Entity &entity) const {
+	return getVector(entity, VELOCITY_X);
+}
+
+void EntityStore::setRotation(const Entity &entity, const glm::quat &rotation) {
+	U32 slot = getSlot(entity);
+	assert(slot != INVALID_SLOT);
+	mFields[ROTATION_X][slot] = rotation.x;
+	mFields[ROTATION_Y][slot] = rotation.y;
+	mFields[ROTATION_Z][slot] = rotation.z;
+	mFields[ROTATION_W][slot] = rotation.w;
+}
+
+glm::quat EntityStore::getRotation(const Entity &entity) const {
+	U32 slot = getSlot(entity);
+	assert(slot != INVALID_SLOT);
+	return glm::quat(mFields[ROTATION_W][slot], mFields[ROTATION_X][slot], mFields[ROTATION_Y][slot], mFields[ROTATION_Z][slot]);
+}
+
+void EntityStore::setScale(const Entity &entity, const glm::vec3 &scale) {
+	setVector(entity, SCALE_X, scale);
+}
+
+glm::vec3 EntityStore::getScale(const Entity &entity) const {
+	return getVector(entity, SCALE_X);
+}
@@ -0,0 +1,149 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GAME_ENTITY_ENTITYSTORE_HPP_
+#define _GAME_ENTITY_ENTITYSTORE_HPP_
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "core/types.hpp"
+
+/**
+ * A stable handle to an entity. The generation is bumped every time an index
+ * is recycled, so handles to destroyed entities are detected instead of
+ * silently referring to whatever reused the slot.
+ */
+struct Entity {
+	U32 index;
+	U32 generation;
+
+	bool operator==(const Entity &other) const {
+		return index == other.index && generation == other.generation;
+	}
+
+	bool operator!=(const Entity &other) const {
+		return !(*this == other);
+	}
+};
+
+/**
+ * Stores entities as structure of arrays. Every component field lives in its
+ * own tightly packed array indexed by the entity's dense slot, so systems can
+ * stream over exactly the data they touch. Destroying an entity moves the last
+ * entity into its slot, keeping the arrays dense; handles stay valid since
+ * they go through the sparse index table.
+ */
+class EntityStore {
+public:
+	enum Field : U32 {
+		POSITION_X,
+		POSITION_Y,
+		POSITION_Z,
+		VELOCITY_X,
+		VELOCITY_Y,
+		VELOCITY_Z,
+		ROTATION_X,
+		ROTATION_Y,
+		ROTATION_Z,
+		ROTATION_W,
+		SCALE_X,
+		SCALE_Y,
+		SCALE_Z,
+
+		FIELD_COUNT
+	};
+
+	static const U32 INVALID_SLOT = 0xFFFFFFFF;
+
+	Entity create();
+	void destroy(const Entity &entity);
+	bool isAlive(const Entity &entity) const;
+
+	U32 getCount() const {
+		return static_cast<U32>(mEntities.size());
+	}
+
+	/**
+	 * The dense slot of the entity, INVALID_SLOT if the handle is stale. Slots
+	 * change when other entities are destroyed, don't hold on to them.
+	 */
+	U32 getSlot(const Entity &entity) const;
+	Entity getEntity(U32 slot) const;
+
+	F32* getField(Field field) {
+		return mFields[field].data();
+	}
+
+	const F32* getField(Field field) const {
+		return mFields[field].data();
+	}
+
+	/**
+	 * Per entity bit mask of game defined flags, e.g. which systems should
+	 * process the entity.
+	 */
+	U32* getFlags() {
+		return mFlags.data();
+	}
+
+	const U32* getFlags() const {
+		return mFlags.data();
+	}
+
+	void setPosition(const Entity &entity, const glm::vec3 &position);
+	glm::vec3 getPosition(const Entity &entity) const;
+
+	void setVelocity(const Entity &entity, const glm::vec3 &velocity);
+	glm::vec3 getVelocity(const Entity &entity) const;
+
+	void setRotation(const Entity &entity, const glm::quat &rotation);
+	glm::quat getRotation(const Entity &entity) const;
+
+	void setScale(const Entity &entity, const glm::vec3 &scale);
+	glm::vec3 getScale(const Entity &entity) const;
+
+private:
+	std::vector<F32> mFields[FIELD_COUNT];
+	std::vector<U32> mFlags;
+
+	// Dense slot -> entity index.
+	std::vector<U32> mEntities;
+
+	// Entity index -> dense slot and current generation.
+	std::vector<U32> mSlots;
+	std::vector<U32> mGenerations;
+	std::vector<U32> mFreeIndices;
+
+	void setVector(const Entity &entity, Field first, const glm::vec3 &value);
+	glm::vec3 getVector(const Entity &entity, Field first) const;
+};
+
+#endif // _GAME_ENTITY_ENTITYSTORE_HPP_
@@ -0,0 +1,170 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include "game/entity/entityStore.hpp"
+#include "game/entity/spatialHash.hpp"
+
+SpatialHash::SpatialHash(F32 cellSize) {
+	mCellSize = cellSize;
+	mInverseCellSize = 1.0f / cellSize;
+	mFrame = 0;
+	mRebinCount = 0;
+}
+
+glm::ivec3 SpatialHash::getCell(const glm::vec3 &position) const {
+	return glm::ivec3(glm::floor(position * mInverseCellSize));
+}
+
+U64 SpatialHash::getKey(const glm::ivec3 &cell) {
+	// 21 bits per axis covers +-1 million cells.
+	const U64 mask = (static_cast<U64>(1) << 21) - 1;
+	return (static_cast<U64>(cell.x) & mask) | ((static_cast<U64>(cell.y) & mask) << 21) | ((static_cast<U64>(cell.z) & mask) << 42);
+}
+
+void SpatialHash::insert(U32 entity, U64 key, const Entry &entry) {
+	std::vector<Entry> &cell = mCells[key];
+	Tracking &tracking = mTracking[entity];
+	tracking.key = key;
+	tracking.cell = &cell;
+	tracking.position = static_cast<U32>(cell.size());
+	tracking.present = true;
+	cell.push_back(entry);
+}
+
+void SpatialHash::remove(U32 entity) {
+	Tracking &tracking = mTracking[entity];
+	std::vector<Entry> &cell = *tracking.cell;
+
+	// Swap the last entry of the cell into the hole.
+	if (tracking.position != cell.size() - 1) {
+		cell[tracking.position] = cell.back();
+		mTracking[cell[tracking.position].entity].position = tracking.position;
+	}
+	cell.pop_back();
+	tracking.present = false;
+}
+
+void SpatialHash::update(const EntityStore &store) {
+	++mFrame;
+	mRebinCount = 0;
+
+	const F32 *positionX = store.getField(EntityStore::POSITION_X);
+	const F32 *positionY = store.getField(EntityStore::POSITION_Y);
+	const F32 *positionZ = store.getField(EntityStore::POSITION_Z);
+
+	const U32 count = store.getCount();
+	for (U32 slot = 0; slot < count; ++slot) {
+		U32 entity = store.getEntity(slot).index;
+		if (entity >= mTracking.size()) {
+			Tracking empty;
+			empty.key = 0;
+			empty.cell = nullptr;
+			empty.position = 0;
+			empty.frame = 0;
+			empty.present = false;
+			mTracking.resize(entity + 1, empty);
+		}
+
+		Entry entry;
+		entry.entity = entity;
+		entry.x = positionX[slot];
+		entry.y = positionY[slot];
+		entry.z = positionZ[slot];
+		U64 key = getKey(getCell(glm::vec3(entry.x, entry.y, entry.z)));
+
+		Tracking &tracking = mTracking[entity];
+		tracking.frame = mFrame;
+		if (tracking.present && tracking.key == key) {
+			(*tracking.cell)[tracking.position] = entry;
+			continue;
+		}
+
+		if (tracking.present) {
+			remove(entity);
+			++mRebinCount;
+		}
+		insert(entity, key, entry);
+	}
+
+	// Anything we didn't see this frame has been destroyed.
+	for (U32 entity = 0; entity < mTracking.size(); ++entity) {
+		if (mTracking[entity].present && mTracking[entity].frame != mFrame)
+			remove(entity);
+	}
+}
+
+U32 SpatialHash::queryRadius(const glm::vec3 &center, F32 radius, std::vector<U32> &out) const {
+	const size_t start = out.size();
+	const F32 radiusSquared = radius * radius;
+	const glm::ivec3 minCell = getCell(center - glm::vec3(radius));
+	const glm::ivec3 maxCell = getCell(center + glm::vec3(radius));
+
+	for (S32 z = minCell.z; z <= maxCell.z; ++z) {
+		for (S32 y = minCell.y; y <= maxCell.y; ++y) {
+			for (S32 x = minCell.x; x <= maxCell.x; ++x) {
+				auto pos = mCells.find(getKey(glm::ivec3(x, y, z)));
+				if (pos == mCells.end())
+					continue;
+
+				for (const Entry &entry : pos->second) {
+					F32 dx = entry.x - center.x;
+					F32 dy = entry.y - center.y;
+					F32 dz = entry.z - center.z;
+					if (dx * dx + dy * dy + dz * dz <= radiusSquared)
+						out.push_back(entry.entity);
+				}
+			}
+		}
+	}
+	return static_cast<U32>(out.size() - start);
+}
+
+U32 SpatialHash::queryAABB(const AABB &box, std::vector<U32> &out) const {
+	const size_t start = out.size();
+	const glm::ivec3 minCell = getCell(box.min);
+	const glm::ivec3 maxCell = getCell(box.max);
+
+	for (S32 z = minCell.z; z <= maxCell.z; ++z) {
+		for (S32 y = minCell.y; y <= maxCell.y; ++y) {
+			for (S32 x = minCell.x; x <= maxCell.x; ++x) {
+				auto pos = mCells.find(getKey(glm::ivec3(x, y, z)));
+				if (pos == mCells.end())
+					continue;
+
+				for (const Entry &entry : pos->second) {
+					if (box.contains(glm::vec3(entry.x, entry.y, entry.z)))
+						out.push_back(entry.entity);
+				}
+			}
+		}
+	}
+	return static_cast<U32>(out.size() - start);
+}
@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GAME_ENTITY_SPATIALHASH_HPP_
+#define _GAME_ENTITY_SPATIALHASH_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "core/aabb.hpp"
+#include "core/types.hpp"
+
+class EntityStore;
+
+/**
+ * Uniform grid over the entity positions for proximity queries such as
+ * collision broad phase, network interest management and AI perception.
+ *
+ * Every cell keeps a packed list of the entities inside of it along with a
+ * copy of their positions, so a query only touches the memory of the cells it
+ * overlaps. update() re-bins incrementally: only entities that crossed into
+ * another cell are moved between lists.
+ */
+class SpatialHash {
+public:
+	SpatialHash(F32 cellSize);
+
+	/**
+	 * Syncs the grid with the store. New entities are inserted, destroyed
+	 * ones removed and moved ones re-binned.
+	 */
+	void update(const EntityStore &store);
+
+	/**
+	 * Appends the index of every entity within radius of center to out and
+	 * returns how many were added. The results are contiguous in out starting
+	 * at its size before the call.
+	 */
+	U32 queryRadius(const glm::vec3 &center, F32 radius, std::vector<U32> &out) const;
+
+	/**
+	 * Appends the index of every entity whose position lies inside box.
+	 */
+	U32 queryAABB(const AABB &box, std::vector<U32> &out) const;
+
+	U32 getCellCount() const {
+		return static_cast<U32>(mCells.size());
+	}
+
+	/**
+	 * How many entities changed cells during the last update.
+	 */
+	U32 getRebinCount() const {
+		return mRebinCount;
+	}
+
+private:
+	struct Entry {
+		U32 entity;
+		F32 x;
+		F32 y;
+		F32 z;
+	};
+
+	struct Tracking {
+		U64 key;
+
+		/**
+		 * Cells are never erased and references into an unordered_map
+		 * survive rehashing, so this saves a lookup per entity per update.
+		 */
+		std::vector<Entry> *cell;
+		U32 position;
+		U32 frame;
+		bool present;
+	};
+
+	F32 mCellSize;
+	F32 mInverseCellSize;
+	U32 mFrame;
+	U32 mRebinCount;
+
+	std::unordered_map<U64, std::vector<Entry>> mCells;
+
+	// Indexed by entity index.
+	std::vector<Tracking> mTracking;
+
+	glm::ivec3 getCell(const glm::vec3 &position) const;
+	static U64 getKey(const glm::ivec3 &cell);
+
+	void insert(U32 entity, U64 key, const Entry &entry);
+	void remove(U32 entity);
+};
+
+#endif // _GAME_ENTITY_SPATIALHASH_HPP_
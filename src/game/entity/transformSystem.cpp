@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "core/simd.hpp"
+#include "core/threadPool.hpp"
+#include "game/entity/entityStore.hpp"
+#include "game/entity/transformSystem.hpp"
+
+// Entities per worker batch. Big enough that the threading overhead
+// disappears next to streaming the arrays.
+#define TRANSFORM_BATCH_SIZE 16384
+
+static void integrateAxis(F32 *position, const F32 *velocity, F32 dt, U32 start, U32 end) {
+	U32 i = start;
+#if VOXEL_SSE
+	const __m128 delta = _mm_set1_ps(dt);
+	for (; i + 4 <= end; i += 4) {
+		__m128 p = _mm_loadu_ps(position + i);
+		__m128 v = _mm_loadu_ps(velocity + i);
+		_mm_storeu_ps(position + i, _mm_add_ps(p, _mm_mul_ps(v, delta)));
+	}
+#endif
+	for (; i < end; ++i)
+		position[i] += velocity[i] * dt;
+}
+
+void TransformSystem::integrate(EntityStore &store, const F64 &delta) {
+	const F32 dt = static_cast<F32>(delta);
+	F32 *position[3] = {
+		store.getField(EntityStore::POSITION_X),
+		store.getField(EntityStore::POSITION_Y),
+		store.getField(EntityStore::POSITION_Z)
+	};
+	const F32 *velocity[3] = {
+		store.getField(EntityStore::VELOCITY_X),
+		store.getField(EntityStore::VELOCITY_Y),
+		store.getField(EntityStore::VELOCITY_Z)
+	};
+
+	gThreadPool.parallelFor(store.getCount(), TRANSFORM_BATCH_SIZE, [&position, &velocity, dt](U32 start, U32 end) {
+		for (U32 axis = 0; axis < 3; ++axis)
+			integrateAxis(position[axis], velocity[axis], dt, start, end);
+	});
+}
@@ -38,6 +38,7 @@
 class GameObject {
 public:
 	GameObject();
+	virtual ~GameObject() {}
 	
 	void setPosition(const glm::vec3 &pos);
 	glm::vec3 getPosition() const;
@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "game/gameSession.hpp"
+#include "game/entity/transformSystem.hpp"
+
+// Most chunks remeshed per frame.
+#define MESH_BUDGET 32
+#define LOD_BUDGET 4
+
+// Loaded chunks around the spawn, a multiple of the coarsest voxel LOD node so
+// the smooth terrain meets the voxel terrain without gaps.
+#define LOAD_RADIUS 16
+#define LOAD_HEIGHT 4
+
+// How far a flyover draws the smooth terrain beyond the loaded chunks.
+#define FLYOVER_VIEW_DISTANCE 2048.0f
+
+GameSession::GameSession(const std::string &savePath, bool hugePages, bool flyover) :
+	mGenerator(0),
+	mWorld(savePath, hugePages),
+	mPicker(&mWorld, &mCamera),
+	mEntityHash(static_cast<F32>(CHUNK_SIZE)) {
+	mCamera.setPosition(glm::vec3(3.0f, 48.0f, -3.0f));
+
+	mWorld.setTerrainGenerator(&mGenerator);
+	if (flyover)
+		mWorld.setSmoothTerrainDistance(FLYOVER_VIEW_DISTANCE);
+	if (!savePath.empty() && mEditLog.open(savePath)) {
+		mEditLog.replay(&mWorld);
+		mWorld.setEditLog(&mEditLog);
+	}
+
+	for (S32 y = 0; y < LOAD_HEIGHT; ++y) {
+		for (S32 z = -LOAD_RADIUS; z < LOAD_RADIUS; ++z) {
+			for (S32 x = -LOAD_RADIUS; x < LOAD_RADIUS; ++x) {
+				mWorld.createChunk({ x, y, z });
+			}
+		}
+	}
+}
+
+GameSession::~GameSession() {
+	if (mWorld.getSavePath().empty())
+		return;
+
+	mEditLog.compact(&mWorld);
+	mEditLog.close();
+	mWorld.setEditLog(nullptr);
+}
+
+void GameSession::tick(const F64 &delta) {
+	mCamera.update(delta);
+	TransformSystem::integrate(mEntities, delta);
+	mEntityHash.update(mEntities);
+	mEditLog.update(&mWorld);
+	mWorld.updateFluids(delta);
+	mWorld.updateBlockTicks(delta);
+	mWorld.updateStructuralIntegrity(delta);
+	mWorld.updateMeshes(MESH_BUDGET);
+	mWorld.updateLods(mCamera.getPosition(), LOD_BUDGET);
+}
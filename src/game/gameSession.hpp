@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GAME_GAMESESSION_HPP_
+#define _GAME_GAMESESSION_HPP_
+
+#include "core/types.hpp"
+#include "game/blockPicker.hpp"
+#include "game/camera.hpp"
+#include "game/entity/entityStore.hpp"
+#include "game/entity/spatialHash.hpp"
+#include "world/editLog.hpp"
+#include "world/terrainGenerator.hpp"
+#include "world/world.hpp"
+
+/**
+ * The world, camera and game systems of a session. The game and the headless
+ * replay both run one, so a recording plays back against the world it was
+ * made in and with the same tick.
+ */
+class GameSession {
+public:
+	/**
+	 * Loads the world, replaying any edits that were not yet compacted into
+	 * the region files when it was last closed, and the chunks around the
+	 * spawn.
+	 * @param savePath The save to load and log edits to. An empty path runs a
+	 *  throwaway world straight from the generator, as a replay needs.
+	 * @param hugePages Back the chunk pool with huge pages where possible.
+	 * @param flyover Draw the smooth terrain far beyond the loaded chunks.
+	 */
+	GameSession(const std::string &savePath, bool hugePages, bool flyover);
+
+	/**
+	 * Compacts and closes the edit log of a saved world.
+	 */
+	~GameSession();
+
+	/**
+	 * Advances everything but the rendering by delta seconds.
+	 */
+	void tick(const F64 &delta);
+
+	World& getWorld() {
+		return mWorld;
+	}
+
+	Camera& getCamera() {
+		return mCamera;
+	}
+
+private:
+	TerrainGenerator mGenerator;
+	World mWorld;
+	EditLog mEditLog;
+	Camera mCamera;
+	BlockPicker mPicker;
+	EntityStore mEntities;
+	SpatialHash mEntityHash;
+};
+
+#endif // _GAME_GAMESESSION_HPP_
@@ -0,0 +1,80 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "game/physicsObject.hpp"
+#include "world/voxelCollision.hpp"
+
+// Downward acceleration in blocks per second squared.
+#define PHYSICS_GRAVITY -24.0f
+
+// Tallest ledge a body walks up without jumping.
+#define PHYSICS_STEP_HEIGHT 1.0f
+
+PhysicsObject::PhysicsObject(World *world, const glm::vec3 &halfExtents) {
+	mWorld = world;
+	mHalfExtents = halfExtents;
+	mVelocity = glm::vec3(0.0f);
+	mOnGround = false;
+}
+
+void PhysicsObject::setVelocity(const glm::vec3 &velocity) {
+	mVelocity = velocity;
+}
+
+glm::vec3 PhysicsObject::getVelocity() const {
+	return mVelocity;
+}
+
+bool PhysicsObject::isOnGround() const {
+	return mOnGround;
+}
+
+AABB PhysicsObject::getWorldBox() const {
+	return AABB::fromCenter(mPosition, mHalfExtents);
+}
+
+void PhysicsObject::update(const F64 &delta) {
+	F32 dt = static_cast<F32>(delta);
+
+	mVelocity.y += PHYSICS_GRAVITY * dt;
+
+	AABB box = getWorldBox();
+	CollisionResult result = VoxelCollision::move(mWorld, box, mVelocity * dt, PHYSICS_STEP_HEIGHT);
+	mPosition = box.getCenter();
+	mOnGround = result.onGround;
+
+	// Kill the velocity along every axis we ran into something.
+	if (result.collidedX)
+		mVelocity.x = 0.0f;
+	if (result.collidedY)
+		mVelocity.y = 0.0f;
+	if (result.collidedZ)
+		mVelocity.z = 0.0f;
+}
@@ -0,0 +1,63 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GAME_PHYSICSOBJECT_HPP_
+#define _GAME_PHYSICSOBJECT_HPP_
+
+#include "core/aabb.hpp"
+#include "game/gameObject.hpp"
+
+class World;
+
+/**
+ * A game object with a box shaped body that falls under gravity and collides
+ * with the voxel world. The position is the center of the box.
+ */
+class PhysicsObject : public GameObject {
+public:
+	PhysicsObject(World *world, const glm::vec3 &halfExtents);
+
+	void setVelocity(const glm::vec3 &velocity);
+	glm::vec3 getVelocity() const;
+
+	bool isOnGround() const;
+
+	AABB getWorldBox() const;
+
+	virtual void update(const F64 &delta) override;
+
+protected:
+	World *mWorld;
+	glm::vec3 mHalfExtents;
+	glm::vec3 mVelocity;
+	bool mOnGround;
+};
+
+#endif // _GAME_PHYSICSOBJECT_HPP_
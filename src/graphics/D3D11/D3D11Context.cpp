@@ -51,6 +51,11 @@ void D3D11Context::swapBuffers() const {
 	static_cast<D3D11Renderer*>(mRenderer)->swapBuffers();
 }
 
+void D3D11Context::makeCurrent(bool /*current*/) {
+	// The immediate context isn't bound to a thread, it just can't be used by
+	// two threads at once.
+}
+
 Renderer* D3D11Context::getRenderer() const {
 	return mRenderer;
 }
\ No newline at end of file
@@ -39,6 +39,7 @@ public:
 
 	virtual void destroy() override;
 	virtual void swapBuffers() const override;
+	virtual void makeCurrent(bool current) override;
 	virtual Renderer* getRenderer() const override;
 
 protected:
@@ -75,6 +75,7 @@ ID3D11Buffer *gIBO;
 
 void D3D11Renderer::initRenderer() {
 	mCamera = nullptr;
+	mWorld = nullptr;
 
 	// Create a device, context and swap chain.
 	{
@@ -184,6 +185,8 @@ void D3D11Renderer::destroyRenderer() {
 }
 
 void D3D11Renderer::beginFrame() {
+	Renderer::beginFrame();
+
 	// set clear color.
 	const float clearColor[4] = { 0.0f, 1.0f, 1.0f, 0.5f };
 	mContext->ClearRenderTargetView(mRenderTargetView, clearColor);
@@ -214,6 +217,16 @@ void D3D11Renderer::setActiveSceneCamera(Camera *camera) {
 	mCamera = camera;
 }
 
+void D3D11Renderer::setWorld(World *world) {
+	mWorld = world;
+}
+
+void D3D11Renderer::executeCommandList(const CommandList & /*commands*/) {
+	// Not replayed yet. D3D11 draws no chunks, so it has no chunk shader or
+	// vertex pages for the commands to refer to, and renderChunks() never
+	// records a list.
+}
+
 void D3D11Renderer::swapBuffers() {
 	mSwapChain->Present(1, 0);
 }
@@ -50,12 +50,17 @@ public:
 	virtual void renderSingleCube() override;
 	
 	virtual void setActiveSceneCamera(Camera *camera) override;
+	
+	virtual void setWorld(World *world) override;
+	
+	virtual void executeCommandList(const CommandList &commands) override;
 
 	void swapBuffers();
 	void setWindowHandle(HWND window);
 	
 protected:
 	Camera *mCamera;
+	World *mWorld;
 
 	HWND mWindow;
 	IDXGISwapChain *mSwapChain;
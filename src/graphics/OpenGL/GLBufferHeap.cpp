@@ -0,0 +1,80 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "graphics/OpenGL/GLBufferHeap.hpp"
+
+GLBufferHeap::~GLBufferHeap() {
+	for (const FrameFence &fence : mFences)
+		glDeleteSync(fence.fence);
+	if (!mBuffers.empty())
+		glDeleteBuffers(static_cast<GLsizei>(mBuffers.size()), mBuffers.data());
+}
+
+void GLBufferHeap::beginFrame() {
+	size_t signaled = 0;
+	for (; signaled < mFences.size(); ++signaled) {
+		GLenum status = glClientWaitSync(mFences[signaled].fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(mFences[signaled].fence);
+	}
+
+	if (signaled > 0) {
+		releaseFrames(mFences[signaled - 1].frame);
+		mFences.erase(mFences.begin(), mFences.begin() + signaled);
+	}
+}
+
+void GLBufferHeap::endFrame() {
+	FrameFence fence;
+	fence.frame = getFrame();
+	fence.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mFences.push_back(fence);
+	advanceFrame();
+}
+
+void GLBufferHeap::createPage(U32 /*page*/, U32 size) {
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	mBuffers.push_back(buffer);
+}
+
+void GLBufferHeap::writeRange(U32 page, U32 offset, const void *data, U32 size) {
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffers[page]);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+}
+
+void GLBufferHeap::copyRange(U32 page, U32 srcOffset, U32 dstOffset, U32 size) {
+	glBindBuffer(GL_COPY_READ_BUFFER, mBuffers[page]);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffers[page]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, srcOffset, dstOffset, size);
+}
@@ -0,0 +1,76 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_OPENGL_GLBUFFERHEAP_HPP_
+#define _GRAPHICS_OPENGL_GLBUFFERHEAP_HPP_
+
+#include <vector>
+#include <glad/glad.h>
+#include "graphics/bufferHeap.hpp"
+
+/**
+ * Buffer heap backed by GL buffer objects, with a fence per frame deciding
+ * when freed ranges can be reused.
+ */
+class GLBufferHeap : public BufferHeap {
+public:
+	virtual ~GLBufferHeap();
+
+	GLuint getBuffer(U32 page) const {
+		return mBuffers[page];
+	}
+
+	/**
+	 * Releases the ranges of every frame whose fence has signaled, without
+	 * waiting on the ones that haven't.
+	 */
+	void beginFrame();
+
+	/**
+	 * Submits the fence of the frame.
+	 */
+	void endFrame();
+
+protected:
+	virtual void createPage(U32 page, U32 size) override;
+	virtual void writeRange(U32 page, U32 offset, const void *data, U32 size) override;
+	virtual void copyRange(U32 page, U32 srcOffset, U32 dstOffset, U32 size) override;
+
+private:
+	struct FrameFence {
+		U64 frame;
+		GLsync fence;
+	};
+
+	std::vector<GLuint> mBuffers;
+	std::vector<FrameFence> mFences;
+};
+
+#endif // _GRAPHICS_OPENGL_GLBUFFERHEAP_HPP_
@@ -30,6 +30,7 @@
 //-----------------------------------------------------------------------------
 
 #include <assert.h>
+#include <stdio.h>
 #include <SDL.h>
 #include "graphics/OpenGL/GLContext.hpp"
 #include "graphics/OpenGL/GLRenderer.hpp"
@@ -86,6 +87,11 @@ void GLContext::swapBuffers() const {
 	SDL_GL_SwapWindow(mWindow->getSDLWindow());
 }
 
+void GLContext::makeCurrent(bool current) {
+	if (SDL_GL_MakeCurrent(mWindow->getSDLWindow(), current ? mContext : nullptr) != 0)
+		printf("Unable to make the OpenGL context current: %s\n", SDL_GetError());
+}
+
 Renderer* GLContext::getRenderer() const {
 	return mRenderer;
 }
\ No newline at end of file
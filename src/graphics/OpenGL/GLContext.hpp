@@ -42,6 +42,7 @@ public:
 
 	virtual void destroy() override;
 	virtual void swapBuffers() const override;
+	virtual void makeCurrent(bool current) override;
 	virtual Renderer* getRenderer() const override;
 
 protected:
@@ -28,23 +28,33 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //-----------------------------------------------------------------------------
 
+#include <assert.h>
+#include <stdio.h>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <glad/glad.h>
+#include <SDL.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "graphics/OpenGL/GLRenderer.hpp"
 #include "core/cube.hpp"
+#include "core/frameArena.hpp"
+#include "core/frustum.hpp"
+#include "core/threadPool.hpp"
 #include "game/camera.hpp"
+#include "world/blockMaterials.hpp"
+#include "world/chunkMesher.hpp"
+#include "world/lodTerrain.hpp"
+#include "world/smoothTerrain.hpp"
+#include "world/world.hpp"
 
 // temporary for a single cube until I figure out how to manage materials and
 // shaders.
 GLuint buffer, ibo;
 GLuint cubeVAO;
 
-GLuint cubeVert = 0;
-GLuint fragVert = 0;
 GLuint singleCubeProgram;
 
 GLuint locationPosition;
@@ -65,6 +75,9 @@ struct PointLights {
 
 #define LIGHT_COUNT 4
 
+// Long enough for "lights[N].position".
+#define UNIFORM_NAME_LENGTH 32
+
 PointLights lights[LIGHT_COUNT];
 
 struct LightData {
@@ -73,51 +86,22 @@ struct LightData {
 };
 LightData lightsGLSL[LIGHT_COUNT];
 
-const char *vertSingleCubeSrc =
-"#version 330 core\n"
-
-"layout (location = 0) in vec3 position;\n"
-
-"layout (std140) uniform matrices {\n"
-"   mat4 model;\n"
-"   mat4 view;\n"
-"   mat4 projection;\n"
-"};"
-
-"out vec3 fragPosition;"
-
-"void main() {\n"
-"   mat4 mvp = projection * view * model;\n"
-"   gl_Position = mvp * vec4(position, 1);\n"
-"   fragPosition = vec3(model * vec4(position, 1));"
-"}";
-
-const char *fragSingleCubeSrc =
-"#version 330 core\n"
+#define NEAR_PLANE 0.1f
+#define FAR_PLANE 4096.0f
 
-"struct PointLight {\n"
-"   vec3 position;\n"
-"   vec3 color;\n"
-"};\n"
+// Allocations moved towards the start of their heap page per idle frame.
+#define CHUNK_COMPACTION_MOVES 16
 
-"#define LIGHT_COUNT 4\n"
-"uniform PointLight lights[LIGHT_COUNT];\n"
+// Chunks culled per worker batch and draws recorded per command list.
+#define CHUNK_CULL_BATCH_SIZE 256
+#define CHUNK_DRAWS_PER_LIST 256
 
-"in vec3 fragPosition;\n"
-"out vec4 frag_color;\n"
+// Translucent quads re-sorted per frame after the camera entered another
+// chunk.
+#define TRANSLUCENT_SORT_BUDGET 16384
 
-"void main() {\n"
-"   vec3 ac = vec3(0,0,0);\n"
-"   for (int i = 0; i < LIGHT_COUNT; i++) {\n"
-"      float distance = length(lights[i].position - fragPosition);\n"
-"      if (distance <= 4.0) {\n"
-"         float attenuation = 1.0 / (distance * distance);\n"
-"         vec3 lightColor = lights[i].color * attenuation;\n"
-"         ac += lightColor;\n"
-"      }\n"
-"   }\n"
-"   frag_color = vec4(0.25, 0, 0, 1) + vec4(ac, 0);\n"
-"}";
+// Bytes of finished textures uploaded per frame.
+#define TEXTURE_UPLOAD_BUDGET (64 * 1024)
 
 static void checkError(const char *fn) {
 	GLenum err;
@@ -128,6 +112,7 @@ static void checkError(const char *fn) {
 
 void GLRenderer::initRenderer() {
 	mCamera = nullptr;
+	mWorld = nullptr;
 	
 	// The core profile requires a VAO to be bound before quite a bit of specific GL calls are made.
 	// We'll just create a global state VAO for now so that we can just call GL functions.
@@ -147,77 +132,29 @@ void GLRenderer::initRenderer() {
 	
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	
-	// Shaders.
-	{
-		GLint shaderCompileSuccess;
-		GLint shaderErrorLogLength;
-		
-		// Create vertex shaders
-		cubeVert = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(cubeVert, 1, &vertSingleCubeSrc, NULL);
-		glCompileShader(cubeVert);
-		
-		// Check shader error.
-		glGetShaderiv(cubeVert, GL_COMPILE_STATUS, &shaderCompileSuccess);
-		if (!shaderCompileSuccess) {
-			glGetShaderiv(cubeVert, GL_INFO_LOG_LENGTH, &shaderErrorLogLength);
-			
-			char *log = new char[shaderErrorLogLength];
-			glGetShaderInfoLog(cubeVert, shaderErrorLogLength, &shaderErrorLogLength, log);
-			printf("Error compiling vertex shader: %s\n", log);
-			delete[] log;
-
-			glDeleteShader(cubeVert);
-			return;
-		}
-		
-		// Create fragment shader.
-		fragVert = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragVert, 1, &fragSingleCubeSrc, NULL);
-		glCompileShader(fragVert);
-		
-		// Check shader error.
-		glGetShaderiv(fragVert, GL_COMPILE_STATUS, &shaderCompileSuccess);
-		if (!shaderCompileSuccess) {
-			glGetShaderiv(fragVert, GL_INFO_LOG_LENGTH, &shaderErrorLogLength);
-			
-			char *log = new char[shaderErrorLogLength];
-			glGetShaderInfoLog(fragVert, shaderErrorLogLength, &shaderErrorLogLength, log);
-			printf("Error compiling fragment shader: %s\n", log);
-			delete[] log;
-
-			glDeleteShader(fragVert);
-			return;
-		}
-		
-		// now we can make a program.
-		singleCubeProgram = glCreateProgram();
-		glAttachShader(singleCubeProgram, cubeVert);
-		glAttachShader(singleCubeProgram, fragVert);
-		
-		glLinkProgram(singleCubeProgram);
-		
-		// Make sure we linked successfully.
-		GLint linked;
-		glGetProgramiv(singleCubeProgram, GL_LINK_STATUS, &linked);
-		if (!linked) {
-			glGetProgramiv(singleCubeProgram, GL_INFO_LOG_LENGTH, &shaderErrorLogLength);
-			
-			char *log = new char[shaderErrorLogLength];
-			glGetProgramInfoLog(singleCubeProgram, shaderErrorLogLength, &shaderErrorLogLength, log);
-			printf("Error linking program: %s\n", log);
-			delete[] log;
-
-			glDeleteProgram(singleCubeProgram);
-			glDeleteShader(cubeVert);
-			glDeleteShader(fragVert);
-			return;
-		}
-		
-		glDetachShader(singleCubeProgram, cubeVert);
-		glDetachShader(singleCubeProgram, fragVert);
+	// Shaders and textures are loaded from next to the executable and the
+	// shader binaries cached in the user's data directory.
+	std::string shaderPath = "shaders/";
+	std::string cachePath;
+	mTexturePath = "textures/";
+	char *basePath = SDL_GetBasePath();
+	if (basePath != nullptr) {
+		shaderPath = std::string(basePath) + shaderPath;
+		mTexturePath = std::string(basePath) + mTexturePath;
+		SDL_free(basePath);
+	}
+	char *prefPath = SDL_GetPrefPath("Voxel", "Voxel");
+	if (prefPath != nullptr) {
+		cachePath = prefPath;
+		SDL_free(prefPath);
 	}
+	mShaderManager = new GLShaderManager(shaderPath, cachePath);
+	singleCubeProgram = mShaderManager->getProgram("singleCube");
+	mChunkProgram = mShaderManager->getProgram("chunk");
+	mTerrainProgram = mShaderManager->getProgram("terrain");
+	mShaderManager->printStats();
 
 	uboBlockIndex = glGetUniformBlockIndex(singleCubeProgram, "matrices");
 
@@ -242,11 +179,14 @@ void GLRenderer::initRenderer() {
 	glBindVertexArray(mGlobalVAO);
 
 	// Lights.
+	LinearArena &arena = FrameArena::get();
 	for (U32 i = 0; i < LIGHT_COUNT; ++i) {
-		std::string pos = "lights[" + std::to_string(i) + "].position";
-		std::string col = "lights[" + std::to_string(i) + "].color";
-		lightsGLSL[i].position = glGetUniformLocation(singleCubeProgram, pos.c_str());
-		lightsGLSL[i].color = glGetUniformLocation(singleCubeProgram, col.c_str());
+		char *pos = arena.allocate<char>(UNIFORM_NAME_LENGTH);
+		char *col = arena.allocate<char>(UNIFORM_NAME_LENGTH);
+		snprintf(pos, UNIFORM_NAME_LENGTH, "lights[%u].position", i);
+		snprintf(col, UNIFORM_NAME_LENGTH, "lights[%u].color", i);
+		lightsGLSL[i].position = glGetUniformLocation(singleCubeProgram, pos);
+		lightsGLSL[i].color = glGetUniformLocation(singleCubeProgram, col);
 	}
 
 	lights[0].color = glm::vec3(0.0f, 0.3f, 0.0f);
@@ -257,33 +197,551 @@ void GLRenderer::initRenderer() {
 	lights[2].position = glm::vec3(5.0f, 0.0f, 5.0f);
 	lights[3].color = glm::vec3(3.0f, 0.0f, 0.3f);
 	lights[3].position = glm::vec3(3.0f, 1.0f, 5.0f);
+
+	// Chunks.
+	mChunkHeap = new GLBufferHeap();
+	mLodFrame = 0;
+	mSortChunk = { 0, 0, 0 };
+	mSortGeneration = 1;
+	mSortQueueCursor = 0;
+	mViewProjectionLocation = glGetUniformLocation(mChunkProgram, "viewProjection");
+	mChunkTransformLocation = glGetUniformLocation(mChunkProgram, "chunkTransform");
+	createBlockTextures();
+
+	// Smooth terrain.
+	mTerrainHeap = new GLBufferHeap();
+	mTerrainViewProjectionLocation = glGetUniformLocation(mTerrainProgram, "viewProjection");
+	mTerrainTransformLocation = glGetUniformLocation(mTerrainProgram, "chunkTransform");
+
+	// Every mesh is a list of quads, so the indices are the same for all of
+	// them and only the base vertex changes. They cover the largest mesh and
+	// have to fit in 16 bits.
+	assert(MAX_CHUNK_MESH_VERTICES <= 0x10000);
+	std::vector<U16> quadIndices;
+	quadIndices.reserve(MAX_CHUNK_MESH_QUADS * 6);
+	for (U32 i = 0; i < MAX_CHUNK_MESH_VERTICES; i += 4) {
+		quadIndices.push_back(static_cast<U16>(i));
+		quadIndices.push_back(static_cast<U16>(i + 1));
+		quadIndices.push_back(static_cast<U16>(i + 2));
+		quadIndices.push_back(static_cast<U16>(i));
+		quadIndices.push_back(static_cast<U16>(i + 2));
+		quadIndices.push_back(static_cast<U16>(i + 3));
+	}
+	glGenBuffers(1, &mQuadIndexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, quadIndices.size() * sizeof(U16), quadIndices.data(), GL_STATIC_DRAW);
 }
 
 void GLRenderer::destroyRenderer() {
 	glDeleteVertexArrays(1, &cubeVAO);
 
+#ifndef NDEBUG
+	mChunkHeap->printStats();
+	mTerrainHeap->printStats();
+	mVisibility.printStats();
+	mOcclusion.printStats();
+	mTextureUploader.printStats();
+	mState.printStats();
+#endif
+	mImageLoader.shutdown();
+	mTextureUploader.shutdown();
+	if (!mChunkPageVAOs.empty())
+		glDeleteVertexArrays(static_cast<GLsizei>(mChunkPageVAOs.size()), mChunkPageVAOs.data());
+	mChunkPageVAOs.clear();
+	mChunkMeshes.clear();
+	mLodMeshes.clear();
+	delete mChunkHeap;
+	mChunkHeap = nullptr;
+	glDeleteBuffers(1, &mQuadIndexBuffer);
+	glDeleteTextures(1, &mBlockTextures);
+	if (!mTerrainPageVAOs.empty())
+		glDeleteVertexArrays(static_cast<GLsizei>(mTerrainPageVAOs.size()), mTerrainPageVAOs.data());
+	mTerrainPageVAOs.clear();
+	mTerrainMeshes.clear();
+	delete mTerrainHeap;
+	mTerrainHeap = nullptr;
+
 	// Delete the VAO
 	if (glIsVertexArray(mGlobalVAO)) {
 		glDeleteVertexArrays(1, &mGlobalVAO);
 	}
 	
-	glDeleteProgram(singleCubeProgram);
-	glDeleteShader(cubeVert);
-	glDeleteShader(fragVert);
+	delete mShaderManager;
+	mShaderManager = nullptr;
 	glDeleteBuffers(1, &buffer);
 	glDeleteBuffers(1, &ibo);
+
+	// Deleting bound objects resets their bindings behind the cache's back.
+	mState.invalidate();
 }
 
 void GLRenderer::beginFrame() {
+	Renderer::beginFrame();
+	mState.beginFrame();
+	mChunkHeap->beginFrame();
+	mTerrainHeap->beginFrame();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
 void GLRenderer::renderChunks() {
+	if (mCamera == nullptr || mWorld == nullptr)
+		return;
+
+	// Only compact on frames without uploads, moving allocations around while
+	// meshes are streaming in would mostly be undone by the next frees.
+	if (!updateChunkMeshes())
+		mChunkHeap->compact(CHUNK_COMPACTION_MOVES);
+	if (!updateTerrainMeshes())
+		mTerrainHeap->compact(CHUNK_COMPACTION_MOVES);
+	updateTranslucentSorting(TRANSLUCENT_SORT_BUDGET);
+	updateBlockTextures();
+
+	while (mChunkPageVAOs.size() < mChunkHeap->getPageCount()) {
+		const U32 page = static_cast<U32>(mChunkPageVAOs.size());
+		GLuint vao;
+		glGenVertexArrays(1, &vao);
+		mState.bindVertexArray(vao);
+		mState.bindBuffer(GL_ARRAY_BUFFER, mChunkHeap->getBuffer(page));
+		mState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mQuadIndexBuffer);
+		glEnableVertexAttribArray(0);
+		glVertexAttribIPointer(0, 4, GL_UNSIGNED_BYTE, sizeof(ChunkVertex), (GLvoid*)offsetof(ChunkVertex, x));
+		glEnableVertexAttribArray(1);
+		glVertexAttribIPointer(1, 1, GL_UNSIGNED_SHORT, sizeof(ChunkVertex), (GLvoid*)offsetof(ChunkVertex, layer));
+		mChunkPageVAOs.push_back(vao);
+	}
+
+	glm::mat4 view = glm::lookAt(mCamera->getPosition(), mCamera->getPosition() + mCamera->getFrontVector(), mCamera->getUpVector());
+	glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1440.f/900.f, NEAR_PLANE, FAR_PLANE);
+	mViewProjection = proj * view;
+
+	// Full detail chunks and downsampled nodes share the pipeline, the nodes'
+	// vertices are scaled up to the area they cover.
+	const LodTerrain &lod = mWorld->getLodTerrain();
+	mChunkDraws.clear();
+	for (const auto &pair : mChunkMeshes) {
+		if (pair.second.allocation != BufferHeap::INVALID_ALLOCATION && lod.isFullDetail(pair.first))
+			addChunkDraw(pair.second, pair.first, 0);
+	}
+	for (const auto &pair : mLodMeshes) {
+		if (pair.second.allocation != BufferHeap::INVALID_ALLOCATION)
+			addChunkDraw(pair.second, pair.first.origin, pair.first.level);
+	}
+
+	// Find the chunks the camera can see into through the caves and draw the
+	// solid walls of the chunks around it into the occlusion buffer, then cull
+	// and key the chunks on the workers. They all share a shader and material,
+	// so they are drawn front to back, followed by the translucent quads back
+	// to front.
+	const Frustum frustum(mViewProjection);
+	const glm::vec3 cameraPosition = mCamera->getPosition();
+	mVisibility.update(mWorld, frustum, cameraPosition);
+	mOcclusion.begin(mViewProjection);
+	mOcclusion.addChunkOccluders(mWorld, frustum, cameraPosition);
+	mOcclusion.rasterize();
+	gThreadPool.parallelFor(static_cast<U32>(mChunkDraws.size()), CHUNK_CULL_BATCH_SIZE, [&](U32 start, U32 end) {
+		for (U32 i = start; i < end; ++i) {
+			ChunkDraw &draw = mChunkDraws[i];
+			const F32 size = CHUNK_SIZE * draw.scale;
+			const AABB box(draw.origin, draw.origin + glm::vec3(size));
+			// Downsampled nodes span many chunks and skip the cave culling.
+			draw.visible = frustum.intersects(box) && (draw.scale > 1.0f || mVisibility.isVisible(draw.coord)) && !mOcclusion.isOccluded(box);
+			if (draw.visible) {
+				const glm::vec3 center = draw.origin + glm::vec3(size * 0.5f);
+				const F32 depth = glm::length(center - cameraPosition) / FAR_PLANE;
+				if (draw.translucent)
+					draw.key = RenderQueue::makeTransparentKey(mChunkProgram, 0, 0, depth);
+				else
+					draw.key = RenderQueue::makeOpaqueKey(mChunkProgram, 0, 0, depth);
+			}
+		}
+	});
+
+	mRenderQueue.clear();
+	for (U32 i = 0; i < mChunkDraws.size(); ++i) {
+		if (mChunkDraws[i].visible)
+			mRenderQueue.submit(mChunkDraws[i].key, i);
+	}
+	mRenderQueue.sort();
+
+	// Record a command list per batch of sorted draws on the workers, then
+	// replay them in order here. The opaque and the transparent draws are
+	// batched separately so the smooth terrain can go in between them, the
+	// water has to blend over it.
+	const std::vector<RenderItem> &items = mRenderQueue.getItems();
+	const U32 drawCount = static_cast<U32>(items.size());
+	const U32 transparentStart = static_cast<U32>(std::partition_point(items.begin(), items.end(), [](const RenderItem &item) {
+		return RenderQueue::getPass(item.key) == RENDER_PASS_OPAQUE;
+	}) - items.begin());
+	const U32 opaqueListCount = (transparentStart + CHUNK_DRAWS_PER_LIST - 1) / CHUNK_DRAWS_PER_LIST;
+	const U32 listCount = opaqueListCount + (drawCount - transparentStart + CHUNK_DRAWS_PER_LIST - 1) / CHUNK_DRAWS_PER_LIST;
+	if (mCommandLists.size() < listCount)
+		mCommandLists.resize(listCount);
+	gThreadPool.parallelFor(listCount, 1, [&](U32 start, U32 end) {
+		for (U32 list = start; list < end; ++list) {
+			if (list < opaqueListCount) {
+				const U32 first = list * CHUNK_DRAWS_PER_LIST;
+				recordChunkDraws(mCommandLists[list], first, std::min(transparentStart, first + CHUNK_DRAWS_PER_LIST));
+			} else {
+				const U32 first = transparentStart + (list - opaqueListCount) * CHUNK_DRAWS_PER_LIST;
+				recordChunkDraws(mCommandLists[list], first, std::min(drawCount, first + CHUNK_DRAWS_PER_LIST));
+			}
+		}
+	});
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mBlockTextures);
+	for (U32 i = 0; i < opaqueListCount; ++i)
+		executeCommandList(mCommandLists[i]);
+
+	renderTerrain();
+
+	// Every list sets its own pass, shader and vertex page again.
+	for (U32 i = opaqueListCount; i < listCount; ++i)
+		executeCommandList(mCommandLists[i]);
+	mState.setEnabled(GL_BLEND, false);
+	mState.setEnabled(GL_CULL_FACE, true);
+	mState.depthMask(true);
+	mState.bindVertexArray(mGlobalVAO);
+}
+
+void GLRenderer::createBlockTextures() {
+	const U32 layerCount = BlockMaterials::getLayerCount();
+	std::vector<U8> texels(BLOCK_TEXTURE_SIZE * BLOCK_TEXTURE_SIZE * 4);
+
+	glGenTextures(1, &mBlockTextures);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mBlockTextures);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, BLOCK_TEXTURE_SIZE, BLOCK_TEXTURE_SIZE, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	for (U32 layer = 0; layer < layerCount; ++layer) {
+		BlockMaterials::generatePlaceholder(layer, texels.data());
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, BLOCK_TEXTURE_SIZE, BLOCK_TEXTURE_SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+	}
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+	// Crisp texels up close, mipmaps keep the distant and downsampled chunks
+	// from shimmering.
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	checkError("createBlockTextures");
+
+	// The array stays on texture unit 0.
+	mState.useProgram(mChunkProgram);
+	glUniform1i(glGetUniformLocation(mChunkProgram, "blockTextures"), 0);
+
+	mTextureStreamStart = SDL_GetPerformanceCounter();
+	mTexturesStreaming = true;
+	for (U32 layer = 0; layer < layerCount; ++layer)
+		mImageLoader.request(mTexturePath + "blocks/" + BlockMaterials::getLayerName(layer) + ".tga", layer);
+}
+
+void GLRenderer::updateBlockTextures() {
+	if (!mTexturesStreaming)
+		return;
+
+	ImageLoader::Result result;
+	while (mImageLoader.poll(result)) {
+		if (result.loaded && (result.image.width != BLOCK_TEXTURE_SIZE || result.image.height != BLOCK_TEXTURE_SIZE)) {
+			printf("Block texture %s is %ux%u instead of %ux%u\n", BlockMaterials::getLayerName(result.id), result.image.width, result.image.height, BLOCK_TEXTURE_SIZE, BLOCK_TEXTURE_SIZE);
+			result.loaded = false;
+		}
+		if (!result.loaded) {
+			result.image.width = BLOCK_TEXTURE_SIZE;
+			result.image.height = BLOCK_TEXTURE_SIZE;
+			result.image.pixels.resize(BLOCK_TEXTURE_SIZE * BLOCK_TEXTURE_SIZE * 4);
+			BlockMaterials::generateLayer(result.id, result.image.pixels.data());
+		}
+		mTextureUploader.queue(mBlockTextures, result.id, std::move(result.image));
+	}
+
+	if (mTextureUploader.update(TEXTURE_UPLOAD_BUDGET) > 0) {
+		glBindTexture(GL_TEXTURE_2D_ARRAY, mBlockTextures);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+
+	if (mImageLoader.getPendingCount() == 0 && mTextureUploader.isIdle()) {
+		mTexturesStreaming = false;
+		const F64 seconds = static_cast<F64>(SDL_GetPerformanceCounter() - mTextureStreamStart) / SDL_GetPerformanceFrequency();
+		printf("Block textures streamed in %.2f ms\n", seconds * 1000.0);
+	}
+}
+
+void GLRenderer::renderTerrain() {
+	if (mTerrainMeshes.empty())
+		return;
 
+	while (mTerrainPageVAOs.size() < mTerrainHeap->getPageCount()) {
+		const U32 page = static_cast<U32>(mTerrainPageVAOs.size());
+		GLuint vao;
+		glGenVertexArrays(1, &vao);
+		mState.bindVertexArray(vao);
+		mState.bindBuffer(GL_ARRAY_BUFFER, mTerrainHeap->getBuffer(page));
+		mState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mTerrainHeap->getBuffer(page));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SmoothVertex), (GLvoid*)offsetof(SmoothVertex, x));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_BYTE, GL_TRUE, sizeof(SmoothVertex), (GLvoid*)offsetof(SmoothVertex, normalX));
+		glEnableVertexAttribArray(2);
+		glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(SmoothVertex), (GLvoid*)offsetof(SmoothVertex, material));
+		mTerrainPageVAOs.push_back(vao);
+	}
+
+	const Frustum frustum(mViewProjection);
+	mState.useProgram(mTerrainProgram);
+	mState.uniformMatrix4fv(mTerrainViewProjectionLocation, &mViewProjection[0][0]);
+	for (const auto &pair : mTerrainMeshes) {
+		const GLTerrainMesh &mesh = pair.second;
+		if (mesh.allocation == BufferHeap::INVALID_ALLOCATION)
+			continue;
+
+		// The border cells reach past the node on every side.
+		const F32 cell = static_cast<F32>(1 << pair.first.level);
+		const glm::vec3 origin = glm::vec3(pair.first.origin.x, pair.first.origin.y, pair.first.origin.z) * static_cast<F32>(CHUNK_SIZE);
+		const glm::vec3 border(cell * SMOOTH_BORDER);
+		if (!frustum.intersects(AABB(origin - border, origin + glm::vec3(cell * CHUNK_SIZE) + border)))
+			continue;
+
+		const F32 transform[4] = { origin.x, origin.y, origin.z, cell };
+		const U32 offset = mTerrainHeap->getOffset(mesh.allocation);
+		mState.bindVertexArray(mTerrainPageVAOs[mTerrainHeap->getPage(mesh.allocation)]);
+		mState.uniform4fv(mTerrainTransformLocation, transform);
+		glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT, (GLvoid*)(size_t)(offset + mesh.vertexCount * sizeof(SmoothVertex)), offset / sizeof(SmoothVertex));
+	}
+}
+
+void GLRenderer::addChunkDraw(const GLChunkMesh &mesh, const ChunkCoord &origin, U32 level) {
+	ChunkDraw draw;
+	draw.coord = origin;
+	draw.origin = glm::vec3(origin.x, origin.y, origin.z) * static_cast<F32>(CHUNK_SIZE);
+	draw.scale = static_cast<F32>(1 << level);
+	draw.page = mChunkHeap->getPage(mesh.allocation);
+	draw.baseVertex = static_cast<S32>(mChunkHeap->getOffset(mesh.allocation) / sizeof(ChunkVertex));
+	draw.quadCount = mesh.quadCount;
+	draw.translucent = false;
+	if (draw.quadCount > 0)
+		mChunkDraws.push_back(draw);
+
+	if (mesh.translucentQuadCount > 0) {
+		draw.baseVertex += static_cast<S32>(mesh.quadCount * 4);
+		draw.quadCount = mesh.translucentQuadCount;
+		draw.translucent = true;
+		mChunkDraws.push_back(draw);
+	}
+}
+
+void GLRenderer::recordChunkDraws(CommandList &commands, U32 first, U32 last) const {
+	const std::vector<RenderItem> &items = mRenderQueue.getItems();
+	RenderPass pass = RenderQueue::getPass(items[first].key);
+	commands.clear();
+	commands.setPass(pass);
+	commands.setShader(mChunkProgram);
+	commands.setViewProjection(&mViewProjection[0][0]);
+
+	U32 page = BufferHeap::INVALID_ALLOCATION;
+	for (U32 i = first; i < last; ++i) {
+		const ChunkDraw &draw = mChunkDraws[items[i].draw];
+		if (RenderQueue::getPass(items[i].key) != pass) {
+			pass = RenderQueue::getPass(items[i].key);
+			commands.setPass(pass);
+		}
+		if (draw.page != page) {
+			commands.setVertexPage(draw.page);
+			page = draw.page;
+		}
+		commands.setChunkTransform(draw.origin.x, draw.origin.y, draw.origin.z, draw.scale);
+		commands.drawQuads(draw.baseVertex, draw.quadCount);
+	}
+}
+
+void GLRenderer::executeCommandList(const CommandList &commands) {
+	for (const RenderCommand &command : commands.getCommands()) {
+		switch (command.type) {
+			case RENDER_COMMAND_SET_PASS: {
+				const bool transparent = command.setPass.pass == RENDER_PASS_TRANSPARENT;
+				mState.setEnabled(GL_BLEND, transparent);
+				mState.depthMask(!transparent);
+
+				// Water surfaces are seen from below as well.
+				mState.setEnabled(GL_CULL_FACE, !transparent);
+				break;
+			}
+			case RENDER_COMMAND_SET_SHADER:
+				mState.useProgram(command.setShader.shader);
+				break;
+			case RENDER_COMMAND_SET_VIEW_PROJECTION:
+				mState.uniformMatrix4fv(mViewProjectionLocation, command.setViewProjection.matrix);
+				break;
+			case RENDER_COMMAND_SET_VERTEX_PAGE:
+				mState.bindVertexArray(mChunkPageVAOs[command.setVertexPage.page]);
+				break;
+			case RENDER_COMMAND_SET_CHUNK_TRANSFORM:
+				mState.uniform4fv(mChunkTransformLocation, command.setChunkTransform.transform);
+				break;
+			case RENDER_COMMAND_DRAW_QUADS:
+				glDrawElementsBaseVertex(GL_TRIANGLES, command.drawQuads.quadCount * 6, GL_UNSIGNED_SHORT, 0, command.drawQuads.baseVertex);
+				break;
+		}
+	}
+}
+
+bool GLRenderer::updateChunkMeshes() {
+	bool uploaded = false;
+	for (const auto &pair : mWorld->getChunks()) {
+		const ChunkMesh *mesh = pair.second->getMesh();
+		if (mesh == nullptr)
+			continue;
+
+		auto pos = mChunkMeshes.find(pair.first);
+		if (pos == mChunkMeshes.end())
+			pos = mChunkMeshes.insert(std::make_pair(pair.first, GLChunkMesh())).first;
+		if (uploadChunkMesh(pos->second, mesh)) {
+			uploaded = true;
+			if (pos->second.translucentQuadCount > 0)
+				sortTranslucentQuads(pos->second, mesh, pair.first);
+		}
+	}
+
+	// Drop the meshes of chunks that were unloaded.
+	for (auto it = mChunkMeshes.begin(); it != mChunkMeshes.end();) {
+		const Chunk *chunk = mWorld->getChunk(it->first);
+		if (chunk == nullptr || chunk->getMesh() == nullptr) {
+			if (it->second.allocation != BufferHeap::INVALID_ALLOCATION)
+				mChunkHeap->free(it->second.allocation);
+			it = mChunkMeshes.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	// Only the downsampled nodes selected this frame are kept around.
+	++mLodFrame;
+	for (const LodNode &node : mWorld->getLodTerrain().getNodes()) {
+		auto pos = mLodMeshes.find(node.key);
+		if (pos == mLodMeshes.end())
+			pos = mLodMeshes.insert(std::make_pair(node.key, GLChunkMesh())).first;
+		uploaded |= uploadChunkMesh(pos->second, node.mesh);
+		pos->second.lastFrame = mLodFrame;
+	}
+	for (auto it = mLodMeshes.begin(); it != mLodMeshes.end();) {
+		if (it->second.lastFrame != mLodFrame) {
+			if (it->second.allocation != BufferHeap::INVALID_ALLOCATION)
+				mChunkHeap->free(it->second.allocation);
+			it = mLodMeshes.erase(it);
+		} else {
+			++it;
+		}
+	}
+	return uploaded;
+}
+
+bool GLRenderer::uploadChunkMesh(GLChunkMesh &gpuMesh, const ChunkMesh *mesh) {
+	if (gpuMesh.version == mesh->version)
+		return false;
+
+	if (gpuMesh.allocation != BufferHeap::INVALID_ALLOCATION)
+		mChunkHeap->free(gpuMesh.allocation);
+	gpuMesh.allocation = BufferHeap::INVALID_ALLOCATION;
+	if (!mesh->isEmpty()) {
+		const U32 size = mesh->vertexCount * sizeof(ChunkVertex);
+		gpuMesh.allocation = mChunkHeap->allocate(size);
+		mChunkHeap->upload(gpuMesh.allocation, mesh->vertices, size);
+	}
+	gpuMesh.version = mesh->version;
+	gpuMesh.quadCount = mesh->getOpaqueQuadCount();
+	gpuMesh.translucentQuadCount = mesh->getTranslucentQuadCount();
+	gpuMesh.sortGeneration = 0;
+	return !mesh->isEmpty();
+}
+
+void GLRenderer::sortTranslucentQuads(GLChunkMesh &gpuMesh, const ChunkMesh *mesh, const ChunkCoord &coord) {
+	const glm::vec3 origin = glm::vec3(coord.x, coord.y, coord.z) * static_cast<F32>(CHUNK_SIZE);
+	const U32 quadCount = mesh->getTranslucentQuadCount();
+	mSortedVertices.resize(quadCount * 4);
+	ChunkMesher::sortQuads(mesh->vertices + mesh->translucentOffset, quadCount, mCamera->getPosition() - origin, mSortScratch, mSortedVertices.data());
+	mChunkHeap->upload(gpuMesh.allocation, mSortedVertices.data(), quadCount * 4 * sizeof(ChunkVertex), mesh->translucentOffset * sizeof(ChunkVertex));
+	gpuMesh.sortGeneration = mSortGeneration;
+}
+
+void GLRenderer::updateTranslucentSorting(U32 budget) {
+	const glm::vec3 cameraPosition = mCamera->getPosition();
+	const ChunkCoord cameraChunk = World::getChunkCoord(glm::ivec3(glm::floor(cameraPosition)));
+	if (cameraChunk != mSortChunk) {
+		mSortChunk = cameraChunk;
+		++mSortGeneration;
+
+		// The quads within a chunk are sorted from a point inside of it, so a
+		// chunk further away is less likely to be visibly out of order.
+		mSortQueue.clear();
+		mSortQueueCursor = 0;
+		for (const auto &pair : mChunkMeshes) {
+			if (pair.second.translucentQuadCount > 0)
+				mSortQueue.push_back(pair.first);
+		}
+		std::sort(mSortQueue.begin(), mSortQueue.end(), [&cameraChunk](const ChunkCoord &a, const ChunkCoord &b) {
+			const glm::ivec3 da(a.x - cameraChunk.x, a.y - cameraChunk.y, a.z - cameraChunk.z);
+			const glm::ivec3 db(b.x - cameraChunk.x, b.y - cameraChunk.y, b.z - cameraChunk.z);
+			return da.x * da.x + da.y * da.y + da.z * da.z < db.x * db.x + db.y * db.y + db.z * db.z;
+		});
+	}
+
+	U32 sorted = 0;
+	while (mSortQueueCursor < mSortQueue.size() && sorted < budget) {
+		const ChunkCoord &coord = mSortQueue[mSortQueueCursor++];
+		auto pos = mChunkMeshes.find(coord);
+		const Chunk *chunk = mWorld->getChunk(coord);
+		if (pos == mChunkMeshes.end() || chunk == nullptr || chunk->getMesh() == nullptr)
+			continue;
+
+		// Meshes uploaded since the queue was built are sorted already, and a
+		// mesh that changed is sorted when it is uploaded.
+		GLChunkMesh &gpuMesh = pos->second;
+		if (gpuMesh.sortGeneration == mSortGeneration || gpuMesh.version != chunk->getMesh()->version || gpuMesh.translucentQuadCount == 0)
+			continue;
+		sortTranslucentQuads(gpuMesh, chunk->getMesh(), coord);
+		sorted += gpuMesh.translucentQuadCount;
+	}
+}
+
+bool GLRenderer::updateTerrainMeshes() {
+	bool uploaded = false;
+	const U64 frame = mLodFrame;
+	for (const SmoothNode &node : mWorld->getSmoothTerrain().getNodes()) {
+		GLTerrainMesh &gpuMesh = mTerrainMeshes[node.key];
+		gpuMesh.lastFrame = frame;
+		if (gpuMesh.version == node.mesh->version)
+			continue;
+
+		if (gpuMesh.allocation != BufferHeap::INVALID_ALLOCATION)
+			mTerrainHeap->free(gpuMesh.allocation);
+
+		// Allocations are aligned to 16 bytes, a multiple of the vertex size,
+		// so the offset of every mesh is a whole base vertex.
+		const U32 vertexSize = static_cast<U32>(node.mesh->vertices.size() * sizeof(SmoothVertex));
+		const U32 indexSize = static_cast<U32>(node.mesh->indices.size() * sizeof(U16));
+		gpuMesh.allocation = mTerrainHeap->allocate(vertexSize + indexSize);
+		assert(mTerrainHeap->getOffset(gpuMesh.allocation) % sizeof(SmoothVertex) == 0);
+		mTerrainHeap->upload(gpuMesh.allocation, node.mesh->vertices.data(), vertexSize);
+		mTerrainHeap->upload(gpuMesh.allocation, node.mesh->indices.data(), indexSize, vertexSize);
+		gpuMesh.version = node.mesh->version;
+		gpuMesh.vertexCount = static_cast<U32>(node.mesh->vertices.size());
+		gpuMesh.indexCount = static_cast<U32>(node.mesh->indices.size());
+		uploaded = true;
+	}
+
+	for (auto it = mTerrainMeshes.begin(); it != mTerrainMeshes.end();) {
+		if (it->second.lastFrame != frame) {
+			if (it->second.allocation != BufferHeap::INVALID_ALLOCATION)
+				mTerrainHeap->free(it->second.allocation);
+			it = mTerrainMeshes.erase(it);
+		} else {
+			++it;
+		}
+	}
+	return uploaded;
 }
 
 void GLRenderer::endFrame() {
-	
+	mChunkHeap->endFrame();
+	mTerrainHeap->endFrame();
 }
 
 void GLRenderer::renderSingleCube() {
@@ -291,24 +749,24 @@ void GLRenderer::renderSingleCube() {
 		return;
 	
 	glm::mat4 view = glm::lookAt(mCamera->getPosition(), mCamera->getPosition() + mCamera->getFrontVector(), mCamera->getUpVector());
-	glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1440.f/900.f, 0.02f, 200.0f);
+	glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1440.f/900.f, NEAR_PLANE, FAR_PLANE);
 	
-	glUseProgram(singleCubeProgram);
+	mState.useProgram(singleCubeProgram);
 	
 	// Update the UBO's data.
-	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	mState.bindBuffer(GL_UNIFORM_BUFFER, ubo);
 	glBufferSubData(GL_UNIFORM_BUFFER, offsetof(UBO, view), sizeof(glm::mat4), &view[0][0]);
 	glBufferSubData(GL_UNIFORM_BUFFER, offsetof(UBO, projection), sizeof(glm::mat4), &proj[0][0]);
 
 	// Bind buffers to shaders
-	glBindVertexArray(cubeVAO);
-	glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo); // bind to register 0
-	glUniformBlockBinding(singleCubeProgram, uboBlockIndex, 0); // bind to register 0
+	mState.bindVertexArray(cubeVAO);
+	mState.bindBufferBase(GL_UNIFORM_BUFFER, 0, ubo); // bind to register 0
+	mState.uniformBlockBinding(singleCubeProgram, uboBlockIndex, 0); // bind to register 0
 
 	// Bind lights
 	for (int i = 0; i < LIGHT_COUNT; ++i) {
-		glUniform3fv(lightsGLSL[i].position, 1, &lights[i].position[0]);
-		glUniform3fv(lightsGLSL[i].color, 1, &lights[i].color[0]);
+		mState.uniform3fv(lightsGLSL[i].position, &lights[i].position[0]);
+		mState.uniform3fv(lightsGLSL[i].color, &lights[i].color[0]);
 	}
 
 	for (int x = 0; x < 16; ++x) {
@@ -324,4 +782,8 @@ void GLRenderer::renderSingleCube() {
 
 void GLRenderer::setActiveSceneCamera(Camera *camera) {
 	mCamera = camera;
+}
+
+void GLRenderer::setWorld(World *world) {
+	mWorld = world;
 }
\ No newline at end of file
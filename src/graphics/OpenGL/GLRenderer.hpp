@@ -31,8 +31,22 @@
 #ifndef _GRAPHICS_OPENGL_GLRENDERER_HPP_
 #define _GRAPHICS_OPENGL_GLRENDERER_HPP_
 
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "graphics/chunkVisibility.hpp"
+#include "graphics/imageLoader.hpp"
+#include "graphics/occlusionBuffer.hpp"
 #include "graphics/renderer.hpp"
+#include "graphics/renderQueue.hpp"
+#include "graphics/OpenGL/GLBufferHeap.hpp"
+#include "graphics/OpenGL/GLShaderManager.hpp"
+#include "graphics/OpenGL/GLStateCache.hpp"
+#include "graphics/OpenGL/GLTextureUploader.hpp"
 #include "game/camera.hpp"
+#include "world/chunk.hpp"
+#include "world/lodTerrain.hpp"
 
 class GLRenderer : public Renderer {
 public:
@@ -50,9 +64,159 @@ public:
 	
 	virtual void setActiveSceneCamera(Camera *camera) override;
 	
+	virtual void setWorld(World *world) override;
+	
+	virtual void executeCommandList(const CommandList &commands) override;
+	
 protected:
+	struct GLChunkMesh {
+		U32 allocation;
+		U32 version;
+		U32 quadCount;
+		U32 translucentQuadCount;
+
+		// The sort generation the translucent quads were last sorted in.
+		U32 sortGeneration;
+		U64 lastFrame;
+
+		GLChunkMesh() : allocation(BufferHeap::INVALID_ALLOCATION), version(0), quadCount(0), translucentQuadCount(0), sortGeneration(0), lastFrame(0) {}
+	};
+
+	struct GLTerrainMesh {
+		U32 allocation;
+		U32 version;
+		U32 vertexCount;
+		U32 indexCount;
+		U64 lastFrame;
+
+		GLTerrainMesh() : allocation(BufferHeap::INVALID_ALLOCATION), version(0), vertexCount(0), indexCount(0), lastFrame(0) {}
+	};
+
+	struct ChunkDraw {
+		ChunkCoord coord;
+		glm::vec3 origin;
+		F32 scale;
+		U32 page;
+		S32 baseVertex;
+		U32 quadCount;
+		bool translucent;
+		bool visible;
+		U64 key;
+	};
+
 	GLuint mGlobalVAO;
+	GLStateCache mState;
 	Camera *mCamera;
+	World *mWorld;
+	GLShaderManager *mShaderManager;
+
+	// Chunk meshes live in the pages of the buffer heap, with a VAO per page
+	// sharing one quad index buffer.
+	GLBufferHeap *mChunkHeap;
+	std::unordered_map<ChunkCoord, GLChunkMesh, ChunkCoordHash> mChunkMeshes;
+	std::unordered_map<LodKey, GLChunkMesh, LodKeyHash> mLodMeshes;
+	U64 mLodFrame;
+	std::vector<GLuint> mChunkPageVAOs;
+	GLuint mQuadIndexBuffer;
+	GLuint mChunkProgram;
+	GLint mViewProjectionLocation;
+	GLint mChunkTransformLocation;
+
+	// Every block texture is a layer of one array, bound once per frame. The
+	// layers start out as placeholders and are streamed in as they load.
+	GLuint mBlockTextures;
+	std::string mTexturePath;
+	ImageLoader mImageLoader;
+	GLTextureUploader mTextureUploader;
+	U64 mTextureStreamStart;
+	bool mTexturesStreaming;
+
+	// Smooth terrain meshes have a heap of their own, every allocation holding
+	// the vertices of a mesh followed by its indices.
+	GLBufferHeap *mTerrainHeap;
+	std::unordered_map<LodKey, GLTerrainMesh, LodKeyHash> mTerrainMeshes;
+	std::vector<GLuint> mTerrainPageVAOs;
+	GLuint mTerrainProgram;
+	GLint mTerrainViewProjectionLocation;
+	GLint mTerrainTransformLocation;
+
+	// Translucent quads are sorted back to front from the camera's chunk when
+	// they are uploaded. Moving into another chunk starts a new generation
+	// and queues every chunk with translucent quads for a re-sort, nearest
+	// first, which is worked off within a budget of quads per frame.
+	ChunkCoord mSortChunk;
+	U32 mSortGeneration;
+	std::vector<ChunkCoord> mSortQueue;
+	U32 mSortQueueCursor;
+	std::vector<ChunkVertex> mSortedVertices;
+	std::vector<U32> mSortScratch;
+
+	ChunkVisibility mVisibility;
+	OcclusionBuffer mOcclusion;
+	RenderQueue mRenderQueue;
+	std::vector<ChunkDraw> mChunkDraws;
+	std::vector<CommandList> mCommandLists;
+	glm::mat4 mViewProjection;
+
+	/**
+	 * Creates the block texture array filled with placeholders and requests
+	 * the texture of every layer from the image loader.
+	 */
+	void createBlockTextures();
+
+	/**
+	 * Queues the block textures that finished loading, generating the ones
+	 * that have no file, and uploads them within the frame's budget.
+	 */
+	void updateBlockTextures();
+
+	/**
+	 * Uploads the meshes that changed since the last frame and frees the ones
+	 * of chunks that are gone. Returns true if anything was uploaded.
+	 */
+	bool updateChunkMeshes();
+
+	/**
+	 * Uploads mesh if it changed since gpuMesh was uploaded. Returns true if
+	 * anything was uploaded.
+	 */
+	bool uploadChunkMesh(GLChunkMesh &gpuMesh, const ChunkMesh *mesh);
+
+	/**
+	 * Sorts the translucent quads of a chunk's mesh for the camera position
+	 * and uploads them over the unsorted ones.
+	 */
+	void sortTranslucentQuads(GLChunkMesh &gpuMesh, const ChunkMesh *mesh, const ChunkCoord &coord);
+
+	/**
+	 * Starts a new sort generation when the camera entered another chunk and
+	 * re-sorts queued chunks until budget quads have been sorted.
+	 */
+	void updateTranslucentSorting(U32 budget);
+
+	/**
+	 * Adds a draw for a chunk or, above level 0, a downsampled node, and one
+	 * for its translucent quads if it has any.
+	 */
+	void addChunkDraw(const GLChunkMesh &mesh, const ChunkCoord &origin, U32 level);
+
+	/**
+	 * Uploads the smooth terrain nodes selected by the world and frees the
+	 * rest. Returns true if anything was uploaded.
+	 */
+	bool updateTerrainMeshes();
+
+	/**
+	 * Draws the smooth terrain, after the opaque chunks as it is further
+	 * away and before the translucent ones that blend over it.
+	 */
+	void renderTerrain();
+
+	/**
+	 * Records the sorted draws [first, last) into commands. Safe to call from
+	 * any thread.
+	 */
+	void recordChunkDraws(CommandList &commands, U32 first, U32 last) const;
 };
 
 #endif // _GRAPHICS_OPENGL_GLRENDERER_HPP_
\ No newline at end of file
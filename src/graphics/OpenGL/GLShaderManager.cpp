@@ -0,0 +1,268 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <vector>
+#include "graphics/OpenGL/GLShaderManager.hpp"
+#include "platform/timer.hpp"
+
+#define SHADER_CACHE_MAGIC 0x43535856 // "VXSC"
+#define SHADER_CACHE_VERSION 1
+
+// FNV-1a
+static U64 hashString(const std::string &string, U64 hash = 14695981039346656037ULL) {
+	for (char c : string) {
+		hash ^= static_cast<U8>(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static bool readFile(const std::string &path, std::string &contents) {
+	FILE *file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	contents.clear();
+	char buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, read);
+	fclose(file);
+	return true;
+}
+
+static GLuint compileShader(GLenum type, const std::string &name, const std::string &source) {
+	const char *sourceString = source.c_str();
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &sourceString, NULL);
+	glCompileShader(shader);
+
+	GLint success;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		GLint length;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+
+		char *log = new char[length];
+		glGetShaderInfoLog(shader, length, &length, log);
+		printf("Error compiling %s shader %s: %s\n", type == GL_VERTEX_SHADER ? "vertex" : "fragment", name.c_str(), log);
+		delete[] log;
+
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static bool checkLinked(GLuint program, const std::string &name, bool printLog) {
+	GLint linked;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked && printLog) {
+		GLint length;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+
+		char *log = new char[length];
+		glGetProgramInfoLog(program, length, &length, log);
+		printf("Error linking program %s: %s\n", name.c_str(), log);
+		delete[] log;
+	}
+	return linked != 0;
+}
+
+GLShaderManager::GLShaderManager(const std::string &shaderPath, const std::string &cachePath) {
+	mShaderPath = shaderPath;
+	mCachePath = cachePath;
+	mCachedCount = 0;
+	mCompiledCount = 0;
+	mLoadTime = 0.0;
+
+	// Program binaries are core since 4.1, the extension covers older
+	// contexts. A driver may still support no binary formats at all.
+	GLint formatCount = 0;
+	if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	mBinaryCache = !mCachePath.empty() && formatCount > 0;
+
+	// A binary is only valid for the exact driver that produced it.
+	mDriverHash = hashString(reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	mDriverHash = hashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), mDriverHash);
+	mDriverHash = hashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), mDriverHash);
+}
+
+GLShaderManager::~GLShaderManager() {
+	for (const auto &pair : mPrograms)
+		glDeleteProgram(pair.second);
+}
+
+GLuint GLShaderManager::getProgram(const std::string &name) {
+	auto pos = mPrograms.find(name);
+	if (pos != mPrograms.end())
+		return pos->second;
+
+	Timer timer;
+	timer.start();
+	GLuint program = loadProgram(name);
+	timer.stop();
+	mLoadTime += timer.getDelta();
+
+	if (program != 0)
+		mPrograms[name] = program;
+	return program;
+}
+
+void GLShaderManager::printStats() const {
+	printf("Shaders: %u programs loaded in %.3f ms, %u from the binary cache, %u compiled%s\n", mCachedCount + mCompiledCount, mLoadTime * 1000.0, mCachedCount, mCompiledCount, mBinaryCache ? "" : " (binary cache unavailable)");
+}
+
+GLuint GLShaderManager::loadProgram(const std::string &name) {
+	std::string vertSource;
+	std::string fragSource;
+	if (!readFile(mShaderPath + name + ".vert", vertSource) || !readFile(mShaderPath + name + ".frag", fragSource)) {
+		printf("Unable to read the sources of shader %s from %s\n", name.c_str(), mShaderPath.c_str());
+		return 0;
+	}
+
+	const U64 sourceHash = hashString(fragSource, hashString(vertSource));
+	if (mBinaryCache) {
+		GLuint program = loadBinary(name, sourceHash);
+		if (program != 0) {
+			++mCachedCount;
+			return program;
+		}
+	}
+
+	GLuint vert = compileShader(GL_VERTEX_SHADER, name, vertSource);
+	GLuint frag = compileShader(GL_FRAGMENT_SHADER, name, fragSource);
+	if (vert == 0 || frag == 0) {
+		glDeleteShader(vert);
+		glDeleteShader(frag);
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	if (mBinaryCache)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glAttachShader(program, vert);
+	glAttachShader(program, frag);
+	glLinkProgram(program);
+	glDetachShader(program, vert);
+	glDetachShader(program, frag);
+	glDeleteShader(vert);
+	glDeleteShader(frag);
+
+	if (!checkLinked(program, name, true)) {
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	if (mBinaryCache)
+		saveBinary(name, sourceHash, program);
+	++mCompiledCount;
+	return program;
+}
+
+GLuint GLShaderManager::loadBinary(const std::string &name, U64 sourceHash) {
+	FILE *file = fopen((mCachePath + name + ".bin").c_str(), "rb");
+	if (file == nullptr)
+		return 0;
+
+	U32 magic = 0;
+	U32 version = 0;
+	U64 fileSourceHash = 0;
+	U64 fileDriverHash = 0;
+	U32 format = 0;
+	U32 length = 0;
+	bool valid = fread(&magic, sizeof(magic), 1, file) == 1 &&
+		fread(&version, sizeof(version), 1, file) == 1 &&
+		fread(&fileSourceHash, sizeof(fileSourceHash), 1, file) == 1 &&
+		fread(&fileDriverHash, sizeof(fileDriverHash), 1, file) == 1 &&
+		fread(&format, sizeof(format), 1, file) == 1 &&
+		fread(&length, sizeof(length), 1, file) == 1;
+
+	// Anything stale is simply recompiled and overwritten.
+	valid = valid && magic == SHADER_CACHE_MAGIC && version == SHADER_CACHE_VERSION && fileSourceHash == sourceHash && fileDriverHash == mDriverHash && length > 0;
+
+	std::vector<U8> binary;
+	if (valid) {
+		binary.resize(length);
+		valid = fread(binary.data(), length, 1, file) == 1;
+	}
+	fclose(file);
+	if (!valid)
+		return 0;
+
+	// The driver may still reject the binary, for instance after an update
+	// that didn't change its version string.
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, format, binary.data(), length);
+	if (!checkLinked(program, name, false)) {
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void GLShaderManager::saveBinary(const std::string &name, U64 sourceHash, GLuint program) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<U8> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	const std::string path = mCachePath + name + ".bin";
+	FILE *file = fopen(path.c_str(), "wb");
+	if (file == nullptr) {
+		printf("Unable to write shader cache %s\n", path.c_str());
+		return;
+	}
+
+	U32 magic = SHADER_CACHE_MAGIC;
+	U32 version = SHADER_CACHE_VERSION;
+	U32 format32 = format;
+	U32 length32 = static_cast<U32>(length);
+	bool success = fwrite(&magic, sizeof(magic), 1, file) == 1 &&
+		fwrite(&version, sizeof(version), 1, file) == 1 &&
+		fwrite(&sourceHash, sizeof(sourceHash), 1, file) == 1 &&
+		fwrite(&mDriverHash, sizeof(mDriverHash), 1, file) == 1 &&
+		fwrite(&format32, sizeof(format32), 1, file) == 1 &&
+		fwrite(&length32, sizeof(length32), 1, file) == 1 &&
+		fwrite(binary.data(), length, 1, file) == 1;
+	fclose(file);
+
+	if (!success) {
+		// Don't leave a torn binary behind.
+		remove(path.c_str());
+		printf("Unable to write shader cache %s\n", path.c_str());
+	}
+}
@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_OPENGL_GLSHADERMANAGER_HPP_
+#define _GRAPHICS_OPENGL_GLSHADERMANAGER_HPP_
+
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+#include "core/types.hpp"
+
+/**
+ * Loads shader programs from <name>.vert and <name>.frag in the shader
+ * directory.
+ *
+ * Linked programs are cached on disk with glGetProgramBinary, keyed by a hash
+ * of their sources and of the driver that produced them. A later run loads
+ * the binary instead of compiling, and falls back to compiling when the
+ * sources or the driver changed or the driver rejects the binary.
+ */
+class GLShaderManager {
+public:
+	/**
+	 * @param shaderPath Directory of the shader sources, with a trailing
+	 *   separator.
+	 * @param cachePath Directory the program binaries are kept in, with a
+	 *   trailing separator. An empty path disables the cache.
+	 */
+	GLShaderManager(const std::string &shaderPath, const std::string &cachePath);
+	~GLShaderManager();
+
+	/**
+	 * Returns the program called name, loading it on first use. The manager
+	 * owns the program. Returns 0 if the program can't be built.
+	 */
+	GLuint getProgram(const std::string &name);
+
+	/**
+	 * Prints how long loading programs took and how many came from the cache.
+	 */
+	void printStats() const;
+
+private:
+	std::string mShaderPath;
+	std::string mCachePath;
+	bool mBinaryCache;
+	U64 mDriverHash;
+
+	std::unordered_map<std::string, GLuint> mPrograms;
+	U32 mCachedCount;
+	U32 mCompiledCount;
+	F64 mLoadTime;
+
+	GLuint loadProgram(const std::string &name);
+	GLuint loadBinary(const std::string &name, U64 sourceHash);
+	void saveBinary(const std::string &name, U64 sourceHash, GLuint program);
+};
+
+#endif // _GRAPHICS_OPENGL_GLSHADERMANAGER_HPP_
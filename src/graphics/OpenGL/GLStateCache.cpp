@@ -0,0 +1,189 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include "graphics/OpenGL/GLStateCache.hpp"
+
+// Never a valid name, so the first call after invalidate() is always issued.
+#define UNKNOWN_STATE 0xFFFFFFFF
+
+GLStateCache::GLStateCache() {
+	mFrameStats.issued = 0;
+	mFrameStats.filtered = 0;
+	mLastFrameStats = mFrameStats;
+	mTotalStats = mFrameStats;
+	mFrameCount = 0;
+	invalidate();
+}
+
+void GLStateCache::invalidate() {
+	mProgram = UNKNOWN_STATE;
+	mVertexArray = UNKNOWN_STATE;
+	mArrayBuffer = UNKNOWN_STATE;
+	mUniformBuffer = UNKNOWN_STATE;
+	for (U32 i = 0; i < GL_STATE_UNIFORM_BUFFER_BINDINGS; ++i)
+		mUniformBufferBindings[i] = UNKNOWN_STATE;
+	mBlend = UNKNOWN_STATE;
+	mCullFace = UNKNOWN_STATE;
+	mDepthMask = UNKNOWN_STATE;
+	mUniforms.clear();
+	mBlockBindings.clear();
+}
+
+void GLStateCache::useProgram(GLuint program) {
+	if (filter(program == mProgram))
+		return;
+	glUseProgram(program);
+	mProgram = program;
+}
+
+void GLStateCache::bindVertexArray(GLuint vao) {
+	if (filter(vao == mVertexArray))
+		return;
+	glBindVertexArray(vao);
+	mVertexArray = vao;
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+	GLuint *binding = nullptr;
+	if (target == GL_ARRAY_BUFFER)
+		binding = &mArrayBuffer;
+	else if (target == GL_UNIFORM_BUFFER)
+		binding = &mUniformBuffer;
+
+	if (filter(binding != nullptr && *binding == buffer))
+		return;
+	glBindBuffer(target, buffer);
+	if (binding != nullptr)
+		*binding = buffer;
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+	bool tracked = target == GL_UNIFORM_BUFFER && index < GL_STATE_UNIFORM_BUFFER_BINDINGS;
+	if (filter(tracked && mUniformBufferBindings[index] == buffer))
+		return;
+	glBindBufferBase(target, index, buffer);
+
+	// Binding an indexed target binds the generic target as well.
+	if (target == GL_UNIFORM_BUFFER)
+		mUniformBuffer = buffer;
+	if (tracked)
+		mUniformBufferBindings[index] = buffer;
+}
+
+void GLStateCache::uniformBlockBinding(GLuint program, GLuint blockIndex, GLuint binding) {
+	auto pos = mBlockBindings.find(getKey(program, blockIndex));
+	if (filter(pos != mBlockBindings.end() && pos->second == binding))
+		return;
+	glUniformBlockBinding(program, blockIndex, binding);
+	mBlockBindings[getKey(program, blockIndex)] = binding;
+}
+
+void GLStateCache::setEnabled(GLenum capability, bool enabled) {
+	GLuint *state = nullptr;
+	if (capability == GL_BLEND)
+		state = &mBlend;
+	else if (capability == GL_CULL_FACE)
+		state = &mCullFace;
+
+	if (filter(state != nullptr && *state == static_cast<GLuint>(enabled)))
+		return;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	if (state != nullptr)
+		*state = enabled;
+}
+
+void GLStateCache::depthMask(bool write) {
+	if (filter(mDepthMask == static_cast<GLuint>(write)))
+		return;
+	glDepthMask(write ? GL_TRUE : GL_FALSE);
+	mDepthMask = write;
+}
+
+void GLStateCache::uniform3fv(GLint location, const F32 *value) {
+	if (setUniform(location, value, 3))
+		glUniform3fv(location, 1, value);
+}
+
+void GLStateCache::uniform4fv(GLint location, const F32 *value) {
+	if (setUniform(location, value, 4))
+		glUniform4fv(location, 1, value);
+}
+
+void GLStateCache::uniformMatrix4fv(GLint location, const F32 *value) {
+	if (setUniform(location, value, 16))
+		glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+void GLStateCache::beginFrame() {
+	if (mFrameStats.issued + mFrameStats.filtered > 0)
+		++mFrameCount;
+	mLastFrameStats = mFrameStats;
+	mFrameStats.issued = 0;
+	mFrameStats.filtered = 0;
+}
+
+void GLStateCache::printStats() const {
+	const U64 calls = mTotalStats.issued + mTotalStats.filtered;
+	const F64 frames = mFrameCount > 0 ? static_cast<F64>(mFrameCount) : 1.0;
+	printf("GL state cache: %llu calls issued, %llu filtered (%.1f%%) over %llu frames\n", static_cast<unsigned long long>(mTotalStats.issued), static_cast<unsigned long long>(mTotalStats.filtered), calls > 0 ? mTotalStats.filtered * 100.0 / calls : 0.0, static_cast<unsigned long long>(mFrameCount));
+	printf("   %.1f issued and %.1f filtered per frame, last frame %llu issued %llu filtered\n", mTotalStats.issued / frames, mTotalStats.filtered / frames, static_cast<unsigned long long>(mLastFrameStats.issued), static_cast<unsigned long long>(mLastFrameStats.filtered));
+}
+
+bool GLStateCache::filter(bool redundant) {
+	if (redundant) {
+		++mFrameStats.filtered;
+		++mTotalStats.filtered;
+	} else {
+		++mFrameStats.issued;
+		++mTotalStats.issued;
+	}
+	return redundant;
+}
+
+bool GLStateCache::setUniform(GLint location, const F32 *value, U32 count) {
+	// Uniforms of programs that aren't bound through the cache can't be told
+	// apart, so they are always set.
+	if (location < 0 || mProgram == UNKNOWN_STATE)
+		return !filter(false);
+
+	const U64 key = getKey(mProgram, static_cast<U32>(location));
+	auto pos = mUniforms.find(key);
+	if (filter(pos != mUniforms.end() && memcmp(pos->second.data, value, count * sizeof(F32)) == 0))
+		return false;
+
+	UniformValue &cached = mUniforms[key];
+	memcpy(cached.data, value, count * sizeof(F32));
+	return true;
+}
@@ -0,0 +1,140 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_OPENGL_GLSTATECACHE_HPP_
+#define _GRAPHICS_OPENGL_GLSTATECACHE_HPP_
+
+#include <unordered_map>
+#include <glad/glad.h>
+#include "core/types.hpp"
+
+#define GL_STATE_UNIFORM_BUFFER_BINDINGS 16
+
+/**
+ * Shadows the GL state the renderer changes and drops calls that would set
+ * it to the value it already has.
+ *
+ * Every change of the tracked state has to go through the cache, or the
+ * cache must be invalidated afterwards.
+ */
+class GLStateCache {
+public:
+	struct Stats {
+		/**
+		 * Calls passed on to GL and calls dropped as redundant.
+		 */
+		U64 issued;
+		U64 filtered;
+	};
+
+	GLStateCache();
+
+	/**
+	 * Forgets all of the tracked state, so the next call of each kind is
+	 * issued again.
+	 */
+	void invalidate();
+
+	void useProgram(GLuint program);
+	void bindVertexArray(GLuint vao);
+
+	/**
+	 * Binds a buffer to GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER. Other targets are
+	 * passed straight through.
+	 */
+	void bindBuffer(GLenum target, GLuint buffer);
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	void uniformBlockBinding(GLuint program, GLuint blockIndex, GLuint binding);
+
+	/**
+	 * Turns GL_BLEND or GL_CULL_FACE on or off. Other capabilities are passed
+	 * straight through.
+	 */
+	void setEnabled(GLenum capability, bool enabled);
+	void depthMask(bool write);
+
+	/**
+	 * Set uniforms of the current program.
+	 */
+	void uniform3fv(GLint location, const F32 *value);
+	void uniform4fv(GLint location, const F32 *value);
+	void uniformMatrix4fv(GLint location, const F32 *value);
+
+	/**
+	 * Starts counting the calls of a new frame.
+	 */
+	void beginFrame();
+
+	const Stats& getFrameStats() const {
+		return mFrameStats;
+	}
+
+	const Stats& getTotalStats() const {
+		return mTotalStats;
+	}
+
+	U64 getFrameCount() const {
+		return mFrameCount;
+	}
+
+	void printStats() const;
+
+private:
+	struct UniformValue {
+		F32 data[16];
+	};
+
+	GLuint mProgram;
+	GLuint mVertexArray;
+	GLuint mArrayBuffer;
+	GLuint mUniformBuffer;
+	GLuint mUniformBufferBindings[GL_STATE_UNIFORM_BUFFER_BINDINGS];
+	GLuint mBlend;
+	GLuint mCullFace;
+	GLuint mDepthMask;
+
+	// Keyed by program and location or block index.
+	std::unordered_map<U64, UniformValue> mUniforms;
+	std::unordered_map<U64, GLuint> mBlockBindings;
+
+	Stats mFrameStats;
+	Stats mLastFrameStats;
+	Stats mTotalStats;
+	U64 mFrameCount;
+
+	bool filter(bool redundant);
+	bool setUniform(GLint location, const F32 *value, U32 count);
+
+	static U64 getKey(GLuint program, U32 index) {
+		return (static_cast<U64>(program) << 32) | index;
+	}
+};
+
+#endif // _GRAPHICS_OPENGL_GLSTATECACHE_HPP_
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "graphics/OpenGL/GLTextureUploader.hpp"
+
+GLTextureUploader::GLTextureUploader() {
+	mBuffer = 0;
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+GLTextureUploader::~GLTextureUploader() {
+	shutdown();
+}
+
+void GLTextureUploader::shutdown() {
+	mUploads.clear();
+	if (mBuffer != 0) {
+		glDeleteBuffers(1, &mBuffer);
+		mBuffer = 0;
+	}
+}
+
+void GLTextureUploader::queue(GLuint texture, U32 layer, Image &&image) {
+	Upload upload;
+	upload.texture = texture;
+	upload.layer = layer;
+	upload.nextRow = 0;
+	upload.image = std::move(image);
+	mUploads.push_back(std::move(upload));
+}
+
+U32 GLTextureUploader::update(U32 budget) {
+	if (mUploads.empty())
+		return 0;
+
+	// Slice the queued images up to the budget, in order.
+	mSlices.clear();
+	U32 size = 0;
+	for (U32 i = 0; i < mUploads.size(); ++i) {
+		const Upload &upload = mUploads[i];
+		const U32 rowSize = upload.image.width * 4;
+		const U32 remaining = upload.image.height - upload.nextRow;
+		U32 rows = std::min(remaining, (budget - std::min(budget, size)) / rowSize);
+		if (rows == 0 && size == 0)
+			rows = 1;
+		if (rows == 0)
+			break;
+
+		mSlices.push_back({ i, rows, size });
+		size += rows * rowSize;
+		if (rows < remaining)
+			break;
+	}
+
+	if (mBuffer == 0)
+		glGenBuffers(1, &mBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+
+	// Orphan the storage of the previous frame, which the GPU may still be
+	// reading from, rather than waiting for it.
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	U8 *mapped = static_cast<U8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (mapped == nullptr) {
+		printf("Unable to map the texture upload buffer\n");
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return 0;
+	}
+	for (const Slice &slice : mSlices) {
+		const Upload &upload = mUploads[slice.upload];
+		const U32 rowSize = upload.image.width * 4;
+		memcpy(mapped + slice.offset, upload.image.pixels.data() + upload.nextRow * rowSize, slice.rows * rowSize);
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	for (const Slice &slice : mSlices) {
+		Upload &upload = mUploads[slice.upload];
+		glBindTexture(GL_TEXTURE_2D_ARRAY, upload.texture);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, upload.nextRow, upload.layer, upload.image.width, slice.rows, 1, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)(size_t)slice.offset);
+		upload.nextRow += slice.rows;
+		++mStats.slices;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	mStats.bytes += size;
+
+	U32 completed = 0;
+	while (!mUploads.empty() && mUploads.front().nextRow == mUploads.front().image.height) {
+		mUploads.pop_front();
+		++completed;
+	}
+	mStats.images += completed;
+	return completed;
+}
+
+void GLTextureUploader::printStats() const {
+	printf("Texture uploads: %llu images, %llu bytes in %llu slices\n", static_cast<unsigned long long>(mStats.images), static_cast<unsigned long long>(mStats.bytes), static_cast<unsigned long long>(mStats.slices));
+}
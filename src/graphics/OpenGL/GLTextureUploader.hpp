@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_OPENGL_GLTEXTUREUPLOADER_HPP_
+#define _GRAPHICS_OPENGL_GLTEXTUREUPLOADER_HPP_
+
+#include <deque>
+#include <vector>
+#include <glad/glad.h>
+#include "core/types.hpp"
+#include "graphics/imageLoader.hpp"
+
+/**
+ * Streams images into layers of texture arrays through a pixel buffer object,
+ * a budget of bytes per frame at most, so a burst of finished loads is spread
+ * over several frames instead of stalling one. Large images are uploaded a
+ * slice of rows at a time.
+ */
+class GLTextureUploader {
+public:
+	struct Stats {
+		U64 bytes;
+		U64 slices;
+		U64 images;
+	};
+
+	GLTextureUploader();
+	~GLTextureUploader();
+
+	/**
+	 * Drops the queued images and deletes the buffer, while the context is
+	 * still current.
+	 */
+	void shutdown();
+
+	/**
+	 * Queues image for the given layer of a GL_TEXTURE_2D_ARRAY, which must be
+	 * at least as large as the image.
+	 */
+	void queue(GLuint texture, U32 layer, Image &&image);
+
+	/**
+	 * Uploads up to budget bytes of the queued images, always at least a row.
+	 * Returns the amount of images that were completed, the caller updates
+	 * the mipmaps of their textures. Changes the GL_TEXTURE_2D_ARRAY binding.
+	 */
+	U32 update(U32 budget);
+
+	bool isIdle() const {
+		return mUploads.empty();
+	}
+
+	const Stats& getStats() const {
+		return mStats;
+	}
+
+	void printStats() const;
+
+private:
+	struct Upload {
+		GLuint texture;
+		U32 layer;
+		U32 nextRow;
+		Image image;
+	};
+
+	struct Slice {
+		U32 upload;
+		U32 rows;
+		U32 offset;
+	};
+
+	GLuint mBuffer;
+	std::deque<Upload> mUploads;
+	std::vector<Slice> mSlices;
+	Stats mStats;
+};
+
+#endif // _GRAPHICS_OPENGL_GLTEXTUREUPLOADER_HPP_
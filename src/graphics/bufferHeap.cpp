@@ -0,0 +1,218 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <assert.h>
+#include <chrono>
+#include "graphics/bufferHeap.hpp"
+
+const U32 BufferHeap::INVALID_ALLOCATION;
+
+BufferHeap::BufferHeap() {
+	mPendingFreeBytes = 0;
+	mFrame = 0;
+	mAllocationCount = 0;
+	mAllocationTime = 0.0;
+	mMaxAllocationTime = 0.0;
+	mCompactionMoves = 0;
+}
+
+BufferHeap::~BufferHeap() {
+
+}
+
+U32 BufferHeap::allocate(U32 size) {
+	auto start = std::chrono::steady_clock::now();
+
+	U32 page = 0;
+	U32 range = RangeAllocator::INVALID_RANGE;
+	for (; page < mPages.size(); ++page) {
+		range = mPages[page].allocate(size);
+		if (range != RangeAllocator::INVALID_RANGE)
+			break;
+	}
+
+	if (range == RangeAllocator::INVALID_RANGE) {
+		U32 pageSize = BUFFER_HEAP_PAGE_SIZE;
+		if (size > pageSize)
+			pageSize = (size + RangeAllocator::GRANULARITY - 1) / RangeAllocator::GRANULARITY * RangeAllocator::GRANULARITY;
+
+		page = static_cast<U32>(mPages.size());
+		mPages.push_back(RangeAllocator(pageSize));
+		mOwners.push_back(std::vector<U32>());
+		createPage(page, pageSize);
+		range = mPages[page].allocate(size);
+		assert(range != RangeAllocator::INVALID_RANGE);
+	}
+
+	U32 allocation;
+	if (!mFreeAllocations.empty()) {
+		allocation = mFreeAllocations.back();
+		mFreeAllocations.pop_back();
+	} else {
+		allocation = static_cast<U32>(mAllocations.size());
+		mAllocations.push_back(Allocation());
+	}
+	mAllocations[allocation].page = page;
+	mAllocations[allocation].range = range;
+	setOwner(page, range, allocation);
+
+	F64 elapsed = std::chrono::duration<F64>(std::chrono::steady_clock::now() - start).count();
+	++mAllocationCount;
+	mAllocationTime += elapsed;
+	if (elapsed > mMaxAllocationTime)
+		mMaxAllocationTime = elapsed;
+	return allocation;
+}
+
+void BufferHeap::free(U32 allocation) {
+	const Allocation &a = mAllocations[allocation];
+	setOwner(a.page, a.range, INVALID_ALLOCATION);
+
+	PendingFree pending;
+	pending.page = a.page;
+	pending.range = a.range;
+	pending.frame = mFrame;
+	mPendingFrees.push_back(pending);
+	mPendingFreeBytes += mPages[a.page].getSize(a.range);
+
+	mFreeAllocations.push_back(allocation);
+}
+
+void BufferHeap::upload(U32 allocation, const void *data, U32 size, U32 offset) {
+	const Allocation &a = mAllocations[allocation];
+	assert(offset + size <= mPages[a.page].getSize(a.range));
+	writeRange(a.page, mPages[a.page].getOffset(a.range) + offset, data, size);
+}
+
+void BufferHeap::advanceFrame() {
+	++mFrame;
+}
+
+void BufferHeap::releaseFrames(U64 completedFrame) {
+	// Frees are queued in frame order.
+	size_t released = 0;
+	for (; released < mPendingFrees.size() && mPendingFrees[released].frame <= completedFrame; ++released) {
+		const PendingFree &pending = mPendingFrees[released];
+		mPendingFreeBytes -= mPages[pending.page].getSize(pending.range);
+		mPages[pending.page].free(pending.range);
+	}
+	mPendingFrees.erase(mPendingFrees.begin(), mPendingFrees.begin() + released);
+}
+
+U32 BufferHeap::compact(U32 maxMoves) {
+	U32 moves = 0;
+	for (U32 page = 0; page < mPages.size() && moves < maxMoves; ++page) {
+		RangeAllocator &pageAllocator = mPages[page];
+
+		// Walk down from the end of the page, moving allocations into free
+		// ranges below them.
+		U32 range = pageAllocator.getLastRange();
+		while (range != RangeAllocator::INVALID_RANGE && moves < maxMoves) {
+			U32 previous = pageAllocator.getPreviousRange(range);
+
+			// Ranges that are waiting on their fence can't be moved.
+			const U32 allocation = mOwners[page][range];
+			if (allocation == INVALID_ALLOCATION) {
+				range = previous;
+				continue;
+			}
+
+			const U32 size = pageAllocator.getSize(range);
+			const U32 offset = pageAllocator.getOffset(range);
+			U32 target = pageAllocator.allocate(size);
+			if (target == RangeAllocator::INVALID_RANGE)
+				break;
+			if (pageAllocator.getOffset(target) > offset) {
+				pageAllocator.free(target);
+				break;
+			}
+
+			// Draws of this frame may still read the old range, so it is freed
+			// like any other range.
+			copyRange(page, offset, pageAllocator.getOffset(target), size);
+			mAllocations[allocation].range = target;
+			setOwner(page, target, allocation);
+			setOwner(page, range, INVALID_ALLOCATION);
+
+			PendingFree pending;
+			pending.page = page;
+			pending.range = range;
+			pending.frame = mFrame;
+			mPendingFrees.push_back(pending);
+			mPendingFreeBytes += size;
+			++moves;
+
+			range = previous;
+		}
+	}
+	mCompactionMoves += moves;
+	return moves;
+}
+
+BufferHeap::Stats BufferHeap::getStats() const {
+	Stats stats;
+	stats.pageCount = static_cast<U32>(mPages.size());
+	stats.capacity = 0;
+	stats.used = 0;
+	stats.pendingFree = mPendingFreeBytes;
+	stats.allocationCount = mAllocationCount;
+	stats.averageAllocationMicroseconds = mAllocationCount > 0 ? mAllocationTime / mAllocationCount * 1000000.0 : 0.0;
+	stats.maxAllocationMicroseconds = mMaxAllocationTime * 1000000.0;
+	stats.compactionMoves = mCompactionMoves;
+
+	// The share of free space that can't be handed out as part of the largest
+	// free range of its page.
+	U64 freeSize = 0;
+	U64 largestFree = 0;
+	for (const RangeAllocator &page : mPages) {
+		stats.capacity += page.getCapacity();
+		stats.used += page.getCapacity() - page.getFreeSize();
+		freeSize += page.getFreeSize();
+		largestFree += page.getLargestFreeRange();
+	}
+	stats.used -= mPendingFreeBytes;
+	stats.fragmentation = freeSize > 0 ? 1.0f - static_cast<F32>(largestFree) / static_cast<F32>(freeSize) : 0.0f;
+	return stats;
+}
+
+void BufferHeap::printStats() const {
+	Stats stats = getStats();
+	printf("Buffer heap: %u pages, %.2f / %.2f MB used, %.2f MB waiting on fences\n", stats.pageCount, stats.used / 1048576.0, stats.capacity / 1048576.0, stats.pendingFree / 1048576.0);
+	printf("   fragmentation %.1f%%, %llu compaction moves\n", stats.fragmentation * 100.0f, static_cast<unsigned long long>(stats.compactionMoves));
+	printf("   %llu allocations, %.3f us average, %.3f us max\n", static_cast<unsigned long long>(stats.allocationCount), stats.averageAllocationMicroseconds, stats.maxAllocationMicroseconds);
+}
+
+void BufferHeap::setOwner(U32 page, U32 range, U32 allocation) {
+	std::vector<U32> &owners = mOwners[page];
+	if (range >= owners.size())
+		owners.resize(range + 1, INVALID_ALLOCATION);
+	owners[range] = allocation;
+}
@@ -0,0 +1,172 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_BUFFERHEAP_HPP_
+#define _GRAPHICS_BUFFERHEAP_HPP_
+
+#include <vector>
+#include "core/types.hpp"
+#include "core/rangeAllocator.hpp"
+
+#define BUFFER_HEAP_PAGE_SIZE (16 << 20)
+
+/**
+ * Sub-allocates variable sized ranges out of a few large GPU buffers, the
+ * pages, so that streaming chunk meshes in and out doesn't create and delete
+ * a buffer per mesh.
+ *
+ * The GPU may still be reading a range for a few frames after it is freed, so
+ * freed ranges only go back to the page allocator once the backend reports
+ * that the frame they were freed in has completed. On idle frames compact()
+ * moves allocations from the end of a page into free ranges nearer the start,
+ * which keeps the free space of each page in one piece.
+ *
+ * Allocations are referred to by handles that stay valid when compaction moves
+ * them, so the page and offset must be looked up again every frame.
+ */
+class BufferHeap {
+public:
+	static const U32 INVALID_ALLOCATION = 0xFFFFFFFF;
+
+	struct Stats {
+		U32 pageCount;
+		U64 capacity;
+		U64 used;
+		U64 pendingFree;
+		F32 fragmentation;
+		U64 allocationCount;
+		F64 averageAllocationMicroseconds;
+		F64 maxAllocationMicroseconds;
+		U64 compactionMoves;
+	};
+
+	BufferHeap();
+	virtual ~BufferHeap();
+
+	/**
+	 * Returns the handle of a range of at least size bytes, adding a page when
+	 * none has enough free space.
+	 */
+	U32 allocate(U32 size);
+
+	/**
+	 * Frees the allocation once the GPU is done with the current frame.
+	 */
+	void free(U32 allocation);
+
+	/**
+	 * Writes size bytes of data offset bytes into the allocation.
+	 */
+	void upload(U32 allocation, const void *data, U32 size, U32 offset = 0);
+
+	U32 getPage(U32 allocation) const {
+		return mAllocations[allocation].page;
+	}
+
+	U32 getOffset(U32 allocation) const {
+		return mPages[mAllocations[allocation].page].getOffset(mAllocations[allocation].range);
+	}
+
+	U32 getPageCount() const {
+		return static_cast<U32>(mPages.size());
+	}
+
+	/**
+	 * The frame that frees are currently tagged with.
+	 */
+	U64 getFrame() const {
+		return mFrame;
+	}
+
+	/**
+	 * Called by the backend once it has submitted the fence of the current
+	 * frame.
+	 */
+	void advanceFrame();
+
+	/**
+	 * Called by the backend when the fence of completedFrame has signaled.
+	 * Returns every range freed up to and including that frame to its page.
+	 */
+	void releaseFrames(U64 completedFrame);
+
+	/**
+	 * Moves up to maxMoves allocations towards the start of their page. Returns
+	 * the amount of allocations moved.
+	 */
+	U32 compact(U32 maxMoves);
+
+	Stats getStats() const;
+	void printStats() const;
+
+protected:
+	/**
+	 * Creates the backing buffer of a new page.
+	 */
+	virtual void createPage(U32 page, U32 size) = 0;
+	virtual void writeRange(U32 page, U32 offset, const void *data, U32 size) = 0;
+
+	/**
+	 * Copies a range within a page. The ranges never overlap.
+	 */
+	virtual void copyRange(U32 page, U32 srcOffset, U32 dstOffset, U32 size) = 0;
+
+private:
+	struct Allocation {
+		U32 page;
+		U32 range;
+	};
+
+	struct PendingFree {
+		U32 page;
+		U32 range;
+		U64 frame;
+	};
+
+	std::vector<RangeAllocator> mPages;
+
+	// The allocation owning each range of each page, by range handle.
+	std::vector<std::vector<U32>> mOwners;
+
+	std::vector<Allocation> mAllocations;
+	std::vector<U32> mFreeAllocations;
+	std::vector<PendingFree> mPendingFrees;
+	U64 mPendingFreeBytes;
+	U64 mFrame;
+
+	U64 mAllocationCount;
+	F64 mAllocationTime;
+	F64 mMaxAllocationTime;
+	U64 mCompactionMoves;
+
+	void setOwner(U32 page, U32 range, U32 allocation);
+};
+
+#endif // _GRAPHICS_BUFFERHEAP_HPP_
@@ -0,0 +1,190 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "graphics/chunkVisibility.hpp"
+#include "core/aabb.hpp"
+#include "world/world.hpp"
+
+#define NO_ENTRY_FACE 0xFF
+#define ALL_FACES ((1 << FACE_COUNT) - 1)
+
+// Chunk coordinate offset across each face.
+static const S32 sFaceOffsets[FACE_COUNT][3] = {
+	{ -1, 0, 0 }, { 1, 0, 0 },
+	{ 0, -1, 0 }, { 0, 1, 0 },
+	{ 0, 0, -1 }, { 0, 0, 1 }
+};
+
+ChunkVisibility::ChunkVisibility() {
+	mMin = { 0, 0, 0 };
+	mSizeX = 0;
+	mSizeY = 0;
+	mSizeZ = 0;
+	mEnabled = false;
+	memset(&mTotal, 0, sizeof(mTotal));
+	mReachedCount = 0;
+	mTested = 0;
+	mRejected = 0;
+	mFrameCount = 0;
+}
+
+void ChunkVisibility::update(const World *world, const Frustum &frustum, const glm::vec3 &cameraPosition) {
+	if (mTested > 0) {
+		const Stats frame = getFrameStats();
+		mTotal.reached += frame.reached;
+		mTotal.tested += frame.tested;
+		mTotal.rejected += frame.rejected;
+		++mFrameCount;
+	}
+	mReachedCount = 0;
+	mTested = 0;
+	mRejected = 0;
+	mEnabled = false;
+
+	const World::ChunkMap &chunks = world->getChunks();
+	if (chunks.empty())
+		return;
+
+	// Lay the loaded chunks out in a dense grid with a border of air.
+	ChunkCoord min = chunks.begin()->first;
+	ChunkCoord max = min;
+	for (const auto &pair : chunks) {
+		min.x = std::min(min.x, pair.first.x);
+		min.y = std::min(min.y, pair.first.y);
+		min.z = std::min(min.z, pair.first.z);
+		max.x = std::max(max.x, pair.first.x);
+		max.y = std::max(max.y, pair.first.y);
+		max.z = std::max(max.z, pair.first.z);
+	}
+	mMin = { min.x - 1, min.y - 1, min.z - 1 };
+	mSizeX = max.x - min.x + 3;
+	mSizeY = max.y - min.y + 3;
+	mSizeZ = max.z - min.z + 3;
+
+	const ChunkCoord camera = World::getChunkCoord(glm::ivec3(glm::floor(cameraPosition)));
+	const S32 start = getCell(camera);
+	if (start < 0)
+		return;
+
+	const size_t cellCount = static_cast<size_t>(mSizeX) * mSizeY * mSizeZ;
+	mGrid.assign(cellCount, nullptr);
+	mReached.assign(cellCount, 0);
+	for (const auto &pair : chunks)
+		mGrid[getCell(pair.first)] = pair.second;
+
+	// The camera's chunk is left through the faces its pocket of air reaches.
+	// Inside an opaque block the camera sees nothing but the chunk it's in.
+	U32 startFaces = ALL_FACES;
+	if (mGrid[start] != nullptr) {
+		const glm::ivec3 local = World::getLocalPosition(glm::ivec3(glm::floor(cameraPosition)));
+		startFaces = mGrid[start]->getFacesReachableFrom(local.x, local.y, local.z);
+	}
+
+	mEnabled = true;
+	mQueue.clear();
+	mQueue.push_back({ static_cast<U32>(start), NO_ENTRY_FACE, 0 });
+	mReached[start] = 1;
+	for (size_t i = 0; i < mQueue.size(); ++i) {
+		const Step step = mQueue[i];
+		const Chunk *chunk = mGrid[step.cell];
+		const S32 x = static_cast<S32>(step.cell) % mSizeX;
+		const S32 z = (static_cast<S32>(step.cell) / mSizeX) % mSizeZ;
+		const S32 y = static_cast<S32>(step.cell) / (mSizeX * mSizeZ);
+
+		for (U32 face = 0; face < FACE_COUNT; ++face) {
+			// Going back the way we came can't reveal anything new.
+			if (step.directions & (1 << (face ^ 1)))
+				continue;
+			if (step.entryFace == NO_ENTRY_FACE) {
+				if (!(startFaces & (1 << face)))
+					continue;
+			} else if (chunk != nullptr && !chunk->canSeeThrough(step.entryFace, face)) {
+				continue;
+			}
+
+			const S32 nx = x + sFaceOffsets[face][0];
+			const S32 ny = y + sFaceOffsets[face][1];
+			const S32 nz = z + sFaceOffsets[face][2];
+			if (nx < 0 || ny < 0 || nz < 0 || nx >= mSizeX || ny >= mSizeY || nz >= mSizeZ)
+				continue;
+
+			const U32 cell = static_cast<U32>((ny * mSizeZ + nz) * mSizeX + nx);
+			if (mReached[cell])
+				continue;
+
+			const glm::vec3 origin = glm::vec3(mMin.x + nx, mMin.y + ny, mMin.z + nz) * static_cast<F32>(CHUNK_SIZE);
+			if (!frustum.intersects(AABB(origin, origin + glm::vec3(static_cast<F32>(CHUNK_SIZE)))))
+				continue;
+
+			mReached[cell] = 1;
+			mQueue.push_back({ cell, static_cast<U8>(face ^ 1), static_cast<U8>(step.directions | (1 << face)) });
+		}
+	}
+	mReachedCount = static_cast<U32>(mQueue.size());
+}
+
+bool ChunkVisibility::isVisible(const ChunkCoord &coord) {
+	if (!mEnabled)
+		return true;
+
+	++mTested;
+	const S32 cell = getCell(coord);
+	if (cell >= 0 && mReached[cell])
+		return true;
+
+	++mRejected;
+	return false;
+}
+
+ChunkVisibility::Stats ChunkVisibility::getFrameStats() const {
+	Stats stats;
+	stats.reached = mReachedCount;
+	stats.tested = mTested;
+	stats.rejected = mRejected;
+	return stats;
+}
+
+void ChunkVisibility::printStats() const {
+	const F64 frames = mFrameCount > 0 ? static_cast<F64>(mFrameCount) : 1.0;
+	printf("Cave culling: %llu of %llu chunks rejected (%.1f%%) over %u frames\n", static_cast<unsigned long long>(mTotal.rejected), static_cast<unsigned long long>(mTotal.tested), mTotal.tested > 0 ? mTotal.rejected * 100.0 / mTotal.tested : 0.0, mFrameCount);
+	printf("   %.1f chunks reached per frame\n", mTotal.reached / frames);
+}
+
+S32 ChunkVisibility::getCell(const ChunkCoord &coord) const {
+	const S32 x = coord.x - mMin.x;
+	const S32 y = coord.y - mMin.y;
+	const S32 z = coord.z - mMin.z;
+	if (x < 0 || y < 0 || z < 0 || x >= mSizeX || y >= mSizeY || z >= mSizeZ)
+		return -1;
+	return (y * mSizeZ + z) * mSizeX + x;
+}
@@ -0,0 +1,110 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_CHUNKVISIBILITY_HPP_
+#define _GRAPHICS_CHUNKVISIBILITY_HPP_
+
+#include <atomic>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "core/frustum.hpp"
+#include "world/chunk.hpp"
+
+class World;
+
+/**
+ * Cave culling. Walks the loaded chunks breadth first from the camera's chunk,
+ * leaving a chunk only through a face that the face it was entered through
+ * can see, never heading back towards the camera and staying inside the
+ * frustum. Chunks the walk does not reach are hidden behind terrain.
+ *
+ * The walk covers the box around the loaded chunks grown by a chunk on every
+ * side, the chunks missing in it being open air. It is off, every chunk
+ * visible, while the camera is outside of that box.
+ */
+class ChunkVisibility {
+public:
+	struct Stats {
+		U64 reached;
+		U64 tested;
+		U64 rejected;
+	};
+
+	ChunkVisibility();
+
+	/**
+	 * Finds the chunks reachable from the camera for this frame.
+	 */
+	void update(const World *world, const Frustum &frustum, const glm::vec3 &cameraPosition);
+
+	/**
+	 * Thread safe once update() has returned.
+	 */
+	bool isVisible(const ChunkCoord &coord);
+
+	Stats getFrameStats() const;
+
+	const Stats& getTotalStats() const {
+		return mTotal;
+	}
+
+	U32 getFrameCount() const {
+		return mFrameCount;
+	}
+
+	void printStats() const;
+
+private:
+	struct Step {
+		U32 cell;
+		U8 entryFace;
+		U8 directions;
+	};
+
+	ChunkCoord mMin;
+	S32 mSizeX;
+	S32 mSizeY;
+	S32 mSizeZ;
+	bool mEnabled;
+	std::vector<const Chunk*> mGrid;
+	std::vector<U8> mReached;
+	std::vector<Step> mQueue;
+
+	U32 mReachedCount;
+	std::atomic<U32> mTested;
+	std::atomic<U32> mRejected;
+	Stats mTotal;
+	U32 mFrameCount;
+
+	S32 getCell(const ChunkCoord &coord) const;
+};
+
+#endif // _GRAPHICS_CHUNKVISIBILITY_HPP_
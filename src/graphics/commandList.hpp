@@ -0,0 +1,153 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_COMMANDLIST_HPP_
+#define _GRAPHICS_COMMANDLIST_HPP_
+
+#include <vector>
+#include "core/types.hpp"
+#include "graphics/renderQueue.hpp"
+
+enum RenderCommandType : U8 {
+	RENDER_COMMAND_SET_PASS,
+	RENDER_COMMAND_SET_SHADER,
+	RENDER_COMMAND_SET_VIEW_PROJECTION,
+	RENDER_COMMAND_SET_VERTEX_PAGE,
+	RENDER_COMMAND_SET_CHUNK_TRANSFORM,
+	RENDER_COMMAND_DRAW_QUADS
+};
+
+struct RenderCommand {
+	RenderCommandType type;
+	union {
+		/**
+		 * Transparent passes blend and test against the depth buffer without
+		 * writing to it.
+		 */
+		struct {
+			RenderPass pass;
+		} setPass;
+
+		struct {
+			U32 shader;
+		} setShader;
+
+		/**
+		 * The matrix must stay alive until the list has been executed.
+		 */
+		struct {
+			const F32 *matrix;
+		} setViewProjection;
+
+		struct {
+			U32 page;
+		} setVertexPage;
+
+		/**
+		 * Origin of the chunk in xyz and the scale of its vertices in w.
+		 */
+		struct {
+			F32 transform[4];
+		} setChunkTransform;
+
+		/**
+		 * Draws quads from the bound vertex page, starting at baseVertex.
+		 */
+		struct {
+			S32 baseVertex;
+			U32 quadCount;
+		} drawQuads;
+	};
+};
+
+/**
+ * A stream of backend agnostic draw commands. Lists are recorded on any
+ * thread, one thread per list, and then executed in order by the renderer
+ * on the thread that owns the graphics API.
+ *
+ * Shaders and vertex pages are identifiers the backend hands out. A list
+ * doesn't inherit any state from the list before it and has to set
+ * everything it draws with.
+ */
+class CommandList {
+public:
+	void clear() {
+		mCommands.clear();
+	}
+
+	void setPass(RenderPass pass) {
+		RenderCommand &command = push(RENDER_COMMAND_SET_PASS);
+		command.setPass.pass = pass;
+	}
+
+	void setShader(U32 shader) {
+		RenderCommand &command = push(RENDER_COMMAND_SET_SHADER);
+		command.setShader.shader = shader;
+	}
+
+	void setViewProjection(const F32 *matrix) {
+		RenderCommand &command = push(RENDER_COMMAND_SET_VIEW_PROJECTION);
+		command.setViewProjection.matrix = matrix;
+	}
+
+	void setVertexPage(U32 page) {
+		RenderCommand &command = push(RENDER_COMMAND_SET_VERTEX_PAGE);
+		command.setVertexPage.page = page;
+	}
+
+	void setChunkTransform(F32 x, F32 y, F32 z, F32 scale) {
+		RenderCommand &command = push(RENDER_COMMAND_SET_CHUNK_TRANSFORM);
+		command.setChunkTransform.transform[0] = x;
+		command.setChunkTransform.transform[1] = y;
+		command.setChunkTransform.transform[2] = z;
+		command.setChunkTransform.transform[3] = scale;
+	}
+
+	void drawQuads(S32 baseVertex, U32 quadCount) {
+		RenderCommand &command = push(RENDER_COMMAND_DRAW_QUADS);
+		command.drawQuads.baseVertex = baseVertex;
+		command.drawQuads.quadCount = quadCount;
+	}
+
+	const std::vector<RenderCommand>& getCommands() const {
+		return mCommands;
+	}
+
+private:
+	std::vector<RenderCommand> mCommands;
+
+	RenderCommand& push(RenderCommandType type) {
+		mCommands.push_back(RenderCommand());
+		mCommands.back().type = type;
+		return mCommands.back();
+	}
+};
+
+#endif // _GRAPHICS_COMMANDLIST_HPP_
@@ -51,6 +51,12 @@ public:
 
 	virtual void swapBuffers() const = 0;
 
+	/**
+	 * Binds or unbinds the context on the calling thread so that rendering can
+	 * be moved off of the thread that created the window.
+	 */
+	virtual void makeCurrent(bool current) = 0;
+
 	virtual Renderer* getRenderer() const = 0;
 
 protected:
@@ -0,0 +1,200 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include "graphics/imageLoader.hpp"
+
+#define TGA_HEADER_SIZE 18
+#define TGA_TYPE_TRUECOLOR 2
+#define TGA_TYPE_TRUECOLOR_RLE 10
+#define TGA_DESCRIPTOR_TOP_ORIGIN 0x20
+
+ImageLoader::ImageLoader() {
+	mQuit = false;
+	mPending = 0;
+}
+
+ImageLoader::~ImageLoader() {
+	shutdown();
+}
+
+void ImageLoader::request(const std::string &path, U32 id) {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRequests.push_back({ path, id });
+		++mPending;
+		if (mThreads.empty())
+			mQuit = false;
+	}
+	mCondition.notify_one();
+
+	if (mThreads.empty()) {
+		for (U32 i = 0; i < IMAGE_LOADER_THREADS; ++i)
+			mThreads.push_back(std::thread(&ImageLoader::loaderThread, this));
+	}
+}
+
+bool ImageLoader::poll(Result &result) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mResults.empty())
+		return false;
+
+	// Oldest first, they are few enough that the shuffle doesn't matter.
+	result = std::move(mResults.front());
+	mResults.erase(mResults.begin());
+	--mPending;
+	return true;
+}
+
+U32 ImageLoader::getPendingCount() {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mPending;
+}
+
+void ImageLoader::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+		mPending -= static_cast<U32>(mRequests.size());
+		mRequests.clear();
+	}
+	mCondition.notify_all();
+	for (std::thread &thread : mThreads)
+		thread.join();
+	mThreads.clear();
+}
+
+void ImageLoader::loaderThread() {
+	for (;;) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() {
+				return mQuit || !mRequests.empty();
+			});
+			if (mQuit)
+				return;
+
+			request = std::move(mRequests.front());
+			mRequests.pop_front();
+		}
+
+		Result result;
+		result.id = request.id;
+		result.loaded = loadFile(request.path, result.image);
+		if (!result.loaded) {
+			result.image.width = 0;
+			result.image.height = 0;
+			result.image.pixels.clear();
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mResults.push_back(std::move(result));
+	}
+}
+
+bool ImageLoader::loadFile(const std::string &path, Image &image) {
+	FILE *file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	std::vector<U8> data;
+	U8 buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + read);
+	fclose(file);
+
+	if (!decodeTGA(data.data(), data.size(), image)) {
+		printf("Unable to decode image %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool ImageLoader::decodeTGA(const U8 *data, size_t size, Image &image) {
+	if (size < TGA_HEADER_SIZE)
+		return false;
+
+	const U8 idLength = data[0];
+	const U8 colorMapType = data[1];
+	const U8 type = data[2];
+	const U32 width = data[12] | (data[13] << 8);
+	const U32 height = data[14] | (data[15] << 8);
+	const U8 bitsPerPixel = data[16];
+	const U8 descriptor = data[17];
+	if (colorMapType != 0 || (type != TGA_TYPE_TRUECOLOR && type != TGA_TYPE_TRUECOLOR_RLE))
+		return false;
+	if ((bitsPerPixel != 24 && bitsPerPixel != 32) || width == 0 || height == 0)
+		return false;
+
+	const U32 bytesPerPixel = bitsPerPixel / 8;
+	const U32 pixelCount = width * height;
+	const U8 *in = data + TGA_HEADER_SIZE + idLength;
+	const U8 *end = data + size;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(pixelCount * 4);
+
+	// Pixels are stored BGR(A), the rows bottom up unless the descriptor
+	// says otherwise.
+	const bool topOrigin = (descriptor & TGA_DESCRIPTOR_TOP_ORIGIN) != 0;
+	U32 pixel = 0;
+	while (pixel < pixelCount) {
+		U32 count = 1;
+		bool repeat = false;
+		if (type == TGA_TYPE_TRUECOLOR_RLE) {
+			if (in >= end)
+				return false;
+			count = (*in & 0x7F) + 1;
+			repeat = (*in & 0x80) != 0;
+			++in;
+		}
+		if (pixel + count > pixelCount)
+			return false;
+
+		for (U32 i = 0; i < count; ++i, ++pixel) {
+			const U8 *source = repeat ? in : in + i * bytesPerPixel;
+			if (source + bytesPerPixel > end)
+				return false;
+
+			const U32 x = pixel % width;
+			const U32 y = topOrigin ? pixel / width : height - 1 - pixel / width;
+			U8 *out = image.pixels.data() + (y * width + x) * 4;
+			out[0] = source[2];
+			out[1] = source[1];
+			out[2] = source[0];
+			out[3] = bytesPerPixel == 4 ? source[3] : 255;
+		}
+		in += repeat ? bytesPerPixel : count * bytesPerPixel;
+	}
+	return true;
+}
@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_IMAGELOADER_HPP_
+#define _GRAPHICS_IMAGELOADER_HPP_
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "core/types.hpp"
+
+/**
+ * Threads reading and decoding images in the background.
+ */
+#define IMAGE_LOADER_THREADS 2
+
+/**
+ * Decoded image, RGBA8 texels with the top row first.
+ */
+struct Image {
+	U32 width;
+	U32 height;
+	std::vector<U8> pixels;
+};
+
+/**
+ * Reads and decodes image files on threads of its own, so that the game
+ * thread never waits on the disk or the decoder. Requests are served in the
+ * order they were made and the results collected with poll().
+ *
+ * Only Truevision TGA, uncompressed or run length encoded with 24 or 32 bits
+ * per pixel, is understood.
+ */
+class ImageLoader {
+public:
+	struct Result {
+		U32 id;
+
+		/**
+		 * False if the file couldn't be read or decoded, image is empty then.
+		 */
+		bool loaded;
+		Image image;
+	};
+
+	ImageLoader();
+	~ImageLoader();
+
+	/**
+	 * Queues the file at path, the result carries id back to the caller.
+	 * Starts the loader threads on the first request.
+	 */
+	void request(const std::string &path, U32 id);
+
+	/**
+	 * Takes a finished result. Returns false if there is none yet.
+	 */
+	bool poll(Result &result);
+
+	/**
+	 * Requests that have not been taken by poll() yet.
+	 */
+	U32 getPendingCount();
+
+	/**
+	 * Drops the queued requests and stops the loader threads.
+	 */
+	void shutdown();
+
+	static bool decodeTGA(const U8 *data, size_t size, Image &image);
+
+private:
+	struct Request {
+		std::string path;
+		U32 id;
+	};
+
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mQuit;
+
+	// Guarded by mMutex.
+	std::deque<Request> mRequests;
+	std::vector<Result> mResults;
+	U32 mPending;
+
+	void loaderThread();
+	static bool loadFile(const std::string &path, Image &image);
+};
+
+#endif // _GRAPHICS_IMAGELOADER_HPP_
@@ -0,0 +1,340 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "graphics/occlusionBuffer.hpp"
+#include "core/simd.hpp"
+#include "core/threadPool.hpp"
+#include "world/world.hpp"
+
+// Tile rows rasterized per worker batch.
+#define OCCLUSION_ROWS_PER_BATCH 4
+
+// Chunks this far from the camera's chunk on any axis contribute occluders,
+// up to a limit of quads.
+#define OCCLUDER_CHUNK_RANGE 4
+#define OCCLUSION_MAX_OCCLUDERS 512
+
+OcclusionBuffer::OcclusionBuffer() : mDepth(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 0.0f) {
+	memset(mTiles, 0, sizeof(mTiles));
+	memset(&mTotal, 0, sizeof(mTotal));
+	mOccluders = 0;
+	mTested = 0;
+	mRejected = 0;
+	mFrameCount = 0;
+}
+
+void OcclusionBuffer::begin(const glm::mat4 &viewProjection) {
+	if (mTested > 0) {
+		const Stats frame = getFrameStats();
+		mTotal.occluders += frame.occluders;
+		mTotal.triangles += frame.triangles;
+		mTotal.tested += frame.tested;
+		mTotal.rejected += frame.rejected;
+		++mFrameCount;
+	}
+
+	mViewProjection = viewProjection;
+	mTriangles.clear();
+	mOccluders = 0;
+	mTested = 0;
+	mRejected = 0;
+}
+
+void OcclusionBuffer::addOccluder(const glm::vec3 *corners) {
+	++mOccluders;
+
+	// Clip the quad against the near plane, z >= -w.
+	glm::vec4 quad[4];
+	for (U32 i = 0; i < 4; ++i)
+		quad[i] = mViewProjection * glm::vec4(corners[i], 1.0f);
+
+	glm::vec4 polygon[5];
+	U32 count = 0;
+	for (U32 i = 0; i < 4; ++i) {
+		const glm::vec4 &p = quad[i];
+		const glm::vec4 &q = quad[(i + 1) % 4];
+		const F32 dp = p.z + p.w;
+		const F32 dq = q.z + q.w;
+		if (dp >= 0.0f)
+			polygon[count++] = p;
+		if ((dp >= 0.0f) != (dq >= 0.0f))
+			polygon[count++] = p + (q - p) * (dp / (dp - dq));
+	}
+
+	for (U32 i = 2; i < count; ++i)
+		addTriangle(polygon[0], polygon[i - 1], polygon[i]);
+}
+
+void OcclusionBuffer::addChunkOccluders(const World *world, const Frustum &frustum, const glm::vec3 &cameraPosition) {
+	const ChunkCoord center = World::getChunkCoord(glm::ivec3(glm::floor(cameraPosition)));
+	mOccluderChunks.clear();
+	for (S32 y = -OCCLUDER_CHUNK_RANGE; y <= OCCLUDER_CHUNK_RANGE; ++y) {
+		for (S32 z = -OCCLUDER_CHUNK_RANGE; z <= OCCLUDER_CHUNK_RANGE; ++z) {
+			for (S32 x = -OCCLUDER_CHUNK_RANGE; x <= OCCLUDER_CHUNK_RANGE; ++x) {
+				const ChunkCoord coord = { center.x + x, center.y + y, center.z + z };
+				const Chunk *chunk = world->getChunk(coord);
+				if (chunk == nullptr || !chunk->hasOccluders())
+					continue;
+
+				const glm::vec3 min = glm::vec3(coord.x, coord.y, coord.z) * static_cast<F32>(CHUNK_SIZE);
+				const AABB box(min, min + glm::vec3(static_cast<F32>(CHUNK_SIZE)));
+				if (!frustum.intersects(box))
+					continue;
+
+				OccluderChunk occluder;
+				occluder.distance = glm::length(glm::clamp(cameraPosition, box.min, box.max) - cameraPosition);
+				occluder.chunk = chunk;
+				mOccluderChunks.push_back(occluder);
+			}
+		}
+	}
+	std::sort(mOccluderChunks.begin(), mOccluderChunks.end(), [](const OccluderChunk &a, const OccluderChunk &b) {
+		return a.distance < b.distance;
+	});
+
+	for (const OccluderChunk &occluder : mOccluderChunks) {
+		const ChunkCoord &coord = occluder.chunk->getCoord();
+		const glm::vec3 min = glm::vec3(coord.x, coord.y, coord.z) * static_cast<F32>(CHUNK_SIZE);
+		for (U32 face = 0; face < FACE_COUNT; ++face) {
+			// Seen from outside the chunk, the layers nearest to the faces
+			// towards the camera hide everything the others would.
+			const U32 axis = face / 2;
+			if ((face & 1) ? cameraPosition[axis] < min[axis] : cameraPosition[axis] > min[axis] + CHUNK_SIZE)
+				continue;
+
+			// Quadrants solid at the same depth are drawn as one quad.
+			U8 depths[OCCLUDER_QUADRANTS];
+			bool merged = true;
+			for (U32 quadrant = 0; quadrant < OCCLUDER_QUADRANTS; ++quadrant) {
+				depths[quadrant] = occluder.chunk->getOccluderLayer(face, quadrant);
+				merged &= depths[quadrant] == depths[0];
+			}
+
+			const U32 quads = merged ? 1 : OCCLUDER_QUADRANTS;
+			const F32 size = merged ? static_cast<F32>(CHUNK_SIZE) : static_cast<F32>(OCCLUDER_QUADRANT_SIZE);
+			for (U32 quadrant = 0; quadrant < quads; ++quadrant) {
+				if (depths[quadrant] == NO_OCCLUDER_LAYER)
+					continue;
+				if (mOccluders >= OCCLUSION_MAX_OCCLUDERS)
+					return;
+
+				const U32 u = (axis + 1) % 3;
+				const U32 v = (axis + 2) % 3;
+				const F32 layer = static_cast<F32>((face & 1) ? CHUNK_SIZE - 1 - depths[quadrant] : depths[quadrant]);
+				const F32 firstU = (quadrant & 1) ? OCCLUDER_QUADRANT_SIZE : 0.0f;
+				const F32 firstV = (quadrant & 2) ? OCCLUDER_QUADRANT_SIZE : 0.0f;
+				glm::vec3 corners[4];
+				for (U32 i = 0; i < 4; ++i) {
+					corners[i] = min;
+					corners[i][axis] += layer + 0.5f;
+					corners[i][u] += firstU + ((i == 1 || i == 2) ? size : 0.0f);
+					corners[i][v] += firstV + ((i == 2 || i == 3) ? size : 0.0f);
+				}
+				addOccluder(corners);
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::addTriangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c) {
+	const glm::vec4 *clip[3] = { &a, &b, &c };
+	Triangle triangle;
+	for (U32 i = 0; i < 3; ++i) {
+		const glm::vec4 &v = *clip[i];
+		if (v.w <= 0.0f)
+			return;
+
+		const F32 invW = 1.0f / v.w;
+		triangle.v[i] = glm::vec3((v.x * invW * 0.5f + 0.5f) * OCCLUSION_WIDTH, (v.y * invW * 0.5f + 0.5f) * OCCLUSION_HEIGHT, invW);
+	}
+	mTriangles.push_back(triangle);
+}
+
+void OcclusionBuffer::rasterize() {
+	gThreadPool.parallelFor(OCCLUSION_TILES_Y, OCCLUSION_ROWS_PER_BATCH, [this](U32 start, U32 end) {
+		rasterizeRows(start, end);
+	});
+}
+
+void OcclusionBuffer::rasterizeRows(U32 firstTileRow, U32 lastTileRow) {
+	const S32 firstRow = firstTileRow * OCCLUSION_TILE_SIZE;
+	const S32 lastRow = lastTileRow * OCCLUSION_TILE_SIZE;
+	std::fill(mDepth.begin() + firstRow * OCCLUSION_WIDTH, mDepth.begin() + lastRow * OCCLUSION_WIDTH, 0.0f);
+	for (const Triangle &triangle : mTriangles)
+		rasterizeTriangle(triangle, firstRow, lastRow);
+
+	// Every tile keeps the farthest depth of its pixels.
+	for (U32 ty = firstTileRow; ty < lastTileRow; ++ty) {
+		for (U32 tx = 0; tx < OCCLUSION_TILES_X; ++tx) {
+			F32 farthest = mDepth[ty * OCCLUSION_TILE_SIZE * OCCLUSION_WIDTH + tx * OCCLUSION_TILE_SIZE];
+			for (U32 y = 0; y < OCCLUSION_TILE_SIZE; ++y) {
+				const F32 *row = &mDepth[(ty * OCCLUSION_TILE_SIZE + y) * OCCLUSION_WIDTH + tx * OCCLUSION_TILE_SIZE];
+				for (U32 x = 0; x < OCCLUSION_TILE_SIZE; ++x)
+					farthest = std::min(farthest, row[x]);
+			}
+			mTiles[ty * OCCLUSION_TILES_X + tx] = farthest;
+		}
+	}
+}
+
+void OcclusionBuffer::rasterizeTriangle(const Triangle &triangle, S32 firstRow, S32 lastRow) {
+	glm::vec3 v0 = triangle.v[0];
+	glm::vec3 v1 = triangle.v[1];
+	glm::vec3 v2 = triangle.v[2];
+	F32 area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (fabsf(area) < 1e-6f)
+		return;
+
+	// Occluders block the view from both sides, wind them all the same way.
+	if (area < 0.0f) {
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	const S32 minX = std::max(0, static_cast<S32>(floorf(std::min(v0.x, std::min(v1.x, v2.x))))) & ~3;
+	const S32 maxX = std::min(OCCLUSION_WIDTH - 1, static_cast<S32>(ceilf(std::max(v0.x, std::max(v1.x, v2.x)))));
+	const S32 minY = std::max(firstRow, static_cast<S32>(floorf(std::min(v0.y, std::min(v1.y, v2.y)))));
+	const S32 maxY = std::min(lastRow - 1, static_cast<S32>(ceilf(std::max(v0.y, std::max(v1.y, v2.y)))));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	// Edge functions, positive on the inside, e = a * x + b * y + c.
+	const glm::vec3 *edges[3][2] = { { &v1, &v2 }, { &v2, &v0 }, { &v0, &v1 } };
+	F32 ea[3], eb[3], ec[3];
+	for (U32 i = 0; i < 3; ++i) {
+		const glm::vec3 &p = *edges[i][0];
+		const glm::vec3 &q = *edges[i][1];
+		ea[i] = p.y - q.y;
+		eb[i] = q.x - p.x;
+		ec[i] = -(ea[i] * p.x + eb[i] * p.y);
+	}
+
+	// 1/w is linear in screen space.
+	const F32 za = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	const F32 zb = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+	const F32 zc = v0.z - za * v0.x - zb * v0.y;
+
+	for (S32 y = minY; y <= maxY; ++y) {
+		const F32 py = y + 0.5f;
+		const F32 px = minX + 0.5f;
+		F32 *row = &mDepth[y * OCCLUSION_WIDTH];
+		S32 x = minX;
+#if VOXEL_SSE
+		// Four pixels at a time, the buffer rows being a multiple of four wide.
+		const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+		__m128 e[3], eStep[3];
+		for (U32 i = 0; i < 3; ++i) {
+			e[i] = _mm_add_ps(_mm_set1_ps(ea[i] * px + eb[i] * py + ec[i]), _mm_mul_ps(lanes, _mm_set1_ps(ea[i])));
+			eStep[i] = _mm_set1_ps(ea[i] * 4.0f);
+		}
+		__m128 z = _mm_add_ps(_mm_set1_ps(za * px + zb * py + zc), _mm_mul_ps(lanes, _mm_set1_ps(za)));
+		const __m128 zStep = _mm_set1_ps(za * 4.0f);
+		const __m128 zero = _mm_setzero_ps();
+		for (; x <= maxX; x += 4) {
+			const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero)), _mm_cmpge_ps(e[2], zero));
+			if (_mm_movemask_ps(inside) != 0) {
+				const __m128 depth = _mm_loadu_ps(row + x);
+				const __m128 closer = _mm_max_ps(depth, z);
+				_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, depth)));
+			}
+			for (U32 i = 0; i < 3; ++i)
+				e[i] = _mm_add_ps(e[i], eStep[i]);
+			z = _mm_add_ps(z, zStep);
+		}
+#endif
+		for (; x <= maxX; ++x) {
+			const F32 cx = x + 0.5f;
+			if (ea[0] * cx + eb[0] * py + ec[0] >= 0.0f && ea[1] * cx + eb[1] * py + ec[1] >= 0.0f && ea[2] * cx + eb[2] * py + ec[2] >= 0.0f)
+				row[x] = std::max(row[x], za * cx + zb * py + zc);
+		}
+	}
+}
+
+bool OcclusionBuffer::isOccluded(const AABB &box) {
+	mTested.fetch_add(1, std::memory_order_relaxed);
+
+	F32 minX = static_cast<F32>(OCCLUSION_WIDTH);
+	F32 minY = static_cast<F32>(OCCLUSION_HEIGHT);
+	F32 maxX = 0.0f;
+	F32 maxY = 0.0f;
+	F32 nearest = 0.0f;
+	for (U32 i = 0; i < 8; ++i) {
+		const glm::vec3 corner((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z);
+		const glm::vec4 clip = mViewProjection * glm::vec4(corner, 1.0f);
+
+		// Boxes reaching past the near plane are right in front of the camera.
+		if (clip.z < -clip.w || clip.w <= 0.0f)
+			return false;
+
+		const F32 invW = 1.0f / clip.w;
+		const F32 x = (clip.x * invW * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+		const F32 y = (clip.y * invW * 0.5f + 0.5f) * OCCLUSION_HEIGHT;
+		minX = std::min(minX, x);
+		minY = std::min(minY, y);
+		maxX = std::max(maxX, x);
+		maxY = std::max(maxY, y);
+		nearest = std::max(nearest, invW);
+	}
+	if (minX >= maxX || minY >= maxY)
+		return false;
+
+	const S32 firstX = std::max(0, static_cast<S32>(floorf(minX)) / OCCLUSION_TILE_SIZE);
+	const S32 firstY = std::max(0, static_cast<S32>(floorf(minY)) / OCCLUSION_TILE_SIZE);
+	const S32 lastX = std::min(OCCLUSION_TILES_X - 1, static_cast<S32>(floorf(maxX)) / OCCLUSION_TILE_SIZE);
+	const S32 lastY = std::min(OCCLUSION_TILES_Y - 1, static_cast<S32>(floorf(maxY)) / OCCLUSION_TILE_SIZE);
+	for (S32 ty = firstY; ty <= lastY; ++ty) {
+		for (S32 tx = firstX; tx <= lastX; ++tx) {
+			if (mTiles[ty * OCCLUSION_TILES_X + tx] <= nearest)
+				return false;
+		}
+	}
+
+	mRejected.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+OcclusionBuffer::Stats OcclusionBuffer::getFrameStats() const {
+	Stats stats;
+	stats.occluders = mOccluders;
+	stats.triangles = static_cast<U32>(mTriangles.size());
+	stats.tested = mTested;
+	stats.rejected = mRejected;
+	return stats;
+}
+
+void OcclusionBuffer::printStats() const {
+	const F64 frames = mFrameCount > 0 ? static_cast<F64>(mFrameCount) : 1.0;
+	printf("Occlusion culling: %llu of %llu boxes rejected (%.1f%%) over %u frames\n", static_cast<unsigned long long>(mTotal.rejected), static_cast<unsigned long long>(mTotal.tested), mTotal.tested > 0 ? mTotal.rejected * 100.0 / mTotal.tested : 0.0, mFrameCount);
+	printf("   %.1f rejected and %.1f occluders (%.1f triangles) per frame\n", mTotal.rejected / frames, mTotal.occluders / frames, mTotal.triangles / frames);
+}
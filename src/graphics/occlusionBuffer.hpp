@@ -0,0 +1,144 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_OCCLUSIONBUFFER_HPP_
+#define _GRAPHICS_OCCLUSIONBUFFER_HPP_
+
+#include <atomic>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "core/aabb.hpp"
+#include "core/frustum.hpp"
+#include "world/chunk.hpp"
+
+class World;
+
+/**
+ * Resolution of the occlusion depth buffer. The width is a multiple of the
+ * four pixels rasterized at once and both are multiples of the tile size.
+ */
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 160
+#define OCCLUSION_TILE_SIZE 8
+#define OCCLUSION_TILES_X (OCCLUSION_WIDTH / OCCLUSION_TILE_SIZE)
+#define OCCLUSION_TILES_Y (OCCLUSION_HEIGHT / OCCLUSION_TILE_SIZE)
+
+/**
+ * Low resolution software depth buffer for culling objects hidden behind
+ * large occluders before they are submitted.
+ *
+ * Occluder quads are clipped and rasterized on the CPU, the thread pool
+ * taking a band of tile rows each and SSE filling four pixels at a time. The
+ * buffer holds 1/w so that it can be interpolated linearly across the screen,
+ * larger values being closer. A tile of the hierarchical buffer keeps the
+ * farthest depth of its pixels, a box is hidden when its nearest point is
+ * behind that of every tile it covers.
+ */
+class OcclusionBuffer {
+public:
+	struct Stats {
+		U64 occluders;
+		U64 triangles;
+		U64 tested;
+		U64 rejected;
+	};
+
+	OcclusionBuffer();
+
+	/**
+	 * Clears the buffer and starts a frame seen through viewProjection.
+	 */
+	void begin(const glm::mat4 &viewProjection);
+
+	/**
+	 * Queues a planar quad occluder, the corners going around its edge.
+	 */
+	void addOccluder(const glm::vec3 *corners);
+
+	/**
+	 * Queues the solid layers of the chunks around the camera that are inside
+	 * the frustum, nearest first. Every face quadrant of a chunk contributes a
+	 * quad through the middle of its first layer that is solid all across.
+	 */
+	void addChunkOccluders(const World *world, const Frustum &frustum, const glm::vec3 &cameraPosition);
+
+	/**
+	 * Draws the queued occluders and builds the tiles.
+	 */
+	void rasterize();
+
+	/**
+	 * Whether the box is hidden behind the occluders. Thread safe once
+	 * rasterize() has returned.
+	 */
+	bool isOccluded(const AABB &box);
+
+	Stats getFrameStats() const;
+
+	const Stats& getTotalStats() const {
+		return mTotal;
+	}
+
+	U32 getFrameCount() const {
+		return mFrameCount;
+	}
+
+	void printStats() const;
+
+private:
+	struct OccluderChunk {
+		F32 distance;
+		const Chunk *chunk;
+	};
+
+	struct Triangle {
+		// Screen space vertices, their 1/w in z.
+		glm::vec3 v[3];
+	};
+
+	glm::mat4 mViewProjection;
+	std::vector<F32> mDepth;
+	F32 mTiles[OCCLUSION_TILES_X * OCCLUSION_TILES_Y];
+	std::vector<Triangle> mTriangles;
+	std::vector<OccluderChunk> mOccluderChunks;
+
+	U32 mOccluders;
+	std::atomic<U32> mTested;
+	std::atomic<U32> mRejected;
+	Stats mTotal;
+	U32 mFrameCount;
+
+	void addTriangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c);
+	void rasterizeRows(U32 firstTileRow, U32 lastTileRow);
+	void rasterizeTriangle(const Triangle &triangle, S32 firstRow, S32 lastRow);
+};
+
+#endif // _GRAPHICS_OCCLUSIONBUFFER_HPP_
@@ -0,0 +1,116 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <string.h>
+#include "graphics/renderQueue.hpp"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+
+static U64 quantizeDepth(F32 depth) {
+	const U64 maxDepth = (1ULL << RENDER_KEY_DEPTH_BITS) - 1;
+	if (!(depth > 0.0f))
+		return 0;
+	if (depth >= 1.0f)
+		return maxDepth;
+	return static_cast<U64>(depth * maxDepth);
+}
+
+static U64 mask(U32 value, U32 bits) {
+	return static_cast<U64>(value) & ((1ULL << bits) - 1);
+}
+
+U64 RenderQueue::makeOpaqueKey(U32 shader, U32 material, U32 textureArray, F32 depth) {
+	// pass | shader | material | texture array | depth | unused
+	U64 key = static_cast<U64>(RENDER_PASS_OPAQUE) << 62;
+	key |= mask(shader, RENDER_KEY_SHADER_BITS) << 52;
+	key |= mask(material, RENDER_KEY_MATERIAL_BITS) << 40;
+	key |= mask(textureArray, RENDER_KEY_TEXTURE_BITS) << 32;
+	key |= quantizeDepth(depth) << 8;
+	return key;
+}
+
+U64 RenderQueue::makeTransparentKey(U32 shader, U32 material, U32 textureArray, F32 depth) {
+	// pass | inverted depth | shader | material | texture array | unused
+	const U64 maxDepth = (1ULL << RENDER_KEY_DEPTH_BITS) - 1;
+	U64 key = static_cast<U64>(RENDER_PASS_TRANSPARENT) << 62;
+	key |= (maxDepth - quantizeDepth(depth)) << 38;
+	key |= mask(shader, RENDER_KEY_SHADER_BITS) << 28;
+	key |= mask(material, RENDER_KEY_MATERIAL_BITS) << 16;
+	key |= mask(textureArray, RENDER_KEY_TEXTURE_BITS) << 8;
+	return key;
+}
+
+void RenderQueue::sort() {
+	const size_t count = mItems.size();
+	if (count < 2)
+		return;
+
+	// Build the histograms of every digit in a single pass.
+	U32 histograms[RADIX_PASSES][RADIX_BUCKETS];
+	memset(histograms, 0, sizeof(histograms));
+	for (const RenderItem &item : mItems) {
+		for (U32 pass = 0; pass < RADIX_PASSES; ++pass)
+			++histograms[pass][(item.key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
+	}
+
+	mScratch.resize(count);
+	RenderItem *source = mItems.data();
+	RenderItem *destination = mScratch.data();
+	for (U32 pass = 0; pass < RADIX_PASSES; ++pass) {
+		U32 *histogram = histograms[pass];
+		const U32 shift = pass * RADIX_BITS;
+
+		// Most digits are the same for every key, such as the pass or the
+		// unused bits, and don't need to be sorted on.
+		if (histogram[(source[0].key >> shift) & (RADIX_BUCKETS - 1)] == count)
+			continue;
+
+		U32 offset = 0;
+		for (U32 bucket = 0; bucket < RADIX_BUCKETS; ++bucket) {
+			U32 bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			const RenderItem &item = source[i];
+			destination[histogram[(item.key >> shift) & (RADIX_BUCKETS - 1)]++] = item;
+		}
+
+		RenderItem *swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	if (source != mItems.data())
+		mItems.swap(mScratch);
+}
@@ -0,0 +1,103 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPHICS_RENDERQUEUE_HPP_
+#define _GRAPHICS_RENDERQUEUE_HPP_
+
+#include <vector>
+#include "core/types.hpp"
+
+enum RenderPass : U8 {
+	RENDER_PASS_OPAQUE = 0,
+	RENDER_PASS_TRANSPARENT,
+
+	RENDER_PASS_COUNT
+};
+
+#define RENDER_KEY_SHADER_BITS 10
+#define RENDER_KEY_MATERIAL_BITS 12
+#define RENDER_KEY_TEXTURE_BITS 8
+#define RENDER_KEY_DEPTH_BITS 24
+
+struct RenderItem {
+	U64 key;
+
+	/**
+	 * Identifies the draw to the code that submitted it, usually an index into
+	 * its own array of draws.
+	 */
+	U32 draw;
+};
+
+/**
+ * Collects the draws of a frame along with a 64 bit sort key and sorts them
+ * with a radix sort, so draws sharing state end up next to each other.
+ *
+ * Opaque keys are ordered by pass, shader, material, texture array and then
+ * depth, so draws with the same state go front to back for early-Z.
+ * Transparent keys are ordered by pass and then depth from back to front, as
+ * blending needs, with the state only breaking ties.
+ */
+class RenderQueue {
+public:
+	/**
+	 * @param depth Distance from the camera, as a fraction of the far plane
+	 *   distance.
+	 */
+	static U64 makeOpaqueKey(U32 shader, U32 material, U32 textureArray, F32 depth);
+	static U64 makeTransparentKey(U32 shader, U32 material, U32 textureArray, F32 depth);
+
+	static RenderPass getPass(U64 key) {
+		return static_cast<RenderPass>(key >> 62);
+	}
+
+	void clear() {
+		mItems.clear();
+	}
+
+	void submit(U64 key, U32 draw) {
+		RenderItem item;
+		item.key = key;
+		item.draw = draw;
+		mItems.push_back(item);
+	}
+
+	void sort();
+
+	const std::vector<RenderItem>& getItems() const {
+		return mItems;
+	}
+
+private:
+	std::vector<RenderItem> mItems;
+	std::vector<RenderItem> mScratch;
+};
+
+#endif // _GRAPHICS_RENDERQUEUE_HPP_
@@ -28,4 +28,9 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //-----------------------------------------------------------------------------
 
-#include "graphics/renderer.hpp"
\ No newline at end of file
+#include "graphics/renderer.hpp"
+#include "core/frameArena.hpp"
+
+void Renderer::beginFrame() {
+	FrameArena::beginFrame();
+}
\ No newline at end of file
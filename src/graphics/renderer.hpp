@@ -32,8 +32,10 @@
 #define _GRAPHICS_RENDERER_H_
 
 #include <glm/glm.hpp>
+#include "graphics/commandList.hpp"
 
 class Camera;
+class World;
 
 class Renderer {
 public:
@@ -41,7 +43,10 @@ public:
 	
 	virtual void destroyRenderer() = 0;
 	
-	virtual void beginFrame() = 0;
+	/**
+	 * Resets the frame arenas. Backends must call this from their override.
+	 */
+	virtual void beginFrame();
 	
 	virtual void renderChunks() = 0;
 	
@@ -51,6 +56,17 @@ public:
 	virtual void renderSingleCube() = 0;
 	
 	virtual void setActiveSceneCamera(Camera *camera) = 0;
+	
+	/**
+	 * Sets the world whose chunk meshes renderChunks() draws.
+	 */
+	virtual void setWorld(World *world) = 0;
+	
+	/**
+	 * Replays a command list. Must be called on the thread that owns the
+	 * graphics API.
+	 */
+	virtual void executeCommandList(const CommandList &commands) = 0;
 };
 
 #endif
@@ -0,0 +1,1231 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "core/memoryStats.hpp"
+#include "core/threadPool.hpp"
+#include "game/blockPicker.hpp"
+#include "game/camera.hpp"
+#include "game/gameObject.hpp"
+#include "game/gameSession.hpp"
+#include "game/physicsObject.hpp"
+#include "game/entity/entityStore.hpp"
+#include "game/entity/spatialHash.hpp"
+#include "game/entity/transformSystem.hpp"
+#include "graphics/bufferHeap.hpp"
+#include "graphics/chunkVisibility.hpp"
+#include "graphics/imageLoader.hpp"
+#include "graphics/occlusionBuffer.hpp"
+#include "graphics/renderQueue.hpp"
+#include "main/benchmark.hpp"
+#include "platform/timer.hpp"
+#include "platform/event/eventManager.hpp"
+#include "world/blockTickScheduler.hpp"
+#include "world/chunkMesher.hpp"
+#include "world/fluidSimulation.hpp"
+#include "world/lodTerrain.hpp"
+#include "world/raycast.hpp"
+#include "world/smoothTerrain.hpp"
+#include "world/structuralIntegrity.hpp"
+#include "world/terrainGenerator.hpp"
+#include "world/world.hpp"
+
+#define BENCHMARK_SEED 1337
+
+// Generates a square area of terrain centered on the origin.
+static void generateWorld(World &world, S32 radius, S32 height) {
+	for (S32 y = 0; y < height; ++y) {
+		for (S32 z = -radius; z < radius; ++z) {
+			for (S32 x = -radius; x < radius; ++x) {
+				world.createChunk({ x, y, z });
+			}
+		}
+	}
+}
+
+static void benchmarkRaycast() {
+	const U32 rayCount = 1 << 20;
+	const S32 radius = 8;
+
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("benchmark");
+	world.setTerrainGenerator(&generator);
+	generateWorld(world, radius, 4);
+
+	std::mt19937 random(BENCHMARK_SEED);
+	std::uniform_real_distribution<F32> horizontal(-radius * CHUNK_SIZE, radius * CHUNK_SIZE);
+	std::uniform_real_distribution<F32> vertical(16.0f, 56.0f);
+	std::uniform_real_distribution<F32> unit(-1.0f, 1.0f);
+
+	std::vector<Ray> rays(rayCount);
+	for (Ray &ray : rays) {
+		ray.origin = glm::vec3(horizontal(random), vertical(random), horizontal(random));
+		ray.direction = glm::vec3(unit(random), unit(random), unit(random));
+		ray.maxDistance = 64.0f;
+	}
+	std::vector<RaycastHit> hits(rayCount);
+
+	Timer timer;
+	timer.start();
+	U32 hitCount = 0;
+	for (U32 i = 0; i < rayCount; ++i) {
+		if (Raycast::castRay(&world, rays[i].origin, rays[i].direction, rays[i].maxDistance, hits[i]))
+			++hitCount;
+	}
+	timer.stop();
+	F64 single = timer.getDelta();
+
+	timer.start();
+	Raycast::castRays(&world, rays.data(), hits.data(), rayCount);
+	timer.stop();
+	F64 batched = timer.getDelta();
+
+	printf("raycast: %u rays, %u hits\n", rayCount, hitCount);
+	printf("   single thread: %.3f s, %.2f Mrays/s\n", single, rayCount / single / 1000000.0);
+	printf("   batched (%u workers + caller): %.3f s, %.2f Mrays/s\n", gThreadPool.getWorkerCount(), batched, rayCount / batched / 1000000.0);
+}
+
+static void benchmarkCollision() {
+	const U32 bodyCount = 10000;
+	const U32 tickCount = 120;
+	const F64 tickDelta = 1.0 / 60.0;
+	const S32 radius = 8;
+
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("benchmark");
+	world.setTerrainGenerator(&generator);
+	generateWorld(world, radius, 4);
+
+	std::mt19937 random(BENCHMARK_SEED);
+	std::uniform_real_distribution<F32> horizontal(-radius * CHUNK_SIZE + 2.0f, radius * CHUNK_SIZE - 2.0f);
+	std::uniform_real_distribution<F32> speed(-4.0f, 4.0f);
+
+	// Drop the bodies just above the surface of the terrain and let them walk
+	// around in random directions.
+	std::vector<PhysicsObject*> bodies;
+	bodies.reserve(bodyCount);
+	for (U32 i = 0; i < bodyCount; ++i) {
+		PhysicsObject *body = new PhysicsObject(&world, glm::vec3(0.3f, 0.9f, 0.3f));
+		glm::vec3 position(horizontal(random), 0.0f, horizontal(random));
+		RaycastHit hit;
+		if (Raycast::castRay(&world, glm::vec3(position.x, 63.0f, position.z), glm::vec3(0.0f, -1.0f, 0.0f), 64.0f, hit))
+			position.y = static_cast<F32>(hit.position.y) + 2.0f;
+		else
+			position.y = 2.0f;
+
+		body->setPosition(position);
+		body->setVelocity(glm::vec3(speed(random), 0.0f, speed(random)));
+		bodies.push_back(body);
+	}
+
+	Timer timer;
+	timer.start();
+	for (U32 tick = 0; tick < tickCount; ++tick) {
+		for (PhysicsObject *body : bodies)
+			body->update(tickDelta);
+	}
+	timer.stop();
+	F64 single = timer.getDelta();
+
+	timer.start();
+	for (U32 tick = 0; tick < tickCount; ++tick) {
+		gThreadPool.parallelFor(bodyCount, 256, [&bodies, tickDelta](U32 start, U32 end) {
+			for (U32 i = start; i < end; ++i)
+				bodies[i]->update(tickDelta);
+		});
+	}
+	timer.stop();
+	F64 batched = timer.getDelta();
+
+	U32 grounded = 0;
+	for (PhysicsObject *body : bodies) {
+		if (body->isOnGround())
+			++grounded;
+		delete body;
+	}
+
+	printf("collision: %u bodies, %u ticks, %u on the ground at the end\n", bodyCount, tickCount, grounded);
+	printf("   single thread: %.3f ms/tick, %.2f M body updates/s\n", single * 1000.0 / tickCount, bodyCount * tickCount / single / 1000000.0);
+	printf("   batched (%u workers + caller): %.3f ms/tick, %.2f M body updates/s\n", gThreadPool.getWorkerCount(), batched * 1000.0 / tickCount, bodyCount * tickCount / batched / 1000000.0);
+}
+
+// An entity in the GameObject model: one heap allocation per entity, moved
+// through a virtual update.
+class BenchmarkMover : public GameObject {
+public:
+	glm::vec3 mVelocity;
+
+	virtual void update(const F64 &delta) override {
+		mPosition += mVelocity * static_cast<F32>(delta);
+	}
+};
+
+static void benchmarkEntities() {
+	const U32 entityCount = 100000;
+	const U32 tickCount = 200;
+	const F64 tickDelta = 1.0 / 60.0;
+
+	std::mt19937 random(BENCHMARK_SEED);
+	std::uniform_real_distribution<F32> unit(-1.0f, 1.0f);
+
+	std::vector<GameObject*> objects;
+	objects.reserve(entityCount);
+	EntityStore store;
+	for (U32 i = 0; i < entityCount; ++i) {
+		glm::vec3 position(unit(random), unit(random), unit(random));
+		glm::vec3 velocity(unit(random), unit(random), unit(random));
+
+		BenchmarkMover *mover = new BenchmarkMover();
+		mover->setPosition(position);
+		mover->mVelocity = velocity;
+		objects.push_back(mover);
+
+		Entity entity = store.create();
+		store.setPosition(entity, position);
+		store.setVelocity(entity, velocity);
+	}
+
+	Timer timer;
+	timer.start();
+	for (U32 tick = 0; tick < tickCount; ++tick) {
+		for (GameObject *object : objects)
+			object->update(tickDelta);
+	}
+	timer.stop();
+	F64 virtualTime = timer.getDelta();
+
+	timer.start();
+	for (U32 tick = 0; tick < tickCount; ++tick)
+		TransformSystem::integrate(store, tickDelta);
+	timer.stop();
+	F64 storeTime = timer.getDelta();
+
+	// Both models have to agree.
+	F32 maxError = 0.0f;
+	for (U32 i = 0; i < entityCount; ++i) {
+		glm::vec3 a = objects[i]->getPosition();
+		glm::vec3 b = store.getPosition(store.getEntity(i));
+		maxError = glm::max(maxError, glm::length(a - b));
+		delete objects[i];
+	}
+
+	printf("entities: %u entities, %u ticks, max position difference %f\n", entityCount, tickCount, maxError);
+	printf("   virtual GameObject::update: %.3f ms/tick\n", virtualTime * 1000.0 / tickCount);
+	printf("   EntityStore + TransformSystem (%u workers + caller): %.3f ms/tick\n", gThreadPool.getWorkerCount(), storeTime * 1000.0 / tickCount);
+}
+
+static void benchmarkSpatialHash() {
+	const U32 entityCount = 100000;
+	const U32 queryCount = 100000;
+	const F32 queryRadius = 8.0f;
+	const F32 extent = 1024.0f;
+
+	std::mt19937 random(BENCHMARK_SEED);
+	std::uniform_real_distribution<F32> horizontal(-extent * 0.5f, extent * 0.5f);
+	std::uniform_real_distribution<F32> vertical(0.0f, 64.0f);
+	std::uniform_real_distribution<F32> unit(-1.0f, 1.0f);
+
+	EntityStore store;
+	for (U32 i = 0; i < entityCount; ++i) {
+		Entity entity = store.create();
+		store.setPosition(entity, glm::vec3(horizontal(random), vertical(random), horizontal(random)));
+		store.setVelocity(entity, glm::vec3(unit(random), unit(random), unit(random)) * 4.0f);
+	}
+
+	std::vector<glm::vec3> queries(queryCount);
+	for (glm::vec3 &query : queries)
+		query = glm::vec3(horizontal(random), vertical(random), horizontal(random));
+
+	SpatialHash hash(static_cast<F32>(CHUNK_SIZE));
+
+	Timer timer;
+	timer.start();
+	hash.update(store);
+	timer.stop();
+	F64 buildTime = timer.getDelta();
+
+	// Move everyone for a tick and re-bin.
+	TransformSystem::integrate(store, 1.0 / 60.0);
+	timer.start();
+	hash.update(store);
+	timer.stop();
+	F64 rebinTime = timer.getDelta();
+	U32 rebinCount = hash.getRebinCount();
+
+	std::vector<U32> results;
+	U64 found = 0;
+	timer.start();
+	for (const glm::vec3 &query : queries) {
+		results.clear();
+		found += hash.queryRadius(query, queryRadius, results);
+	}
+	timer.stop();
+	F64 queryTime = timer.getDelta();
+
+	// Check a handful of queries against a brute force scan.
+	const F32 *positionX = store.getField(EntityStore::POSITION_X);
+	const F32 *positionY = store.getField(EntityStore::POSITION_Y);
+	const F32 *positionZ = store.getField(EntityStore::POSITION_Z);
+	U32 mismatches = 0;
+	for (U32 i = 0; i < 100; ++i) {
+		U32 expected = 0;
+		for (U32 slot = 0; slot < entityCount; ++slot) {
+			glm::vec3 position(positionX[slot], positionY[slot], positionZ[slot]);
+			if (glm::length(position - queries[i]) <= queryRadius)
+				++expected;
+		}
+		results.clear();
+		if (hash.queryRadius(queries[i], queryRadius, results) != expected)
+			++mismatches;
+	}
+
+	printf("spatial hash: %u entities in %u cells, %u brute force mismatches\n", entityCount, hash.getCellCount(), mismatches);
+	printf("   build: %.3f ms, re-bin after one tick: %.3f ms (%u moved cells)\n", buildTime * 1000.0, rebinTime * 1000.0, rebinCount);
+	printf("   %u radius %.1f queries: %.3f s, %.2f M queries/s, %.2f results/query\n", queryCount, queryRadius, queryTime, queryCount / queryTime / 1000000.0, static_cast<F64>(found) / queryCount);
+}
+
+static void benchmarkStreaming() {
+	const S32 radius = 6;
+	const S32 height = 4;
+	const U32 warmupFrames = 64;
+	const U32 frameCount = 256;
+
+	// In memory only, this measures the pools rather than the disk.
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+
+	auto loadSlice = [&](S32 x) {
+		for (S32 y = 0; y < height; ++y) {
+			for (S32 z = -radius; z < radius; ++z)
+				world.createChunk({ x, y, z });
+		}
+	};
+	auto unloadSlice = [&](S32 x) {
+		for (S32 y = 0; y < height; ++y) {
+			for (S32 z = -radius; z < radius; ++z)
+				world.destroyChunk({ x, y, z });
+		}
+	};
+
+	for (S32 x = -radius; x < radius; ++x)
+		loadSlice(x);
+	world.updateMeshes(~0U);
+
+	// Fly along +x one chunk per frame, unloading the slice of chunks that
+	// falls out of range and loading and meshing the one that comes into it.
+	S32 cameraX = 0;
+	auto flyFrame = [&]() {
+		unloadSlice(cameraX - radius);
+		++cameraX;
+		loadSlice(cameraX + radius - 1);
+		return world.updateMeshes(~0U);
+	};
+
+	for (U32 i = 0; i < warmupFrames; ++i)
+		flyFrame();
+
+	const ChunkPool::Stats before = world.getPool().getStats();
+	const U64 allocationsBefore = MemoryStats::getAllocationCount();
+
+	U32 meshed = 0;
+	Timer timer;
+	timer.start();
+	for (U32 i = 0; i < frameCount; ++i)
+		meshed += flyFrame();
+	timer.stop();
+
+	const U64 allocations = MemoryStats::getAllocationCount() - allocationsBefore;
+	const ChunkPool::Stats after = world.getPool().getStats();
+
+	printf("streaming: %u frames flying through %u loaded chunks\n", frameCount, after.chunksUsed);
+	printf("   %.3f ms/frame, %.1f chunks meshed/frame\n", timer.getDelta() * 1000.0 / frameCount, static_cast<F64>(meshed) / frameCount);
+	printf("   steady state: %u new pool slabs\n", after.slabCount - before.slabCount);
+	if (MemoryStats::isTracking())
+		printf("   steady state: %llu heap allocations\n", static_cast<unsigned long long>(allocations));
+	else
+		printf("   configure with VOXEL_TRACK_ALLOCATIONS to count heap allocations\n");
+	world.getPool().printStats();
+}
+
+// Buffer heap in system memory, standing in for the GPU buffers.
+class MemoryBufferHeap : public BufferHeap {
+public:
+	const U8* getData(U32 allocation) const {
+		return mPages[getPage(allocation)].data() + getOffset(allocation);
+	}
+
+protected:
+	virtual void createPage(U32 /*page*/, U32 size) override {
+		mPages.push_back(std::vector<U8>(size));
+	}
+
+	virtual void writeRange(U32 page, U32 offset, const void *data, U32 size) override {
+		memcpy(mPages[page].data() + offset, data, size);
+	}
+
+	virtual void copyRange(U32 page, U32 srcOffset, U32 dstOffset, U32 size) override {
+		memcpy(mPages[page].data() + dstOffset, mPages[page].data() + srcOffset, size);
+	}
+
+private:
+	std::vector<std::vector<U8>> mPages;
+};
+
+static void benchmarkGPUAllocation() {
+	const U32 meshCount = 4096;
+	const U32 frameCount = 4096;
+	const U32 meshesPerFrame = 48;
+	const U32 frameLatency = 3;
+	const U32 compactionMoves = 16;
+
+	// Replace random meshes every frame, except for every fourth frame which
+	// is idle and compacts the heap instead. Fences signal frameLatency frames
+	// after being submitted.
+	std::mt19937 rng(BENCHMARK_SEED);
+	std::uniform_int_distribution<U32> quadCount(16, 2048);
+	std::uniform_int_distribution<U32> meshIndex(0, meshCount - 1);
+
+	MemoryBufferHeap heap;
+	std::vector<U8> vertices(MAX_CHUNK_MESH_VERTICES * sizeof(ChunkVertex));
+	std::vector<U32> meshes(meshCount);
+	auto createMesh = [&](U32 mesh) {
+		const U32 size = quadCount(rng) * 4 * sizeof(ChunkVertex);
+		memcpy(vertices.data(), &mesh, sizeof(mesh));
+		meshes[mesh] = heap.allocate(size);
+		heap.upload(meshes[mesh], vertices.data(), size);
+	};
+
+	for (U32 i = 0; i < meshCount; ++i)
+		createMesh(i);
+
+	F32 worstFragmentation = 0.0f;
+	Timer timer;
+	timer.start();
+	for (U32 frame = 0; frame < frameCount; ++frame) {
+		if (frame >= frameLatency)
+			heap.releaseFrames(frame - frameLatency);
+
+		if (frame % 4 == 3) {
+			heap.compact(compactionMoves);
+		} else {
+			for (U32 i = 0; i < meshesPerFrame; ++i) {
+				const U32 mesh = meshIndex(rng);
+				heap.free(meshes[mesh]);
+				createMesh(mesh);
+			}
+		}
+		heap.advanceFrame();
+
+		if (frame % 64 == 0)
+			worstFragmentation = std::max(worstFragmentation, heap.getStats().fragmentation);
+	}
+	timer.stop();
+
+	// Compaction must have carried every mesh's data along.
+	U32 corrupted = 0;
+	for (U32 i = 0; i < meshCount; ++i) {
+		U32 tag;
+		memcpy(&tag, heap.getData(meshes[i]), sizeof(tag));
+		if (tag != i)
+			++corrupted;
+	}
+
+	printf("gpu allocation: %u meshes, %u frames replacing %u meshes on 3 out of 4 frames\n", meshCount, frameCount, meshesPerFrame);
+	printf("   %.3f ms/frame, worst sampled fragmentation %.1f%%, %u corrupted meshes\n", timer.getDelta() * 1000.0 / frameCount, worstFragmentation * 100.0f, corrupted);
+	heap.printStats();
+}
+
+static void benchmarkRenderQueue() {
+	const U32 drawCount = 65536;
+	const U32 frameCount = 256;
+
+	// A handful of shaders and materials, mostly opaque, at random depths.
+	std::mt19937 rng(BENCHMARK_SEED);
+	std::uniform_int_distribution<U32> shader(0, 7);
+	std::uniform_int_distribution<U32> material(0, 63);
+	std::uniform_int_distribution<U32> textureArray(0, 3);
+	std::uniform_real_distribution<F32> depth(0.0f, 1.0f);
+	std::vector<U64> keys(drawCount);
+	for (U32 i = 0; i < drawCount; ++i) {
+		if (i % 8 == 0)
+			keys[i] = RenderQueue::makeTransparentKey(shader(rng), material(rng), textureArray(rng), depth(rng));
+		else
+			keys[i] = RenderQueue::makeOpaqueKey(shader(rng), material(rng), textureArray(rng), depth(rng));
+	}
+
+	RenderQueue queue;
+	Timer radixTimer;
+	radixTimer.start();
+	for (U32 frame = 0; frame < frameCount; ++frame) {
+		queue.clear();
+		for (U32 i = 0; i < drawCount; ++i)
+			queue.submit(keys[i], i);
+		queue.sort();
+	}
+	radixTimer.stop();
+
+	std::vector<RenderItem> items;
+	Timer sortTimer;
+	sortTimer.start();
+	for (U32 frame = 0; frame < frameCount; ++frame) {
+		items.clear();
+		for (U32 i = 0; i < drawCount; ++i) {
+			RenderItem item;
+			item.key = keys[i];
+			item.draw = i;
+			items.push_back(item);
+		}
+		std::stable_sort(items.begin(), items.end(), [](const RenderItem &a, const RenderItem &b) {
+			return a.key < b.key;
+		});
+	}
+	sortTimer.stop();
+
+	// Both sorts are stable, so they have to agree on every draw.
+	U32 mismatches = 0;
+	for (U32 i = 0; i < drawCount; ++i) {
+		if (queue.getItems()[i].draw != items[i].draw)
+			++mismatches;
+	}
+
+	// Count the state changes left after sorting.
+	U32 stateChanges = 0;
+	const U64 stateMask = ~((1ULL << (RENDER_KEY_DEPTH_BITS + 8)) - 1);
+	for (U32 i = 1; i < drawCount; ++i) {
+		const U64 previous = queue.getItems()[i - 1].key;
+		const U64 current = queue.getItems()[i].key;
+		if (RenderQueue::getPass(current) == RENDER_PASS_OPAQUE && (previous & stateMask) != (current & stateMask))
+			++stateChanges;
+	}
+
+	printf("render queue: %u draws, %u frames, %u mismatches against std::stable_sort\n", drawCount, frameCount, mismatches);
+	printf("   radix sort: %.3f ms/frame, std::stable_sort: %.3f ms/frame\n", radixTimer.getDelta() * 1000.0 / frameCount, sortTimer.getDelta() * 1000.0 / frameCount);
+	printf("   %u opaque state changes after sorting\n", stateChanges);
+}
+
+static void benchmarkLod() {
+	const S32 radius = 16;
+	const S32 height = 4;
+
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+	generateWorld(world, radius, height);
+	world.updateMeshes(~0U);
+
+	U64 fullQuads = 0;
+	for (const auto &pair : world.getChunks())
+		fullQuads += pair.second->getMesh()->getQuadCount();
+
+	const glm::vec3 cameraPosition(0.0f, 48.0f, 0.0f);
+	Timer buildTimer;
+	buildTimer.start();
+	world.updateLods(cameraPosition, ~0U);
+	buildTimer.stop();
+
+	// Once every node is built an update only selects the levels.
+	Timer selectTimer;
+	selectTimer.start();
+	world.updateLods(cameraPosition, ~0U);
+	selectTimer.stop();
+
+	const LodTerrain &lod = world.getLodTerrain();
+	U64 lodQuads = 0;
+	U32 fullDetailChunks = 0;
+	for (const auto &pair : world.getChunks()) {
+		if (lod.isFullDetail(pair.first)) {
+			lodQuads += pair.second->getMesh()->getQuadCount();
+			++fullDetailChunks;
+		}
+	}
+
+	U32 levelNodes[LOD_LEVEL_COUNT] = {};
+	for (const LodNode &node : lod.getNodes()) {
+		lodQuads += node.mesh->getQuadCount();
+		++levelNodes[node.key.level];
+	}
+
+	printf("lod: %u chunks, %u blocks across, camera at the center\n", static_cast<U32>(world.getChunks().size()), radius * 2 * CHUNK_SIZE);
+	printf("   full detail: %llu quads\n", static_cast<unsigned long long>(fullQuads));
+	printf("   with lod: %llu quads, %u full detail chunks, %u/%u/%u nodes at 2x/4x/8x\n", static_cast<unsigned long long>(lodQuads), fullDetailChunks, levelNodes[1], levelNodes[2], levelNodes[3]);
+	printf("   building every node: %.3f ms, selecting levels: %.3f ms\n", buildTimer.getDelta() * 1000.0, selectTimer.getDelta() * 1000.0);
+}
+
+static void benchmarkSmoothTerrain() {
+	const S32 radius = 16;
+	const S32 height = 4;
+	const F32 distances[] = { 512.0f, 1024.0f, 2048.0f, 4096.0f };
+
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+	generateWorld(world, radius, height);
+	world.updateMeshes(~0U);
+
+	printf("smooth terrain: around %u loaded chunks, camera at the center\n", static_cast<U32>(world.getChunks().size()));
+	const glm::vec3 cameraPosition(0.0f, 48.0f, 0.0f);
+	for (F32 distance : distances) {
+		world.setSmoothTerrainDistance(distance);
+
+		// Nodes are drawn until their children are built, so each update only
+		// refines by one level.
+		Timer buildTimer;
+		buildTimer.start();
+		for (U32 level = 0; level < SMOOTH_LEVEL_COUNT; ++level)
+			world.updateLods(cameraPosition, ~0U);
+		buildTimer.stop();
+
+		Timer selectTimer;
+		selectTimer.start();
+		world.updateLods(cameraPosition, ~0U);
+		selectTimer.stop();
+
+		U32 levelNodes[SMOOTH_LEVEL_COUNT] = {};
+		U64 triangles = 0;
+		for (const SmoothNode &node : world.getSmoothTerrain().getNodes()) {
+			triangles += node.mesh->getTriangleCount();
+			++levelNodes[node.key.level];
+		}
+
+		printf("   %.0f blocks: %llu triangles in %u nodes (", distance, static_cast<unsigned long long>(triangles), static_cast<U32>(world.getSmoothTerrain().getNodes().size()));
+		for (U32 level = LOD_LEVEL_COUNT - 1; level < SMOOTH_LEVEL_COUNT; ++level)
+			printf("%s%u", level == LOD_LEVEL_COUNT - 1 ? "" : "/", levelNodes[level]);
+		printf(" at levels %u-%u), building: %.3f ms, selecting: %.3f ms\n", LOD_LEVEL_COUNT - 1, SMOOTH_LEVEL_COUNT - 1, buildTimer.getDelta() * 1000.0, selectTimer.getDelta() * 1000.0);
+	}
+}
+
+// Views of the culling benchmarks, from a room hollowed out underground and
+// from above the terrain looking down.
+struct CullingView {
+	const char *name;
+	glm::vec3 position;
+	F32 pitch;
+};
+
+static const glm::ivec3 sCullingRoom(8, 12, 8);
+static const CullingView sCullingViews[] = {
+	{ "underground", glm::vec3(sCullingRoom) + glm::vec3(0.5f), 0.0f },
+	{ "surface", glm::vec3(0.5f, 48.0f, 0.5f), -20.0f }
+};
+static const U32 sCullingDirections = 8;
+
+static void generateCullingWorld(World &world) {
+	generateWorld(world, 8, 4);
+	for (S32 y = -2; y <= 2; ++y) {
+		for (S32 z = -2; z <= 2; ++z) {
+			for (S32 x = -2; x <= 2; ++x)
+				world.setBlock(sCullingRoom + glm::ivec3(x, y, z), AIR);
+		}
+	}
+	world.updateMeshes(~0U);
+}
+
+static glm::mat4 getCullingViewProjection(const CullingView &view, U32 direction) {
+	const glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1440.f / 900.f, 0.1f, 1024.0f);
+	const F32 yaw = glm::radians(360.0f * direction / sCullingDirections);
+	const F32 pitch = glm::radians(view.pitch);
+	const glm::vec3 front(cosf(yaw) * cosf(pitch), sinf(pitch), sinf(yaw) * cosf(pitch));
+	return proj * glm::lookAt(view.position, view.position + front, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+static AABB getChunkBox(const ChunkCoord &coord) {
+	const glm::vec3 min = glm::vec3(coord.x, coord.y, coord.z) * static_cast<F32>(CHUNK_SIZE);
+	return AABB(min, min + glm::vec3(static_cast<F32>(CHUNK_SIZE)));
+}
+
+static void benchmarkOcclusion() {
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+	generateCullingWorld(world);
+
+	printf("occlusion: %u chunks, %ux%u depth buffer, %u directions per view\n", static_cast<U32>(world.getChunks().size()), OCCLUSION_WIDTH, OCCLUSION_HEIGHT, sCullingDirections);
+	for (const CullingView &view : sCullingViews) {
+		OcclusionBuffer occlusion;
+		U64 inFrustum = 0;
+		F64 time = 0.0;
+		for (U32 i = 0; i < sCullingDirections; ++i) {
+			const glm::mat4 viewProjection = getCullingViewProjection(view, i);
+			const Frustum frustum(viewProjection);
+
+			Timer timer;
+			timer.start();
+			occlusion.begin(viewProjection);
+			occlusion.addChunkOccluders(&world, frustum, view.position);
+			occlusion.rasterize();
+			for (const auto &pair : world.getChunks()) {
+				if (pair.second->getMesh()->isEmpty())
+					continue;
+
+				const AABB box = getChunkBox(pair.first);
+				if (frustum.intersects(box)) {
+					++inFrustum;
+					occlusion.isOccluded(box);
+				}
+			}
+			timer.stop();
+			time += timer.getDelta();
+		}
+		// Fold the last frame into the totals.
+		occlusion.begin(glm::mat4(1.0f));
+
+		const OcclusionBuffer::Stats &stats = occlusion.getTotalStats();
+		printf("   %s: %.1f chunks in the frustum, %.1f rejected (%.1f%%), %.1f occluders per frame, %.1f us per frame\n", view.name,
+			static_cast<F64>(inFrustum) / sCullingDirections, static_cast<F64>(stats.rejected) / sCullingDirections, inFrustum > 0 ? stats.rejected * 100.0 / inFrustum : 0.0,
+			static_cast<F64>(stats.occluders) / sCullingDirections, time / sCullingDirections * 1000000.0);
+	}
+}
+
+static void benchmarkCaveCulling() {
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+
+	generateCullingWorld(world);
+
+	// Meshing fills in the connections already, this is the cost it adds.
+	Timer timer;
+	timer.start();
+	for (const auto &pair : world.getChunks())
+		pair.second->updateFaceConnections();
+	timer.stop();
+	const U32 chunkCount = static_cast<U32>(world.getChunks().size());
+	printf("caves: %u chunks, face connections in %.2f us per chunk, %u directions per view\n", chunkCount, timer.getDelta() * 1000000.0 / chunkCount, sCullingDirections);
+
+	for (const CullingView &view : sCullingViews) {
+		ChunkVisibility visibility;
+		OcclusionBuffer occlusion;
+		U64 inFrustum = 0;
+		U64 bothRejected = 0;
+		F64 time = 0.0;
+		for (U32 i = 0; i < sCullingDirections; ++i) {
+			const glm::mat4 viewProjection = getCullingViewProjection(view, i);
+			const Frustum frustum(viewProjection);
+			occlusion.begin(viewProjection);
+			occlusion.addChunkOccluders(&world, frustum, view.position);
+			occlusion.rasterize();
+
+			timer.start();
+			visibility.update(&world, frustum, view.position);
+			timer.stop();
+			time += timer.getDelta();
+
+			for (const auto &pair : world.getChunks()) {
+				if (pair.second->getMesh()->isEmpty() || !frustum.intersects(getChunkBox(pair.first)))
+					continue;
+
+				++inFrustum;
+				const bool visible = visibility.isVisible(pair.first);
+				if (occlusion.isOccluded(getChunkBox(pair.first)) || !visible)
+					++bothRejected;
+			}
+		}
+		visibility.update(&world, Frustum(glm::mat4(1.0f)), glm::vec3(0.0f));
+		occlusion.begin(glm::mat4(1.0f));
+
+		const ChunkVisibility::Stats &stats = visibility.getTotalStats();
+		const F64 directions = static_cast<F64>(sCullingDirections);
+		printf("   %s: %.1f chunks drawn with frustum culling only, %.1f with cave culling (%.1f%% rejected), %.1f with cave and occlusion culling (%.1f%% rejected)\n", view.name,
+			inFrustum / directions, (inFrustum - stats.rejected) / directions, inFrustum > 0 ? stats.rejected * 100.0 / inFrustum : 0.0,
+			(inFrustum - bothRejected) / directions, inFrustum > 0 ? bothRejected * 100.0 / inFrustum : 0.0);
+		printf("      %.1f chunks reached in %.1f us per frame\n", stats.reached / directions, time / directions * 1000000.0);
+	}
+}
+
+// Writes a 32 bit TGA, run length encoded or not, with the rows bottom up.
+static bool writeTGA(const char *path, const Image &image, bool rle) {
+	std::vector<U8> data(18, 0);
+	data[2] = rle ? 10 : 2;
+	data[12] = image.width & 0xFF;
+	data[13] = image.width >> 8;
+	data[14] = image.height & 0xFF;
+	data[15] = image.height >> 8;
+	data[16] = 32;
+	data[17] = 8;
+	for (U32 y = image.height; y-- > 0;) {
+		const U8 *row = image.pixels.data() + y * image.width * 4;
+		for (U32 x = 0; x < image.width;) {
+			U32 count = 1;
+			if (rle) {
+				while (x + count < image.width && count < 128 && memcmp(row + x * 4, row + (x + count) * 4, 4) == 0)
+					++count;
+				data.push_back(static_cast<U8>(0x80 | (count - 1)));
+			}
+			const U8 *pixel = row + x * 4;
+			const U8 bgra[4] = { pixel[2], pixel[1], pixel[0], pixel[3] };
+			data.insert(data.end(), bgra, bgra + 4);
+			x += count;
+		}
+	}
+
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr)
+		return false;
+	const bool written = fwrite(data.data(), data.size(), 1, file) == 1;
+	fclose(file);
+	return written;
+}
+
+static void benchmarkTextures() {
+	const U32 imageCount = 64;
+	const U32 size = 256;
+
+	// Blocky noise, so the run length encoded half has runs to find.
+	std::mt19937 random(BENCHMARK_SEED);
+	std::vector<Image> images(imageCount);
+	std::vector<std::string> paths(imageCount);
+	for (U32 i = 0; i < imageCount; ++i) {
+		Image &image = images[i];
+		image.width = size;
+		image.height = size;
+		image.pixels.resize(size * size * 4);
+		for (U32 p = 0; p < size * size; p += 4) {
+			const U32 color = random();
+			for (U32 j = 0; j < 4; ++j)
+				memcpy(&image.pixels[(p + j) * 4], &color, 4);
+		}
+
+		char path[64];
+		snprintf(path, sizeof(path), "benchmark_texture_%u.tga", i);
+		paths[i] = path;
+		if (!writeTGA(path, image, (i & 1) != 0)) {
+			printf("textures: unable to write %s\n", path);
+			return;
+		}
+	}
+
+	// Everything on the calling thread, as a blocking startup would.
+	Timer timer;
+	timer.start();
+	U32 mismatches = 0;
+	for (U32 i = 0; i < imageCount; ++i) {
+		FILE *file = fopen(paths[i].c_str(), "rb");
+		std::vector<U8> data;
+		U8 buffer[4096];
+		size_t read;
+		while (file != nullptr && (read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			data.insert(data.end(), buffer, buffer + read);
+		if (file != nullptr)
+			fclose(file);
+
+		Image image;
+		if (!ImageLoader::decodeTGA(data.data(), data.size(), image) || image.pixels != images[i].pixels)
+			++mismatches;
+	}
+	timer.stop();
+	const F64 blocking = timer.getDelta();
+
+	// Through the loader, polling once per simulated frame.
+	ImageLoader loader;
+	timer.start();
+	for (U32 i = 0; i < imageCount; ++i)
+		loader.request(paths[i], i);
+	timer.stop();
+	const F64 requesting = timer.getDelta();
+
+	timer.start();
+	U32 frames = 0;
+	F64 longestPoll = 0.0;
+	std::vector<ImageLoader::Result> results(imageCount);
+	U32 resultCount = 0;
+	while (loader.getPendingCount() > 0) {
+		Timer poll;
+		poll.start();
+		while (loader.poll(results[resultCount]))
+			++resultCount;
+		poll.stop();
+		longestPoll = std::max(longestPoll, poll.getDelta());
+		++frames;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	timer.stop();
+	loader.shutdown();
+
+	for (const ImageLoader::Result &result : results) {
+		if (!result.loaded || result.image.pixels != images[result.id].pixels)
+			++mismatches;
+	}
+
+	for (const std::string &path : paths)
+		remove(path.c_str());
+
+	printf("textures: %u %ux%u images, half run length encoded, %u loader threads\n", imageCount, size, size, IMAGE_LOADER_THREADS);
+	printf("   blocking: %.2f ms on the calling thread\n", blocking * 1000.0);
+	printf("   async: %.3f ms to request, %.3f ms longest poll, all loaded after %.2f ms over %u frames\n", requesting * 1000.0, longestPoll * 1000.0, (requesting + timer.getDelta()) * 1000.0, frames);
+	printf("   %u images decoded wrong\n", mismatches);
+}
+
+struct BenchmarkEntry {
+	const char *name;
+	void (*function)();
+};
+
+static void benchmarkTranslucentSorting() {
+	const S32 radius = 16;
+	const S32 height = 4;
+
+	// Matches the renderer's budget of quads re-sorted per frame.
+	const U32 sortBudget = 16384;
+
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+	generateWorld(world, radius, height);
+	world.updateMeshes(~0U);
+
+	// The renderer's queue after the camera crossed into the center chunk.
+	const ChunkCoord cameraChunk = { 0, 1, 0 };
+	const glm::vec3 cameraPosition(8.0f, 24.0f, 8.0f);
+	std::vector<const Chunk*> chunks;
+	U64 opaqueQuads = 0;
+	U64 translucentQuads = 0;
+	U32 largest = 0;
+	for (const auto &pair : world.getChunks()) {
+		const ChunkMesh *mesh = pair.second->getMesh();
+		opaqueQuads += mesh->getOpaqueQuadCount();
+		if (mesh->getTranslucentQuadCount() == 0)
+			continue;
+		translucentQuads += mesh->getTranslucentQuadCount();
+		largest = std::max(largest, mesh->getTranslucentQuadCount());
+		chunks.push_back(pair.second);
+	}
+	std::sort(chunks.begin(), chunks.end(), [&cameraChunk](const Chunk *a, const Chunk *b) {
+		const glm::ivec3 da(a->getCoord().x - cameraChunk.x, a->getCoord().y - cameraChunk.y, a->getCoord().z - cameraChunk.z);
+		const glm::ivec3 db(b->getCoord().x - cameraChunk.x, b->getCoord().y - cameraChunk.y, b->getCoord().z - cameraChunk.z);
+		return da.x * da.x + da.y * da.y + da.z * da.z < db.x * db.x + db.y * db.y + db.z * db.z;
+	});
+
+	std::vector<ChunkVertex> sorted(largest * 4);
+	std::vector<U32> scratch;
+	U32 frames = 0;
+	U32 frameQuads = 0;
+	F64 longestFrame = 0.0;
+	F64 frameTime = 0.0;
+	U32 outOfOrder = 0;
+	Timer totalTimer;
+	totalTimer.start();
+	for (const Chunk *chunk : chunks) {
+		const ChunkMesh *mesh = chunk->getMesh();
+		const U32 quadCount = mesh->getTranslucentQuadCount();
+		const glm::vec3 origin = glm::vec3(chunk->getCoord().x, chunk->getCoord().y, chunk->getCoord().z) * static_cast<F32>(CHUNK_SIZE);
+
+		Timer timer;
+		timer.start();
+		ChunkMesher::sortQuads(mesh->vertices + mesh->translucentOffset, quadCount, cameraPosition - origin, scratch, sorted.data());
+		timer.stop();
+
+		// A chunk always gets sorted whole, so a frame can go over the budget
+		// by up to one chunk.
+		if (frameQuads == 0)
+			++frames;
+		frameQuads += quadCount;
+		frameTime += timer.getDelta();
+		if (frameQuads >= sortBudget) {
+			longestFrame = std::max(longestFrame, frameTime);
+			frameQuads = 0;
+			frameTime = 0.0;
+		}
+
+		// Farther quads have to come first, up to the key's resolution.
+		F32 previous = FLT_MAX;
+		for (U32 i = 0; i < quadCount; ++i) {
+			glm::vec3 center(0.0f);
+			for (U32 j = 0; j < 4; ++j) {
+				const ChunkVertex &vertex = sorted[i * 4 + j];
+				center += glm::vec3(vertex.x, vertex.y, vertex.z) * 0.25f;
+			}
+			const F32 distance = glm::length(center + origin - cameraPosition);
+			if (distance > previous + 0.5f)
+				++outOfOrder;
+			previous = distance;
+		}
+	}
+	totalTimer.stop();
+	longestFrame = std::max(longestFrame, frameTime);
+
+	printf("translucent: %u chunks, %u with translucent quads\n", static_cast<U32>(world.getChunks().size()), static_cast<U32>(chunks.size()));
+	printf("   %llu opaque quads, %llu translucent quads, at most %u in a chunk\n", static_cast<unsigned long long>(opaqueQuads), static_cast<unsigned long long>(translucentQuads), largest);
+	printf("   re-sorting everything: %.3f ms, %.1f ns per quad, %u quads out of order\n", totalTimer.getDelta() * 1000.0, translucentQuads > 0 ? totalTimer.getDelta() * 1e9 / translucentQuads : 0.0, outOfOrder);
+	printf("   at %u quads per frame: %u frames to catch up, longest frame %.3f ms\n", sortBudget, frames, longestFrame * 1000.0);
+}
+
+static void benchmarkFluids() {
+	const S32 height = 4;
+	const S32 radii[] = { 4, 16 };
+	const U32 maxSteps = 1000;
+
+	for (S32 radius : radii) {
+		TerrainGenerator generator(BENCHMARK_SEED);
+		World world("");
+		world.setTerrainGenerator(&generator);
+		generateWorld(world, radius, height);
+		FluidSimulation &fluids = world.getFluids();
+
+		// Nothing has been woken, so a step over the whole world is free.
+		Timer idleTimer;
+		idleTimer.start();
+		fluids.step();
+		idleTimer.stop();
+
+		// Pour a source of water and one of lava on the ground near the
+		// center and let them run until they settle.
+		const glm::ivec2 sources[] = { glm::ivec2(3, 5), glm::ivec2(-20, 12) };
+		for (U32 i = 0; i < 2; ++i) {
+			S32 y = height * CHUNK_SIZE - 2;
+			while (y > 0 && !isSolidBlock(world.getBlock(glm::ivec3(sources[i].x, y, sources[i].y))))
+				--y;
+			world.setBlock(glm::ivec3(sources[i].x, y + 1, sources[i].y), i == 0 ? BlockType::WATER : BlockType::LAVA);
+		}
+
+		U32 steps = 0;
+		U32 peakCells = 0;
+		F64 longestStep = 0.0;
+		F64 flowTime = 0.0;
+		while (fluids.getActiveChunkCount() > 0 && steps < maxSteps) {
+			peakCells = std::max(peakCells, fluids.getActiveCellCount());
+			Timer stepTimer;
+			stepTimer.start();
+			fluids.step();
+			stepTimer.stop();
+			flowTime += stepTimer.getDelta();
+			longestStep = std::max(longestStep, stepTimer.getDelta());
+			++steps;
+		}
+
+		const FluidSimulation::Stats &total = fluids.getTotalStats();
+		printf("fluids: %u chunks, %u blocks across\n", static_cast<U32>(world.getChunks().size()), radius * 2 * CHUNK_SIZE);
+		printf("   idle step: %.3f ms\n", idleTimer.getDelta() * 1000.0);
+		printf("   settled after %u steps%s, %llu cells evaluated, %llu changed, at most %u active\n", steps, steps == maxSteps ? " (gave up)" : "", static_cast<unsigned long long>(total.cells), static_cast<unsigned long long>(total.changes), peakCells);
+		printf("   %.3f ms per step, longest %.3f ms, %.1f ns per cell\n", flowTime * 1000.0 / std::max(steps, 1U), longestStep * 1000.0, total.cells > 0 ? flowTime * 1e9 / total.cells : 0.0);
+	}
+}
+
+static void benchmarkBlockTicks() {
+	const S32 radius = 16;
+	const S32 height = 4;
+	const U32 randomSteps = 200;
+	const U32 maxSteps = 1000;
+
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+	generateWorld(world, radius, height);
+	BlockTickScheduler &ticks = world.getBlockTicks();
+
+	// Only random ticks, the grass all over the terrain.
+	Timer randomTimer;
+	randomTimer.start();
+	for (U32 i = 0; i < randomSteps; ++i)
+		ticks.step();
+	randomTimer.stop();
+	const BlockTickScheduler::Stats randomStats = ticks.getTotalStats();
+
+	// Drop a slab of sand from the top of the world and time the steps until
+	// all of it has landed.
+	const S32 top = height * CHUNK_SIZE - 1;
+	for (S32 z = -8; z < 8; ++z) {
+		for (S32 x = -8; x < 8; ++x)
+			world.setBlock(glm::ivec3(x, top, z), BlockType::SAND);
+	}
+	U32 steps = 0;
+	U32 peakScheduled = 0;
+	Timer fallTimer;
+	fallTimer.start();
+	while (ticks.getScheduledCount() > 0 && steps < maxSteps) {
+		peakScheduled = std::max(peakScheduled, ticks.getScheduledCount());
+		ticks.step();
+		++steps;
+	}
+	fallTimer.stop();
+	const BlockTickScheduler::Stats &total = ticks.getTotalStats();
+	const U64 fallTicks = total.scheduledTicks - randomStats.scheduledTicks;
+
+	printf("blockticks: %u chunks, %u blocks across\n", static_cast<U32>(world.getChunks().size()), radius * 2 * CHUNK_SIZE);
+	printf("   random: %.3f ms per step, %.1f ticks per step\n", randomTimer.getDelta() * 1000.0 / randomSteps, static_cast<F64>(randomStats.randomTicks) / randomSteps);
+	printf("   falling sand: landed after %u steps%s, %llu scheduled ticks, at most %u pending, %.3f ms per step\n", steps, steps == maxSteps ? " (gave up)" : "", static_cast<unsigned long long>(fallTicks), peakScheduled, fallTimer.getDelta() * 1000.0 / std::max(steps, 1U));
+	printf("   %.0f ticks per second, %.1f ticks per batch\n", total.seconds > 0.0 ? (total.scheduledTicks + total.randomTicks) / total.seconds : 0.0, total.batches > 0 ? static_cast<F64>(total.scheduledTicks + total.randomTicks) / total.batches : 0.0);
+}
+
+static void benchmarkCollapse() {
+	const S32 radius = 8;
+	const S32 height = 4;
+	const S32 digs = 512;
+	const S32 platformSize = 48;
+	const U32 maxFrames = 2000;
+	const F64 delta = 1.0 / 60.0;
+
+	TerrainGenerator generator(BENCHMARK_SEED);
+	World world("");
+	world.setTerrainGenerator(&generator);
+	generateWorld(world, radius, height);
+	StructuralIntegrity &structure = world.getStructuralIntegrity();
+
+	// Dig into the terrain, every block removed is searched around and found
+	// to be supported.
+	std::mt19937 rng(BENCHMARK_SEED);
+	std::uniform_int_distribution<S32> column(-radius * CHUNK_SIZE + 1, radius * CHUNK_SIZE - 2);
+	const S32 top = height * CHUNK_SIZE - 2;
+	for (S32 i = 0; i < digs; ++i) {
+		glm::ivec3 pos(column(rng), top, column(rng));
+		while (pos.y > 0 && !isSolidBlock(world.getBlock(pos)))
+			--pos.y;
+		world.setBlock(pos - glm::ivec3(0, 2, 0), BlockType::AIR);
+	}
+	Timer digTimer;
+	digTimer.start();
+	U32 digFrames = 0;
+	while (!structure.isIdle() && digFrames < maxFrames) {
+		structure.update(delta);
+		++digFrames;
+	}
+	digTimer.stop();
+	const StructuralIntegrity::Stats digStats = structure.getTotalStats();
+
+	// A platform held up by a tower at one corner, then knock out the top of
+	// the tower.
+	const S32 platformY = top - 4;
+	const glm::ivec3 corner(-platformSize / 2, platformY, -platformSize / 2);
+	for (S32 z = 0; z < platformSize; ++z) {
+		for (S32 x = 0; x < platformSize; ++x)
+			world.setBlock(corner + glm::ivec3(x, 0, z), BlockType::STONE);
+	}
+	for (S32 y = platformY; y > 0 && !isSolidBlock(world.getBlock(glm::ivec3(corner.x - 1, y, corner.z))); --y)
+		world.setBlock(glm::ivec3(corner.x - 1, y, corner.z), BlockType::STONE);
+	while (!structure.isIdle())
+		structure.update(delta);
+	const StructuralIntegrity::Stats buildStats = structure.getTotalStats();
+
+	world.setBlock(glm::ivec3(corner.x - 1, platformY, corner.z), BlockType::AIR);
+	U32 frames = 0;
+	U32 detectedFrame = 0;
+	F64 maxFrameTime = 0.0;
+	Timer fallTimer;
+	fallTimer.start();
+	while (!structure.isIdle() && frames < maxFrames) {
+		structure.update(delta);
+		++frames;
+		if (detectedFrame == 0 && structure.getFallingCount() > 0)
+			detectedFrame = frames;
+		maxFrameTime = std::max(maxFrameTime, structure.getFrameStats().seconds);
+	}
+	fallTimer.stop();
+	const StructuralIntegrity::Stats &total = structure.getTotalStats();
+
+	S32 landedY = platformY;
+	while (landedY > 0 && world.getBlock(glm::ivec3(0, landedY, 0)) != BlockType::STONE)
+		--landedY;
+
+	printf("collapse: %u chunks, %u blocks across\n", static_cast<U32>(world.getChunks().size()), radius * 2 * CHUNK_SIZE);
+	printf("   dig: %d blocks removed, %llu fills visited %llu cells, %llu islands, %.3f ms over %u frames\n", digs, static_cast<unsigned long long>(digStats.fills), static_cast<unsigned long long>(digStats.visitedCells), static_cast<unsigned long long>(digStats.islands), digTimer.getDelta() * 1000.0, digFrames);
+	printf("   platform: %d blocks, found falling after %u frames, landed %d blocks lower after %u frames%s\n", platformSize * platformSize, detectedFrame, platformY - landedY, frames, frames == maxFrames ? " (gave up)" : "");
+	printf("   %llu cells visited, %llu blocks moved, %.3f ms per frame, %.3f ms at most\n", static_cast<unsigned long long>(total.visitedCells - buildStats.visitedCells), static_cast<unsigned long long>(total.movedBlocks - buildStats.movedBlocks), fallTimer.getDelta() * 1000.0 / std::max(frames, 1U), maxFrameTime * 1000.0);
+}
+
+static BenchmarkEntry sBenchmarks[] = {
+	{ "raycast", benchmarkRaycast },
+	{ "collision", benchmarkCollision },
+	{ "entities", benchmarkEntities },
+	{ "spatialhash", benchmarkSpatialHash },
+	{ "streaming", benchmarkStreaming },
+	{ "gpualloc", benchmarkGPUAllocation },
+	{ "renderqueue", benchmarkRenderQueue },
+	{ "lod", benchmarkLod },
+	{ "smooth", benchmarkSmoothTerrain },
+	{ "occlusion", benchmarkOcclusion },
+	{ "caves", benchmarkCaveCulling },
+	{ "textures", benchmarkTextures },
+	{ "translucent", benchmarkTranslucentSorting },
+	{ "fluids", benchmarkFluids },
+	{ "blockticks", benchmarkBlockTicks },
+	{ "collapse", benchmarkCollapse },
+};
+
+bool Benchmark::run(const char *name) {
+	for (const BenchmarkEntry &entry : sBenchmarks) {
+		if (SDL_strcasecmp(entry.name, name) == 0) {
+			entry.function();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Benchmark::replay(const char *path, bool hugePages, bool flyover) {
+	if (!gEventManager.startPlayback(path))
+		return false;
+
+	GameSession session("", hugePages, flyover);
+	const F64 delta = EventManager::PLAYBACK_TIMESTEP;
+	std::vector<F64> tickTimes;
+	Timer timer;
+	while (true) {
+		timer.start();
+		if (!gEventManager.playbackEvents(delta))
+			break;
+		session.tick(delta);
+		timer.stop();
+		tickTimes.push_back(timer.getDelta());
+	}
+
+	if (tickTimes.empty()) {
+		printf("replay: %s has no ticks\n", path);
+		return true;
+	}
+
+	F64 total = 0.0;
+	for (F64 time : tickTimes)
+		total += time;
+	std::sort(tickTimes.begin(), tickTimes.end());
+
+	F32 yaw, pitch;
+	session.getCamera().getYawPitch(yaw, pitch);
+	const glm::vec3 position = session.getCamera().getPosition();
+	printf("replay: %u ticks of %s\n", static_cast<U32>(tickTimes.size()), path);
+	printf("   tick: %.4f ms average, %.4f ms median, %.4f ms max\n", total / tickTimes.size() * 1000.0, tickTimes[tickTimes.size() / 2] * 1000.0, tickTimes.back() * 1000.0);
+	printf("   camera: position %.4f %.4f %.4f, yaw %.4f, pitch %.4f\n", position.x, position.y, position.z, yaw, pitch);
+	return true;
+}
+
+void Benchmark::printBenchmarks() {
+	printf("Available benchmarks:\n");
+	for (const BenchmarkEntry &entry : sBenchmarks)
+		printf("   %s\n", entry.name);
+}
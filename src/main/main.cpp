@@ -1,14 +1,66 @@
+#include <stdio.h>
+#include <thread>
 #include <SDL.h>
+#include "core/frameArena.hpp"
+#include "core/threadPool.hpp"
+#include "main/benchmark.hpp"
 #include "platform/window.hpp"
 #include "platform/timer.hpp"
 #include "platform/event/eventManager.hpp"
-#include "game/camera.hpp"
+#include "game/gameSession.hpp"
+#include "world/blockTickScheduler.hpp"
+#include "world/structuralIntegrity.hpp"
 #undef main
 
 #include <Windows.h>
 
 int main(int argc, const char **argv) {
 	SDL_Init(SDL_INIT_EVERYTHING);
+	const U64 startTime = SDL_GetPerformanceCounter();
+	gThreadPool.init();
+
+	// -benchmark <name> runs a benchmark without opening a window.
+	for (int i = 0; i < argc; ++i) {
+		if (SDL_strcasecmp(argv[i], "-benchmark") == 0) {
+			if (i + 1 >= argc || !Benchmark::run(argv[i + 1]))
+				Benchmark::printBenchmarks();
+
+			gThreadPool.shutdown();
+			SDL_Quit();
+			return 0;
+		}
+	}
+
+	// -record <file> records all input, -replay <file> plays it back at a
+	// fixed timestep instead of using live input. Both run on a fresh world
+	// from the generator that is never saved, so a recording always plays
+	// back against the world it was made in. With -headless the replay
+	// runs without opening a window. -flyover draws the smooth terrain far
+	// beyond the loaded chunks for flyover and spectating.
+	const char *recordPath = nullptr;
+	const char *replayPath = nullptr;
+	bool headless = false;
+	bool hugePages = false;
+	bool flyover = false;
+	for (int i = 0; i < argc; ++i) {
+		if (SDL_strcasecmp(argv[i], "-record") == 0 && i + 1 < argc)
+			recordPath = argv[i + 1];
+		else if (SDL_strcasecmp(argv[i], "-replay") == 0 && i + 1 < argc)
+			replayPath = argv[i + 1];
+		else if (SDL_strcasecmp(argv[i], "-headless") == 0)
+			headless = true;
+		else if (SDL_strcasecmp(argv[i], "-hugepages") == 0)
+			hugePages = true;
+		else if (SDL_strcasecmp(argv[i], "-flyover") == 0)
+			flyover = true;
+	}
+
+	if (replayPath != nullptr && headless) {
+		Benchmark::replay(replayPath, hugePages, flyover);
+		gThreadPool.shutdown();
+		SDL_Quit();
+		return 0;
+	}
 
 	ContextAPI api = ContextAPI::OpenGL;
 
@@ -23,26 +75,92 @@ int main(int argc, const char **argv) {
 	}
 #endif
 
+	// -inputthread samples input on this thread and moves the game loop and
+	// rendering to a thread of its own. Cocoa only allows window calls from the
+	// main thread, which the listeners make, so it isn't available there.
+	bool threadedInput = false;
+#ifndef __APPLE__
+	for (int i = 0; i < argc; ++i) {
+		if (SDL_strcasecmp(argv[i], "-inputthread") == 0) {
+			threadedInput = true;
+			break;
+		}
+	}
+#endif
+
 	// create window and pause for 1 second.
 	Window *window = new Window("Test", 1440, 900, Window::Flags::NONE, api);
-	Camera camera;
-	camera.setPosition(glm::vec3(3.0f, 3.0f, -3.0f));
-	RENDERER->setActiveSceneCamera(&camera);
+	const char *savePath = recordPath != nullptr || replayPath != nullptr ? "" : "world";
+	GameSession *session = new GameSession(savePath, hugePages, flyover);
+	RENDERER->setActiveSceneCamera(&session->getCamera());
+	RENDERER->setWorld(&session->getWorld());
 	
 	Timer timer;
-	
-	while (gEventManager.pullEvents(timer.getDelta())) {
-		camera.update(timer.getDelta());
+	bool firstFrame = true;
+	auto tick = [&](const F64 &delta) {
+		session->tick(delta);
 
 		timer.start();
 		RENDERER->beginFrame();
+		RENDERER->renderChunks();
 		RENDERER->renderSingleCube();
 		RENDERER->endFrame();
 		window->swapBuffers();
 		timer.stop();
+
+		if (firstFrame) {
+			firstFrame = false;
+			const F64 seconds = static_cast<F64>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+			printf("Startup: first frame after %.2f ms\n", seconds * 1000.0);
+		}
+	};
+	
+	if (recordPath != nullptr)
+		gEventManager.startRecording(recordPath);
+
+	if (replayPath != nullptr && gEventManager.startPlayback(replayPath)) {
+		U64 start = SDL_GetPerformanceCounter();
+		U32 frames = 0;
+		while (gEventManager.playbackEvents(EventManager::PLAYBACK_TIMESTEP)) {
+			tick(EventManager::PLAYBACK_TIMESTEP);
+			++frames;
+		}
+
+		F64 seconds = static_cast<F64>(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+		if (frames > 0)
+			printf("replay: %u frames, %.4f ms average frame time\n", frames, seconds / frames * 1000.0);
+	} else if (threadedInput) {
+		// SDL can only pump events on the thread that created the window, so
+		// that thread becomes the input thread and hands the context over.
+		gCurrentContext->makeCurrent(false);
+		std::thread gameThread([&]() {
+			gCurrentContext->makeCurrent(true);
+			while (gEventManager.processInput(timer.getDelta()))
+				tick(timer.getDelta());
+			gCurrentContext->makeCurrent(false);
+		});
+
+		while (gEventManager.sampleInput())
+			SDL_Delay(1);
+
+		gameThread.join();
+		gCurrentContext->makeCurrent(true);
+	} else {
+		while (gEventManager.pullEvents(timer.getDelta()))
+			tick(timer.getDelta());
 	}
+	gEventManager.stopRecording();
+
 	delete window;
+
+#ifndef NDEBUG
+	session->getWorld().getBlockTicks().printStats();
+	session->getWorld().getStructuralIntegrity().printStats();
+	FrameArena::printStats();
+#endif
+	delete session;
 	
+	gThreadPool.shutdown();
 	SDL_Quit();
 	return 0;
 }
\ No newline at end of file
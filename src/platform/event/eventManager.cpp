@@ -29,6 +29,7 @@
 //-----------------------------------------------------------------------------
 
 #include <assert.h>
+#include <string.h>
 #include "core/algorithm.hpp"
 #include "core/types.hpp"
 #include "platform/event/eventManager.hpp"
@@ -37,71 +38,383 @@
 #include "platform/event/interface/IMouseMovementEvent.hpp"
 #include "platform/event/interface/IWindowEvent.hpp"
 
+// Recordings start with the magic and version, followed by records of a tick
+// number, a record type and the payload of that type.
+#define RECORDING_MAGIC 0x52495856 // VXIR
+#define RECORDING_VERSION 1
+
+#define KEYBOARD_PAYLOAD_SIZE 3
+#define MOUSE_BUTTON_PAYLOAD_SIZE 1
+#define MOUSE_MOVEMENT_PAYLOAD_SIZE (sizeof(F32) * 4)
+
+#define MOUSE_BUTTON_PRESSED (1 << 0)
+#define MOUSE_BUTTON_LEFT (1 << 1)
+#define MOUSE_BUTTON_RIGHT (1 << 2)
+#define MOUSE_BUTTON_MIDDLE (1 << 3)
+#define MOUSE_BUTTON_DOUBLE (1 << 4)
+
 EventManager gEventManager;
 
-bool EventManager::pullEvents(const F64 &delta) const {
+const U32 EventManager::INPUT_QUEUE_CAPACITY;
+const F64 EventManager::PLAYBACK_TIMESTEP = 1.0 / 60.0;
+
+EventManager::EventManager() : mInputQueue(INPUT_QUEUE_CAPACITY) {
+	mCoalesceMouseMotion = true;
+	mQuitRequested = false;
+	mDroppedInput = 0;
+	mTick = 0;
+	mRecordFile = nullptr;
+	mPlaybackCursor = 0;
+}
+
+EventManager::~EventManager() {
+	stopRecording();
+}
+
+bool EventManager::pullEvents(const F64 &delta) {
+	SDL_Event e;
+	while (SDL_PollEvent(&e)) {
+		if (e.type == SDL_EventType::SDL_QUIT) {
+			flushMouseMotion();
+			return false;
+		}
+		queueEvent(e, delta, SDL_GetPerformanceCounter());
+	}
+	flushMouseMotion();
+	++mTick;
+	return true;
+}
+
+bool EventManager::sampleInput() {
+	InputSample sample;
+	while (SDL_PollEvent(&sample.event)) {
+		if (sample.event.type == SDL_EventType::SDL_QUIT) {
+			mQuitRequested.store(true, std::memory_order_release);
+			return false;
+		}
+
+		sample.timestamp = SDL_GetPerformanceCounter();
+		if (!mInputQueue.push(sample))
+			mDroppedInput.fetch_add(1, std::memory_order_relaxed);
+	}
+	return !mQuitRequested.load(std::memory_order_acquire);
+}
+
+bool EventManager::processInput(const F64 &delta) {
+	// Only drain what was sampled before this tick started, input that
+	// arrives while dispatching belongs to the next tick.
+	bool quit = mQuitRequested.load(std::memory_order_acquire);
+
+	InputSample sample;
+	for (U32 count = mInputQueue.getSize(); count > 0 && mInputQueue.pop(sample); --count)
+		queueEvent(sample.event, delta, sample.timestamp);
+	flushMouseMotion();
+	++mTick;
+	return !quit;
+}
+
+void EventManager::queueEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) {
+	if (e.type != SDL_EventType::SDL_MOUSEMOTION) {
+		flushMouseMotion();
+		dispatchEvent(e, delta, timestamp);
+		return;
+	}
+
+	MouseMovementEvent ev;
+	ev.frameDelta = delta;
+	ev.timestamp = timestamp;
+	ev.mousePosition = glm::vec2(e.motion.x, e.motion.y);
+	ev.mouseDelta = glm::vec2(e.motion.xrel, e.motion.yrel);
+
+	if (mCoalesceMouseMotion && !mPendingMouseMotion.empty()) {
+		MouseMovementEvent &last = mPendingMouseMotion.back();
+		last.mouseDelta += ev.mouseDelta;
+		last.mousePosition = ev.mousePosition;
+		last.timestamp = ev.timestamp;
+	} else {
+		mPendingMouseMotion.push_back(ev);
+	}
+}
+
+void EventManager::flushMouseMotion() {
+	if (mPendingMouseMotion.empty())
+		return;
+
+	dispatchMouseMovements(mPendingMouseMotion.data(), static_cast<U32>(mPendingMouseMotion.size()));
+	mPendingMouseMotion.clear();
+}
+
+bool EventManager::startRecording(const std::string &path) {
+	stopRecording();
+
+	mRecordFile = fopen(path.c_str(), "wb");
+	if (mRecordFile == nullptr) {
+		printf("Unable to open input recording %s\n", path.c_str());
+		return false;
+	}
+
+	const U32 header[2] = { RECORDING_MAGIC, RECORDING_VERSION };
+	fwrite(header, sizeof(header), 1, mRecordFile);
+	mTick = 0;
+	return true;
+}
+
+void EventManager::stopRecording() {
+	if (mRecordFile == nullptr)
+		return;
+
+	// Mark the tick we stopped at so playback runs for just as long.
+	writeRecord(RECORD_END, nullptr, 0);
+	fclose(mRecordFile);
+	mRecordFile = nullptr;
+}
+
+bool EventManager::startPlayback(const std::string &path) {
+	stopRecording();
+	mPlayback.clear();
+	mPlaybackCursor = 0;
+
+	FILE *file = fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		printf("Unable to open input recording %s\n", path.c_str());
+		return false;
+	}
+
+	U32 header[2];
+	if (fread(header, sizeof(header), 1, file) != 1 || header[0] != RECORDING_MAGIC || header[1] != RECORDING_VERSION) {
+		printf("%s is not an input recording\n", path.c_str());
+		fclose(file);
+		return false;
+	}
+
+	RecordedEvent record = RecordedEvent();
+	U8 type;
+	U8 payload[MOUSE_MOVEMENT_PAYLOAD_SIZE];
+	while (fread(&record.tick, sizeof(U32), 1, file) == 1 && fread(&type, sizeof(U8), 1, file) == 1) {
+		record.type = static_cast<RecordType>(type);
+		bool valid = true;
+		switch (record.type) {
+			case RECORD_KEYBOARD: {
+				valid = fread(payload, KEYBOARD_PAYLOAD_SIZE, 1, file) == 1;
+				U16 scanCode;
+				memcpy(&scanCode, payload + 1, sizeof(U16));
+				record.keyboard.isPressedDown = payload[0] != 0;
+				record.keyboard.scanCode = static_cast<SDL_Scancode>(scanCode);
+				break;
+			}
+			case RECORD_MOUSE_BUTTON:
+				valid = fread(payload, MOUSE_BUTTON_PAYLOAD_SIZE, 1, file) == 1;
+				record.mouseButton.isPressedDown = (payload[0] & MOUSE_BUTTON_PRESSED) != 0;
+				record.mouseButton.leftClick = (payload[0] & MOUSE_BUTTON_LEFT) != 0;
+				record.mouseButton.rightClick = (payload[0] & MOUSE_BUTTON_RIGHT) != 0;
+				record.mouseButton.middleClick = (payload[0] & MOUSE_BUTTON_MIDDLE) != 0;
+				record.mouseButton.doubleClick = (payload[0] & MOUSE_BUTTON_DOUBLE) != 0;
+				break;
+			case RECORD_MOUSE_MOVEMENT:
+				valid = fread(payload, MOUSE_MOVEMENT_PAYLOAD_SIZE, 1, file) == 1;
+				memcpy(&record.mouseMovement.mouseDelta.x, payload + 0, sizeof(F32));
+				memcpy(&record.mouseMovement.mouseDelta.y, payload + 4, sizeof(F32));
+				memcpy(&record.mouseMovement.mousePosition.x, payload + 8, sizeof(F32));
+				memcpy(&record.mouseMovement.mousePosition.y, payload + 12, sizeof(F32));
+				break;
+			case RECORD_END:
+				break;
+			default:
+				valid = false;
+				break;
+		}
+		if (!valid)
+			break;
+
+		mPlayback.push_back(record);
+		if (record.type == RECORD_END)
+			break;
+	}
+	fclose(file);
+
+	// A recording that was cut short still plays back up to its last event.
+	if (mPlayback.empty() || mPlayback.back().type != RECORD_END) {
+		record.type = RECORD_END;
+		record.tick = mPlayback.empty() ? 0 : mPlayback.back().tick + 1;
+		mPlayback.push_back(record);
+	}
+
+	mTick = 0;
+	return true;
+}
+
+bool EventManager::playbackEvents(const F64 &delta) {
+	if (!isPlayingBack())
+		return false;
+
 	SDL_Event e;
 	while (SDL_PollEvent(&e)) {
-		switch (e.type) {
-			case SDL_EventType::SDL_KEYDOWN:
-			case SDL_EventType::SDL_KEYUP:
-				dispatchKeyEvent(e, delta);
+		if (e.type == SDL_EventType::SDL_QUIT)
+			return false;
+	}
+
+	const U64 timestamp = SDL_GetPerformanceCounter();
+	while (mPlaybackCursor < mPlayback.size() && mPlayback[mPlaybackCursor].tick <= mTick) {
+		const RecordedEvent &record = mPlayback[mPlaybackCursor];
+		if (record.type == RECORD_END)
+			break;
+		++mPlaybackCursor;
+
+		switch (record.type) {
+			case RECORD_KEYBOARD: {
+				flushMouseMotion();
+				KeyboardEvent ev = record.keyboard;
+				ev.frameDelta = delta;
+				ev.timestamp = timestamp;
+				dispatch(ev);
 				break;
-			case SDL_EventType::SDL_MOUSEBUTTONDOWN:
-			case SDL_EventType::SDL_MOUSEBUTTONUP:
-				dispatchMouseButtonEvent(e, delta);
+			}
+			case RECORD_MOUSE_BUTTON: {
+				flushMouseMotion();
+				MouseButtonEvent ev = record.mouseButton;
+				ev.frameDelta = delta;
+				ev.timestamp = timestamp;
+				dispatch(ev);
 				break;
-			case SDL_EventType::SDL_MOUSEMOTION:
-				dispatchMouseMotionEvent(e, delta);
+			}
+			case RECORD_MOUSE_MOVEMENT: {
+				// Recorded after coalescing already, so batch them up as is.
+				MouseMovementEvent ev = record.mouseMovement;
+				ev.frameDelta = delta;
+				ev.timestamp = timestamp;
+				mPendingMouseMotion.push_back(ev);
 				break;
-			case SDL_EventType::SDL_WINDOWEVENT:
-				dispatchWindowEvent(e, delta);
+			}
+			default:
 				break;
-			case SDL_EventType::SDL_QUIT:
-				return false;
 		}
 	}
+	flushMouseMotion();
+
+	// The recording always ends with an end record, which is never consumed.
+	const RecordedEvent &next = mPlayback[mPlaybackCursor];
+	if (next.type == RECORD_END && next.tick <= mTick) {
+		mPlayback.clear();
+		mPlaybackCursor = 0;
+		return false;
+	}
+	++mTick;
 	return true;
 }
 
-void EventManager::dispatchKeyEvent(const SDL_Event &e, const F64 &delta) const {
+void EventManager::writeRecord(RecordType type, const U8 *payload, size_t size) const {
+	if (mRecordFile == nullptr)
+		return;
+
+	U8 record[sizeof(U32) + sizeof(U8) + MOUSE_MOVEMENT_PAYLOAD_SIZE];
+	memcpy(record, &mTick, sizeof(U32));
+	record[sizeof(U32)] = type;
+	if (size > 0)
+		memcpy(record + sizeof(U32) + sizeof(U8), payload, size);
+	fwrite(record, sizeof(U32) + sizeof(U8) + size, 1, mRecordFile);
+}
+
+void EventManager::dispatch(const KeyboardEvent &ev) const {
+	U8 payload[KEYBOARD_PAYLOAD_SIZE];
+	const U16 scanCode = static_cast<U16>(ev.scanCode);
+	payload[0] = ev.isPressedDown ? 1 : 0;
+	memcpy(payload + 1, &scanCode, sizeof(U16));
+	writeRecord(RECORD_KEYBOARD, payload, sizeof(payload));
+
+	for (const auto i : mKeyboardEvents) {
+		i->processKeyboard(ev);
+	}
+}
+
+void EventManager::dispatch(const MouseButtonEvent &ev) const {
+	U8 payload = 0;
+	if (ev.isPressedDown)
+		payload |= MOUSE_BUTTON_PRESSED;
+	if (ev.leftClick)
+		payload |= MOUSE_BUTTON_LEFT;
+	if (ev.rightClick)
+		payload |= MOUSE_BUTTON_RIGHT;
+	if (ev.middleClick)
+		payload |= MOUSE_BUTTON_MIDDLE;
+	if (ev.doubleClick)
+		payload |= MOUSE_BUTTON_DOUBLE;
+	writeRecord(RECORD_MOUSE_BUTTON, &payload, sizeof(payload));
+
+	for (const auto i : mMouseButtonEvents) {
+		i->processMouseButton(ev);
+	}
+}
+
+void EventManager::dispatchMouseMovements(const MouseMovementEvent *events, U32 count) const {
+	if (mRecordFile != nullptr) {
+		for (U32 i = 0; i < count; ++i) {
+			U8 payload[MOUSE_MOVEMENT_PAYLOAD_SIZE];
+			memcpy(payload + 0, &events[i].mouseDelta.x, sizeof(F32));
+			memcpy(payload + 4, &events[i].mouseDelta.y, sizeof(F32));
+			memcpy(payload + 8, &events[i].mousePosition.x, sizeof(F32));
+			memcpy(payload + 12, &events[i].mousePosition.y, sizeof(F32));
+			writeRecord(RECORD_MOUSE_MOVEMENT, payload, sizeof(payload));
+		}
+	}
+
+	for (const auto i : mMouseMovmentEvents) {
+		i->processMouseMovements(events, count);
+	}
+}
+
+void EventManager::dispatchEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const {
+	switch (e.type) {
+		case SDL_EventType::SDL_KEYDOWN:
+		case SDL_EventType::SDL_KEYUP:
+			dispatchKeyEvent(e, delta, timestamp);
+			break;
+		case SDL_EventType::SDL_MOUSEBUTTONDOWN:
+		case SDL_EventType::SDL_MOUSEBUTTONUP:
+			dispatchMouseButtonEvent(e, delta, timestamp);
+			break;
+		case SDL_EventType::SDL_MOUSEMOTION:
+			dispatchMouseMotionEvent(e, delta, timestamp);
+			break;
+		case SDL_EventType::SDL_WINDOWEVENT:
+			dispatchWindowEvent(e, delta, timestamp);
+			break;
+	}
+}
+
+void EventManager::dispatchKeyEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const {
 	KeyboardEvent ev;
 	ev.frameDelta = delta;
+	ev.timestamp = timestamp;
 	ev.isPressedDown = (e.type == SDL_EventType::SDL_KEYDOWN);
 	ev.scanCode = e.key.keysym.scancode;
-	
-	for (const auto i : mKeyboardEvents) {
-		i->processKeyboard(ev);
-	}
+	dispatch(ev);
 }
 
-void EventManager::dispatchMouseButtonEvent(const SDL_Event &e, const F64 &delta) const {
+void EventManager::dispatchMouseButtonEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const {
 	MouseButtonEvent ev;
 	ev.frameDelta = delta;
+	ev.timestamp = timestamp;
+	ev.isPressedDown = (e.type == SDL_EventType::SDL_MOUSEBUTTONDOWN);
 	ev.leftClick = e.button.button == SDL_BUTTON_LEFT;
 	ev.rightClick = e.button.button == SDL_BUTTON_RIGHT;
 	ev.middleClick = e.button.button == SDL_BUTTON_MIDDLE;
 	ev.doubleClick = e.button.clicks >= 2;
-	
-	for (const auto i : mMouseButtonEvents) {
-		i->processMouseButton(ev);
-	}
+	dispatch(ev);
 }
 
-void EventManager::dispatchMouseMotionEvent(const SDL_Event &e, const F64 &delta) const {
+void EventManager::dispatchMouseMotionEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const {
 	MouseMovementEvent ev;
 	ev.frameDelta = delta;
+	ev.timestamp = timestamp;
 	ev.mousePosition = glm::vec2(e.motion.x, e.motion.y);
 	ev.mouseDelta = glm::vec2(e.motion.xrel, e.motion.yrel);
-	
-	for (const auto i : mMouseMovmentEvents) {
-		i->processMouseMovement(ev);
-	}
+	dispatchMouseMovements(&ev, 1);
 }
 
-void EventManager::dispatchWindowEvent(const SDL_Event &e, const F64 &delta) const {
+void EventManager::dispatchWindowEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const {
 	WindowEvent ev;
 	ev.frameDelta = delta;
+	ev.timestamp = timestamp;
 	ev.gainedFocus = e.window.event == SDL_WINDOWEVENT_FOCUS_GAINED;
 	ev.lostFocus = e.window.event == SDL_WINDOWEVENT_FOCUS_LOST;
 	
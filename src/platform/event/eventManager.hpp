@@ -31,9 +31,14 @@
 #ifndef _PLATFORM_EVENT_EVENTMANAGER_HPP_
 #define _PLATFORM_EVENT_EVENTMANAGER_HPP_
 
+#include <stdio.h>
+#include <string>
 #include <vector>
+#include <atomic>
 #include <SDL.h>
 #include "core/types.hpp"
+#include "core/spscQueue.hpp"
+#include "platform/event/eventTypes.hpp"
 
 class IKeyboardEvent;
 class IWindowEvent;
@@ -42,12 +47,83 @@ class IMouseButtonEvent;
 
 class EventManager {
 public:
-	bool pullEvents(const F64 &delta) const;
+	/**
+	 * Size of the queue that sampled input waits in until the next tick.
+	 */
+	static const U32 INPUT_QUEUE_CAPACITY = 4096;
+
+	/**
+	 * Timestep that recordings are played back with, so every playback of a
+	 * recording moves the camera along exactly the same path.
+	 */
+	static const F64 PLAYBACK_TIMESTEP;
+
+	EventManager();
+	~EventManager();
+
+	/**
+	 * Polls SDL and dispatches every event straight away.
+	 * Returns false once the application should quit.
+	 */
+	bool pullEvents(const F64 &delta);
+
+	/**
+	 * Threaded input: the thread that created the window samples SDL into a
+	 * lock free queue with sampleInput() while the game thread drains it once
+	 * per tick with processInput(), so input is timestamped and picked up even
+	 * while the game thread is stalled on rendering. Both return false once the
+	 * application should quit.
+	 */
+	bool sampleInput();
+	bool processInput(const F64 &delta);
+
+	U32 getDroppedInputCount() const {
+		return mDroppedInput.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * When enabled, consecutive mouse motion events are merged into a single
+	 * event with the summed delta and the latest position, so a high polling
+	 * rate mouse costs one listener call per tick instead of one per report.
+	 * Either way motion is handed to the listeners in batches. On by default.
+	 */
+	void setMouseMotionCoalescing(bool coalesce) {
+		mCoalesceMouseMotion = coalesce;
+	}
+
+	/**
+	 * Records every keyboard, mouse button and mouse motion event that is
+	 * dispatched from now on, along with the tick it was dispatched in.
+	 */
+	bool startRecording(const std::string &path);
+	void stopRecording();
+
+	/**
+	 * Loads a recording to be fed back by playbackEvents() instead of live
+	 * input.
+	 */
+	bool startPlayback(const std::string &path);
+
+	/**
+	 * Dispatches the recorded events of the next tick. Live input is polled
+	 * but ignored. Returns false once the recording has ended or the
+	 * application should quit.
+	 */
+	bool playbackEvents(const F64 &delta);
+
+	bool isPlayingBack() const {
+		return mPlaybackCursor < mPlayback.size();
+	}
+
+	U32 getTick() const {
+		return mTick;
+	}
 	
-	void dispatchKeyEvent(const SDL_Event &e, const F64 &delta) const;
-	void dispatchMouseButtonEvent(const SDL_Event &e, const F64 &delta) const;
-	void dispatchMouseMotionEvent(const SDL_Event &e, const F64 &delta) const;
-	void dispatchWindowEvent(const SDL_Event &e, const F64 &delta) const;
+	void dispatchEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const;
+	void dispatchKeyEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const;
+	void dispatchMouseButtonEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const;
+	void dispatchMouseMotionEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const;
+	void dispatchWindowEvent(const SDL_Event &e, const F64 &delta, U64 timestamp) const;
 
 	void addEvent(IKeyboardEvent *inputEvent);
 	void addEvent(IWindowEvent *windowEvent);
@@ -63,6 +139,52 @@ private:
 	std::vector<IMouseMovementEvent*> mMouseMovmentEvents;
 	std::vector<IMouseButtonEvent*> mMouseButtonEvents;
 	std::vector<IWindowEvent*> mWindowEvents;
+
+	struct InputSample {
+		SDL_Event event;
+		U64 timestamp;
+	};
+
+	SPSCQueue<InputSample> mInputQueue;
+	std::vector<MouseMovementEvent> mPendingMouseMotion;
+	bool mCoalesceMouseMotion;
+	std::atomic<bool> mQuitRequested;
+	std::atomic<U32> mDroppedInput;
+
+	/**
+	 * Routes an event of the current drain. Motion is held back and handed out
+	 * by flushMouseMotion() before the next other event, keeping the order
+	 * between motion and clicks intact.
+	 */
+	void queueEvent(const SDL_Event &e, const F64 &delta, U64 timestamp);
+	void flushMouseMotion();
+
+	void dispatch(const KeyboardEvent &ev) const;
+	void dispatch(const MouseButtonEvent &ev) const;
+	void dispatchMouseMovements(const MouseMovementEvent *events, U32 count) const;
+
+	enum RecordType : U8 {
+		RECORD_KEYBOARD,
+		RECORD_MOUSE_BUTTON,
+		RECORD_MOUSE_MOVEMENT,
+		RECORD_END
+	};
+
+	struct RecordedEvent {
+		U32 tick;
+		RecordType type;
+		KeyboardEvent keyboard;
+		MouseButtonEvent mouseButton;
+		MouseMovementEvent mouseMovement;
+	};
+
+	// Ticks are counted from the start of the recording or playback.
+	U32 mTick;
+	FILE *mRecordFile;
+	std::vector<RecordedEvent> mPlayback;
+	size_t mPlaybackCursor;
+
+	void writeRecord(RecordType type, const U8 *payload, size_t size) const;
 };
 
 extern EventManager gEventManager;
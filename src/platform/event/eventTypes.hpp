@@ -37,6 +37,11 @@
 
 struct Event {
 	F64 frameDelta;
+
+	/**
+	 * SDL_GetPerformanceCounter() at the time the event was sampled.
+	 */
+	U64 timestamp;
 };
 
 struct WindowEvent : public Event {
@@ -50,6 +55,7 @@ struct MouseMovementEvent : public Event {
 };
 
 struct MouseButtonEvent : public Event {
+	bool isPressedDown;
 	bool leftClick;
 	bool rightClick;
 	bool middleClick;
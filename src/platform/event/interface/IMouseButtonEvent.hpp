@@ -38,7 +38,7 @@ public:
 	IMouseButtonEvent();
 	virtual ~IMouseButtonEvent();
 
-	virtual void processMouseButton(const MouseButtonEvent &mouseButtonEvent) const = 0;
+	virtual void processMouseButton(const MouseButtonEvent &mouseButtonEvent) = 0;
 };
 
 #endif // _PLATFORM_EVENT_INTERFACE_IMOUSEBUTTONEVENT_HPP_
\ No newline at end of file
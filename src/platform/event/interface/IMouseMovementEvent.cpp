@@ -37,4 +37,9 @@ IMouseMovementEvent::IMouseMovementEvent() {
 
 IMouseMovementEvent::~IMouseMovementEvent() {
 	gEventManager.removeEvent(this);
+}
+
+void IMouseMovementEvent::processMouseMovements(const MouseMovementEvent *mouseMovementEvents, U32 count) {
+	for (U32 i = 0; i < count; ++i)
+		processMouseMovement(mouseMovementEvents[i]);
 }
\ No newline at end of file
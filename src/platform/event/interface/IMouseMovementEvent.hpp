@@ -39,6 +39,12 @@ public:
 	virtual ~IMouseMovementEvent();
 
 	virtual void processMouseMovement(const MouseMovementEvent &mouseMovementEvent) = 0;
+
+	/**
+	 * Receives every motion event of a tick in one call. Override this when
+	 * the per event work can be done once for the whole batch.
+	 */
+	virtual void processMouseMovements(const MouseMovementEvent *mouseMovementEvents, U32 count);
 };
 
 #endif // _PLATFORM_EVENT_INTERFACE_IMOUSEMOVEMENTEVENT_HPP_
\ No newline at end of file
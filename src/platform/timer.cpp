@@ -51,7 +51,7 @@ void Timer::stop() {
 	mFlag = true;
 	
 	// Calculate delta
-	mDelta = static_cast<F64>(((SDL_GetPerformanceCounter() - mStart) * 1000) / mFrequency) / 1000.0;
+	mDelta = static_cast<F64>(SDL_GetPerformanceCounter() - mStart) / static_cast<F64>(mFrequency);
 }
 
 F64 Timer::getDelta() const {
@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_BLOCK_HPP_
+#define _WORLD_BLOCK_HPP_
+
+#include "core/types.hpp"
+
+typedef U16 BlockID;
+
+enum BlockType : BlockID {
+	AIR = 0,
+	STONE,
+	DIRT,
+	GRASS,
+	WATER,
+	GLASS,
+	LAVA,
+	SAND,
+
+	BLOCK_TYPE_COUNT
+};
+
+/**
+ * The six faces of a block or chunk, in the order of their outward normals.
+ */
+enum BlockFace : U8 {
+	FACE_NEGATIVE_X = 0,
+	FACE_POSITIVE_X,
+	FACE_NEGATIVE_Y,
+	FACE_POSITIVE_Y,
+	FACE_NEGATIVE_Z,
+	FACE_POSITIVE_Z,
+
+	FACE_COUNT
+};
+
+/**
+ * Fluids flow into the air around them, see FluidSimulation.
+ */
+inline bool isFluidBlock(BlockID block) {
+	return block == BlockType::WATER || block == BlockType::LAVA;
+}
+
+/**
+ * Solid blocks fill their cell for collisions and picking.
+ */
+inline bool isSolidBlock(BlockID block) {
+	return block != BlockType::AIR && !isFluidBlock(block);
+}
+
+/**
+ * Translucent blocks are drawn blended over what is behind them, after the
+ * opaque ones.
+ */
+inline bool isTranslucentBlock(BlockID block) {
+	return block == BlockType::WATER || block == BlockType::GLASS;
+}
+
+/**
+ * Opaque blocks hide everything behind them.
+ */
+inline bool isOpaqueBlock(BlockID block) {
+	return block != BlockType::AIR && !isTranslucentBlock(block);
+}
+
+#endif // _WORLD_BLOCK_HPP_
@@ -0,0 +1,95 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "world/blockBehaviours.hpp"
+#include "world/blockTickScheduler.hpp"
+#include "world/world.hpp"
+
+// Steps between sand losing its support and falling a block.
+#define SAND_FALL_DELAY 2
+
+// Grass spreads to dirt up to a block to the sides, three below and one above.
+#define GRASS_SPREAD_RANGE 3
+#define GRASS_SPREAD_HEIGHT 5
+
+static bool isCovered(const World &world, const glm::ivec3 &pos) {
+	const BlockID above = world.getBlock(pos + glm::ivec3(0, 1, 0));
+	return isOpaqueBlock(above) || isFluidBlock(above);
+}
+
+static void tickGrass(World &world, const BlockTick *ticks, U32 count) {
+	for (U32 i = 0; i < count; ++i) {
+		const glm::ivec3 &pos = ticks[i].position;
+		if (world.getBlock(pos) != BlockType::GRASS)
+			continue;
+		if (isCovered(world, pos)) {
+			world.setBlock(pos, BlockType::DIRT);
+			continue;
+		}
+
+		const U32 random = ticks[i].random;
+		const glm::ivec3 target = pos + glm::ivec3(
+			static_cast<S32>(random % GRASS_SPREAD_RANGE) - 1,
+			static_cast<S32>(random / GRASS_SPREAD_RANGE % GRASS_SPREAD_HEIGHT) - 3,
+			static_cast<S32>(random / (GRASS_SPREAD_RANGE * GRASS_SPREAD_HEIGHT) % GRASS_SPREAD_RANGE) - 1
+		);
+		if (world.getBlock(target) == BlockType::DIRT && !isCovered(world, target))
+			world.setBlock(target, BlockType::GRASS);
+	}
+}
+
+static void tickSand(World &world, const BlockTick *ticks, U32 count) {
+	for (U32 i = 0; i < count; ++i) {
+		const glm::ivec3 &pos = ticks[i].position;
+		const glm::ivec3 below = pos - glm::ivec3(0, 1, 0);
+		if (world.getBlock(pos) != BlockType::SAND || isSolidBlock(world.getBlock(below)))
+			continue;
+
+		// Chunks that aren't loaded read as air.
+		if (world.getChunk(World::getChunkCoord(below)) == nullptr)
+			continue;
+
+		// Setting the block below schedules its next fall, fluid in the way is
+		// pushed out.
+		world.setBlock(pos, BlockType::AIR);
+		world.setBlock(below, BlockType::SAND);
+	}
+}
+
+void BlockBehaviours::registerDefaults(BlockTickScheduler &ticks) {
+	BlockBehaviour grass = {};
+	grass.randomTick = tickGrass;
+	ticks.setBehaviour(BlockType::GRASS, grass);
+
+	BlockBehaviour sand = {};
+	sand.scheduledTick = tickSand;
+	sand.updateDelay = SAND_FALL_DELAY;
+	ticks.setBehaviour(BlockType::SAND, sand);
+}
@@ -0,0 +1,150 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <assert.h>
+#include "world/blockMaterials.hpp"
+
+enum BlockLayer : U16 {
+	LAYER_MISSING = 0,
+	LAYER_STONE,
+	LAYER_DIRT,
+	LAYER_GRASS_TOP,
+	LAYER_GRASS_SIDE,
+	LAYER_WATER,
+	LAYER_GLASS,
+	LAYER_LAVA,
+	LAYER_SAND,
+
+	LAYER_COUNT
+};
+
+struct LayerDesc {
+	const char *name;
+	U8 color[4];
+
+	// Largest brightness change of a texel, out of 255.
+	U8 variation;
+};
+
+static const LayerDesc sLayers[LAYER_COUNT] = {
+	{ "missing", { 255, 0, 255, 255 }, 0 },
+	{ "stone", { 128, 128, 128, 255 }, 40 },
+	{ "dirt", { 115, 77, 38, 255 }, 30 },
+	{ "grass_top", { 51, 153, 26, 255 }, 36 },
+	{ "grass_side", { 115, 77, 38, 255 }, 30 },
+	{ "water", { 38, 89, 191, 160 }, 16 },
+	{ "glass", { 200, 225, 235, 48 }, 8 },
+	{ "lava", { 207, 92, 15, 255 }, 48 },
+	{ "sand", { 219, 203, 145, 255 }, 24 }
+};
+
+// Indexed by BlockType and BlockFace.
+static const U16 sBlockLayers[BLOCK_TYPE_COUNT][FACE_COUNT] = {
+	{ LAYER_MISSING, LAYER_MISSING, LAYER_MISSING, LAYER_MISSING, LAYER_MISSING, LAYER_MISSING },
+	{ LAYER_STONE, LAYER_STONE, LAYER_STONE, LAYER_STONE, LAYER_STONE, LAYER_STONE },
+	{ LAYER_DIRT, LAYER_DIRT, LAYER_DIRT, LAYER_DIRT, LAYER_DIRT, LAYER_DIRT },
+	{ LAYER_GRASS_SIDE, LAYER_GRASS_SIDE, LAYER_DIRT, LAYER_GRASS_TOP, LAYER_GRASS_SIDE, LAYER_GRASS_SIDE },
+	{ LAYER_WATER, LAYER_WATER, LAYER_WATER, LAYER_WATER, LAYER_WATER, LAYER_WATER },
+	{ LAYER_GLASS, LAYER_GLASS, LAYER_GLASS, LAYER_GLASS, LAYER_GLASS, LAYER_GLASS },
+	{ LAYER_LAVA, LAYER_LAVA, LAYER_LAVA, LAYER_LAVA, LAYER_LAVA, LAYER_LAVA },
+	{ LAYER_SAND, LAYER_SAND, LAYER_SAND, LAYER_SAND, LAYER_SAND, LAYER_SAND }
+};
+
+static U32 hashTexel(U32 layer, U32 x, U32 y) {
+	U32 h = layer * 374761393U + x * 668265263U + y * 2246822519U;
+	h = (h ^ (h >> 13)) * 1274126177U;
+	return h ^ (h >> 16);
+}
+
+static U8 clampColor(S32 value) {
+	return static_cast<U8>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+U16 BlockMaterials::getLayer(BlockID block, U32 face) {
+	if (block >= BLOCK_TYPE_COUNT)
+		return LAYER_MISSING;
+	return sBlockLayers[block][face];
+}
+
+U32 BlockMaterials::getLayerCount() {
+	return LAYER_COUNT;
+}
+
+const char* BlockMaterials::getLayerName(U32 layer) {
+	assert(layer < LAYER_COUNT);
+	return sLayers[layer].name;
+}
+
+void BlockMaterials::generatePlaceholder(U32 layer, U8 *texels) {
+	assert(layer < LAYER_COUNT);
+	for (U32 i = 0; i < BLOCK_TEXTURE_SIZE * BLOCK_TEXTURE_SIZE; ++i) {
+		texels[i * 4 + 0] = sLayers[layer].color[0];
+		texels[i * 4 + 1] = sLayers[layer].color[1];
+		texels[i * 4 + 2] = sLayers[layer].color[2];
+		texels[i * 4 + 3] = sLayers[layer].color[3];
+	}
+}
+
+void BlockMaterials::generateLayer(U32 layer, U8 *texels) {
+	assert(layer < LAYER_COUNT);
+	const LayerDesc &desc = sLayers[layer];
+	const LayerDesc &grass = sLayers[LAYER_GRASS_TOP];
+
+	for (U32 y = 0; y < BLOCK_TEXTURE_SIZE; ++y) {
+		for (U32 x = 0; x < BLOCK_TEXTURE_SIZE; ++x) {
+			U8 *texel = texels + (y * BLOCK_TEXTURE_SIZE + x) * 4;
+			const U32 hash = hashTexel(layer, x, y);
+
+			const U8 *color = desc.color;
+			S32 variation = desc.variation;
+			if (layer == LAYER_MISSING) {
+				// Magenta and black checkerboard, so it stands out.
+				static const U8 black[4] = { 0, 0, 0, 255 };
+				if (((x / 4) + (y / 4)) & 1)
+					color = black;
+			} else if (layer == LAYER_GRASS_SIDE && y < 3 + (hash >> 24) % 3) {
+				// Ragged fringe of grass hanging over the dirt.
+				color = grass.color;
+				variation = grass.variation;
+			}
+
+			const S32 shift = variation > 0 ? static_cast<S32>(hash & 0xFF) * variation / 255 - variation / 2 : 0;
+			texel[0] = clampColor(color[0] + shift);
+			texel[1] = clampColor(color[1] + shift);
+			texel[2] = clampColor(color[2] + shift);
+			texel[3] = color[3];
+			if (layer == LAYER_GLASS && (x == 0 || y == 0 || x == BLOCK_TEXTURE_SIZE - 1 || y == BLOCK_TEXTURE_SIZE - 1)) {
+				// Frame around the pane.
+				texel[0] = texel[1] = texel[2] = 230;
+				texel[3] = 255;
+			}
+		}
+	}
+}
@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_BLOCKMATERIALS_HPP_
+#define _WORLD_BLOCKMATERIALS_HPP_
+
+#include "core/types.hpp"
+#include "world/block.hpp"
+
+/**
+ * Edge length in texels of every block texture.
+ */
+#define BLOCK_TEXTURE_SIZE 16
+
+/**
+ * Registry of the textures block faces are drawn with. Every texture is a
+ * layer of a single texture array so that all of the chunks can be drawn
+ * without rebinding, the mesher stores the layer of a face in its vertices.
+ */
+namespace BlockMaterials {
+	/**
+	 * Layer the given face of a block is drawn with. Unknown blocks get the
+	 * missing texture at layer 0.
+	 */
+	U16 getLayer(BlockID block, U32 face);
+
+	U32 getLayerCount();
+	const char* getLayerName(U32 layer);
+
+	/**
+	 * Fills the RGBA8 texels of a layer with its flat base colour, to stand in
+	 * while the texture is loading.
+	 */
+	void generatePlaceholder(U32 layer, U8 *texels);
+
+	/**
+	 * Fills the RGBA8 texels of a layer, BLOCK_TEXTURE_SIZE^2 of them with
+	 * the top row first. Used when there is no texture file for the layer.
+	 */
+	void generateLayer(U32 layer, U8 *texels);
+}
+
+#endif // _WORLD_BLOCKMATERIALS_HPP_
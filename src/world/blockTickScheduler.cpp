@@ -0,0 +1,337 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "world/blockTickScheduler.hpp"
+#include "world/world.hpp"
+
+#define BLOCK_TICK_TIME (1.0 / BLOCK_TICK_RATE)
+
+// A block and its six neighbours.
+static const S32 sUpdateOffsets[7][3] = {
+	{ 0, 0, 0 },
+	{ -1, 0, 0 }, { 1, 0, 0 },
+	{ 0, -1, 0 }, { 0, 1, 0 },
+	{ 0, 0, -1 }, { 0, 0, 1 }
+};
+
+static U32 getSection(U32 index) {
+	const U32 x = index & (CHUNK_SIZE - 1);
+	const U32 y = index >> (CHUNK_SHIFT * 2);
+	const U32 z = (index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1);
+	const U32 sections = CHUNK_SIZE / BLOCK_TICK_SECTION_SIZE;
+	return ((y >> BLOCK_TICK_SECTION_SHIFT) * sections + (z >> BLOCK_TICK_SECTION_SHIFT)) * sections + (x >> BLOCK_TICK_SECTION_SHIFT);
+}
+
+static glm::ivec3 getWorldPosition(const ChunkCoord &coord, U32 index) {
+	return glm::ivec3(coord.x, coord.y, coord.z) * CHUNK_SIZE + glm::ivec3(index & (CHUNK_SIZE - 1), index >> (CHUNK_SHIFT * 2), (index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1));
+}
+
+BlockTickScheduler::BlockTickScheduler(World *world) {
+	mWorld = world;
+	memset(mBehaviours, 0, sizeof(mBehaviours));
+	mTick = 0;
+	mRandom = 0x9E3779B97F4A7C15ULL;
+	mTime = 0.0;
+	memset(&mFrameStats, 0, sizeof(mFrameStats));
+	memset(&mTotalStats, 0, sizeof(mTotalStats));
+	mFrameCount = 0;
+}
+
+BlockTickScheduler::~BlockTickScheduler() {
+	for (auto &pair : mChunks) {
+		delete pair.second->wheel;
+		delete pair.second;
+	}
+}
+
+void BlockTickScheduler::setBehaviour(BlockID block, const BlockBehaviour &behaviour) {
+	assert(block < BLOCK_TYPE_COUNT);
+	const bool recount = hasRandomTick(block) != (behaviour.randomTick != nullptr);
+	mBehaviours[block] = behaviour;
+	if (recount) {
+		for (auto &pair : mChunks)
+			countRandomBlocks(*pair.second);
+	}
+}
+
+void BlockTickScheduler::schedule(const glm::ivec3 &position, BlockID block, U32 delay) {
+	auto pos = mChunks.find(World::getChunkCoord(position));
+	if (pos == mChunks.end())
+		return;
+
+	ChunkTicks &ticks = *pos->second;
+	if (ticks.wheel == nullptr) {
+		ticks.wheel = new TickWheel;
+		memset(ticks.wheel->scheduled, 0, sizeof(ticks.wheel->scheduled));
+		ticks.wheel->count = 0;
+		mScheduledChunks.push_back(&ticks);
+	}
+
+	const glm::ivec3 local = World::getLocalPosition(position);
+	const U32 index = Chunk::getIndex(local.x, local.y, local.z);
+	TickWheel &wheel = *ticks.wheel;
+	if (wheel.scheduled[index >> 6] & (1ULL << (index & 63)))
+		return;
+	wheel.scheduled[index >> 6] |= 1ULL << (index & 63);
+	++wheel.count;
+
+	ScheduledTick tick;
+	tick.due = mTick + std::max(delay, 1U);
+	tick.index = static_cast<U16>(index);
+	tick.block = block;
+	if (tick.due - mTick < BLOCK_TICK_WHEEL_SIZE)
+		wheel.slots[tick.due % BLOCK_TICK_WHEEL_SIZE].push_back(tick);
+	else
+		wheel.later.push_back(tick);
+}
+
+void BlockTickScheduler::addChunk(const Chunk *chunk) {
+	ChunkTicks *&ticks = mChunks[chunk->getCoord()];
+	if (ticks == nullptr) {
+		ticks = new ChunkTicks;
+		ticks->wheel = nullptr;
+	}
+	ticks->chunk = chunk;
+	countRandomBlocks(*ticks);
+}
+
+void BlockTickScheduler::removeChunk(const ChunkCoord &coord) {
+	auto pos = mChunks.find(coord);
+	if (pos == mChunks.end())
+		return;
+
+	ChunkTicks *ticks = pos->second;
+	if (ticks->wheel != nullptr) {
+		mScheduledChunks.erase(std::find(mScheduledChunks.begin(), mScheduledChunks.end(), ticks));
+		delete ticks->wheel;
+	}
+	delete ticks;
+	mChunks.erase(pos);
+}
+
+void BlockTickScheduler::onBlockChanged(const Chunk *chunk, U32 index, BlockID oldBlock) {
+	auto pos = mChunks.find(chunk->getCoord());
+	if (pos == mChunks.end())
+		return;
+
+	ChunkTicks &ticks = *pos->second;
+	const BlockID block = chunk->getBlockAtIndex(index);
+	const U32 section = getSection(index);
+	if (hasRandomTick(oldBlock)) {
+		--ticks.randomBlocks[section];
+		--ticks.randomTotal;
+	}
+	if (hasRandomTick(block)) {
+		++ticks.randomBlocks[section];
+		++ticks.randomTotal;
+	}
+
+	const glm::ivec3 position = getWorldPosition(chunk->getCoord(), index);
+	for (const S32 *offset : sUpdateOffsets) {
+		const glm::ivec3 neighbor = position + glm::ivec3(offset[0], offset[1], offset[2]);
+		const BlockID neighborBlock = mWorld->getBlock(neighbor);
+		if (neighborBlock < BLOCK_TYPE_COUNT && mBehaviours[neighborBlock].updateDelay > 0)
+			schedule(neighbor, neighborBlock, mBehaviours[neighborBlock].updateDelay);
+	}
+}
+
+U32 BlockTickScheduler::update(F64 delta) {
+	if (mFrameStats.steps > 0)
+		++mFrameCount;
+	memset(&mFrameStats, 0, sizeof(mFrameStats));
+
+	mTime += delta;
+	U32 steps = 0;
+	while (mTime >= BLOCK_TICK_TIME && steps < BLOCK_TICK_MAX_STEPS_PER_UPDATE) {
+		step();
+		mTime -= BLOCK_TICK_TIME;
+		++steps;
+	}
+
+	// Fall behind instead of catching up over the next frames.
+	if (mTime >= BLOCK_TICK_TIME)
+		mTime = 0.0;
+	return steps;
+}
+
+void BlockTickScheduler::step() {
+	const auto start = std::chrono::steady_clock::now();
+	++mTick;
+	gatherScheduledTicks();
+	gatherRandomTicks();
+	dispatch();
+
+	const F64 seconds = std::chrono::duration<F64>(std::chrono::steady_clock::now() - start).count();
+	++mFrameStats.steps;
+	++mTotalStats.steps;
+	mFrameStats.seconds += seconds;
+	mTotalStats.seconds += seconds;
+}
+
+U32 BlockTickScheduler::getScheduledCount() const {
+	U32 count = 0;
+	for (const ChunkTicks *ticks : mScheduledChunks)
+		count += ticks->wheel->count;
+	return count;
+}
+
+void BlockTickScheduler::printStats() const {
+	const F64 frames = mFrameCount > 0 ? static_cast<F64>(mFrameCount) : 1.0;
+	const F64 ticks = static_cast<F64>(mTotalStats.scheduledTicks + mTotalStats.randomTicks);
+	printf("Block ticks: %llu steps over %llu frames, %llu scheduled and %llu random ticks in %llu batches\n", static_cast<unsigned long long>(mTotalStats.steps), static_cast<unsigned long long>(mFrameCount), static_cast<unsigned long long>(mTotalStats.scheduledTicks), static_cast<unsigned long long>(mTotalStats.randomTicks), static_cast<unsigned long long>(mTotalStats.batches));
+	printf("   %.1f ticks and %.3f ms per frame, %.0f ticks per second of work\n", ticks / frames, mTotalStats.seconds * 1000.0 / frames, mTotalStats.seconds > 0.0 ? ticks / mTotalStats.seconds : 0.0);
+}
+
+U32 BlockTickScheduler::nextRandom() {
+	// xorshift64*
+	mRandom ^= mRandom >> 12;
+	mRandom ^= mRandom << 25;
+	mRandom ^= mRandom >> 27;
+	return static_cast<U32>((mRandom * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void BlockTickScheduler::countRandomBlocks(ChunkTicks &ticks) const {
+	memset(ticks.randomBlocks, 0, sizeof(ticks.randomBlocks));
+	ticks.randomTotal = 0;
+	const BlockID *blocks = ticks.chunk->getBlocks();
+	for (U32 i = 0; i < CHUNK_VOLUME; ++i) {
+		if (hasRandomTick(blocks[i])) {
+			++ticks.randomBlocks[getSection(i)];
+			++ticks.randomTotal;
+		}
+	}
+}
+
+void BlockTickScheduler::gatherScheduledTicks() {
+	const U32 slot = mTick % BLOCK_TICK_WHEEL_SIZE;
+	for (size_t i = 0; i < mScheduledChunks.size();) {
+		ChunkTicks &ticks = *mScheduledChunks[i];
+		TickWheel &wheel = *ticks.wheel;
+
+		// Once per turn the ticks that come due before the next turn move
+		// into the wheel.
+		if (slot == 0 && !wheel.later.empty()) {
+			size_t kept = 0;
+			for (const ScheduledTick &tick : wheel.later) {
+				if (tick.due - mTick < BLOCK_TICK_WHEEL_SIZE)
+					wheel.slots[tick.due % BLOCK_TICK_WHEEL_SIZE].push_back(tick);
+				else
+					wheel.later[kept++] = tick;
+			}
+			wheel.later.resize(kept);
+		}
+
+		for (const ScheduledTick &tick : wheel.slots[slot]) {
+			wheel.scheduled[tick.index >> 6] &= ~(1ULL << (tick.index & 63));
+			--wheel.count;
+			if (ticks.chunk->getBlockAtIndex(tick.index) != tick.block || mBehaviours[tick.block].scheduledTick == nullptr)
+				continue;
+
+			BlockTick blockTick;
+			blockTick.position = getWorldPosition(ticks.chunk->getCoord(), tick.index);
+			blockTick.random = nextRandom();
+			mScheduledBatches[tick.block].push_back(blockTick);
+		}
+		wheel.slots[slot].clear();
+
+		if (wheel.count == 0) {
+			delete ticks.wheel;
+			ticks.wheel = nullptr;
+			mScheduledChunks[i] = mScheduledChunks.back();
+			mScheduledChunks.pop_back();
+		} else {
+			++i;
+		}
+	}
+}
+
+void BlockTickScheduler::gatherRandomTicks() {
+	const U32 sections = CHUNK_SIZE / BLOCK_TICK_SECTION_SIZE;
+	for (const auto &pair : mChunks) {
+		const ChunkTicks &ticks = *pair.second;
+		if (ticks.randomTotal == 0)
+			continue;
+
+		for (U32 section = 0; section < BLOCK_TICK_SECTIONS; ++section) {
+			if (ticks.randomBlocks[section] == 0)
+				continue;
+
+			const U32 baseX = (section % sections) * BLOCK_TICK_SECTION_SIZE;
+			const U32 baseZ = (section / sections % sections) * BLOCK_TICK_SECTION_SIZE;
+			const U32 baseY = (section / (sections * sections)) * BLOCK_TICK_SECTION_SIZE;
+			for (U32 i = 0; i < BLOCK_RANDOM_TICKS_PER_SECTION; ++i) {
+				const U32 cell = nextRandom();
+				const U32 x = baseX + (cell & (BLOCK_TICK_SECTION_SIZE - 1));
+				const U32 y = baseY + ((cell >> BLOCK_TICK_SECTION_SHIFT) & (BLOCK_TICK_SECTION_SIZE - 1));
+				const U32 z = baseZ + ((cell >> (BLOCK_TICK_SECTION_SHIFT * 2)) & (BLOCK_TICK_SECTION_SIZE - 1));
+				const U32 index = Chunk::getIndex(x, y, z);
+				const BlockID block = ticks.chunk->getBlockAtIndex(index);
+				if (!hasRandomTick(block))
+					continue;
+
+				BlockTick blockTick;
+				blockTick.position = getWorldPosition(pair.first, index);
+				blockTick.random = nextRandom();
+				mRandomBatches[block].push_back(blockTick);
+			}
+		}
+	}
+}
+
+void BlockTickScheduler::dispatch() {
+	// Behaviours may schedule ticks and change blocks, but only ever for a
+	// later step, so the batches stay put while they run.
+	for (U32 block = 0; block < BLOCK_TYPE_COUNT; ++block) {
+		std::vector<BlockTick> &scheduled = mScheduledBatches[block];
+		if (!scheduled.empty()) {
+			mBehaviours[block].scheduledTick(*mWorld, scheduled.data(), static_cast<U32>(scheduled.size()));
+			mFrameStats.scheduledTicks += scheduled.size();
+			mTotalStats.scheduledTicks += scheduled.size();
+			++mFrameStats.batches;
+			++mTotalStats.batches;
+			scheduled.clear();
+		}
+
+		std::vector<BlockTick> &random = mRandomBatches[block];
+		if (!random.empty()) {
+			mBehaviours[block].randomTick(*mWorld, random.data(), static_cast<U32>(random.size()));
+			mFrameStats.randomTicks += random.size();
+			mTotalStats.randomTicks += random.size();
+			++mFrameStats.batches;
+			++mTotalStats.batches;
+			random.clear();
+		}
+	}
+}
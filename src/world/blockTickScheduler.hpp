@@ -0,0 +1,219 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_BLOCKTICKSCHEDULER_HPP_
+#define _WORLD_BLOCKTICKSCHEDULER_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+class World;
+
+// Steps per second, and most steps caught up on in one update.
+#define BLOCK_TICK_RATE 20
+#define BLOCK_TICK_MAX_STEPS_PER_UPDATE 4
+
+/**
+ * Scheduled ticks up to this many steps ahead go straight into a slot of the
+ * wheel, later ones wait in a list that is sorted into the wheel once per
+ * turn.
+ */
+#define BLOCK_TICK_WHEEL_SIZE 64
+
+/**
+ * Random ticks pick this many cells of every section per step. Sections are
+ * cubes of BLOCK_TICK_SECTION_SIZE, eight to a chunk.
+ */
+#define BLOCK_RANDOM_TICKS_PER_SECTION 1
+#define BLOCK_TICK_SECTION_SHIFT 3
+#define BLOCK_TICK_SECTION_SIZE (1 << BLOCK_TICK_SECTION_SHIFT)
+#define BLOCK_TICK_SECTIONS (CHUNK_VOLUME / (BLOCK_TICK_SECTION_SIZE * BLOCK_TICK_SECTION_SIZE * BLOCK_TICK_SECTION_SIZE))
+
+struct BlockTick {
+	glm::ivec3 position;
+
+	// Random bits for the behaviour to use.
+	U32 random;
+};
+
+/**
+ * Called with every tick of a block type in a step at once. The batches of
+ * other types run first and may have changed some of the blocks.
+ */
+typedef void (*BlockTickFunction)(World &world, const BlockTick *ticks, U32 count);
+
+struct BlockBehaviour {
+	/**
+	 * Called for blocks picked by the random ticks, for slow changes that
+	 * happen all over the world such as plants growing.
+	 */
+	BlockTickFunction randomTick;
+
+	/**
+	 * Called for the ticks scheduled for the block.
+	 */
+	BlockTickFunction scheduledTick;
+
+	/**
+	 * Steps after the block or one of its six neighbours changed that a tick
+	 * is scheduled, 0 for none.
+	 */
+	U32 updateDelay;
+};
+
+/**
+ * Runs the block behaviours without visiting every voxel. Scheduled ticks go
+ * into a timing wheel per chunk, so a step only touches the slot that is due
+ * in the chunks that have any. Random ticks sample a few cells per section,
+ * skipping the sections that hold no block with a random tick.
+ *
+ * The ticks of a step are gathered first and then dispatched in batches by
+ * block type. A scheduled tick is dropped if its block was changed to
+ * another type by then, and a cell holds at most one scheduled tick.
+ */
+class BlockTickScheduler {
+public:
+	struct Stats {
+		U64 steps;
+		U64 scheduledTicks;
+		U64 randomTicks;
+		U64 batches;
+		F64 seconds;
+	};
+
+	BlockTickScheduler(World *world);
+	~BlockTickScheduler();
+
+	/**
+	 * Sets the behaviour of a block type. Chunks that are already loaded are
+	 * counted again.
+	 */
+	void setBehaviour(BlockID block, const BlockBehaviour &behaviour);
+
+	/**
+	 * Schedules a tick for the block at position in delay steps, at least one. The
+	 * tick is ignored if the cell has one scheduled already.
+	 */
+	void schedule(const glm::ivec3 &position, BlockID block, U32 delay);
+
+	/**
+	 * Counts the blocks with random ticks in a chunk that was loaded.
+	 */
+	void addChunk(const Chunk *chunk);
+
+	/**
+	 * Drops the ticks of a chunk that is being unloaded.
+	 */
+	void removeChunk(const ChunkCoord &coord);
+
+	/**
+	 * Keeps the counts up to date and schedules the update ticks around a
+	 * block that changed.
+	 */
+	void onBlockChanged(const Chunk *chunk, U32 index, BlockID oldBlock);
+
+	/**
+	 * Runs the steps that are due after delta more seconds and starts the
+	 * stats of a new frame. Returns the amount of steps that ran.
+	 */
+	U32 update(F64 delta);
+
+	void step();
+
+	U32 getScheduledCount() const;
+
+	const Stats& getFrameStats() const {
+		return mFrameStats;
+	}
+
+	const Stats& getTotalStats() const {
+		return mTotalStats;
+	}
+
+	U64 getFrameCount() const {
+		return mFrameCount;
+	}
+
+	void printStats() const;
+
+private:
+	struct ScheduledTick {
+		U64 due;
+		U16 index;
+		BlockID block;
+	};
+
+	struct TickWheel {
+		std::vector<ScheduledTick> slots[BLOCK_TICK_WHEEL_SIZE];
+		std::vector<ScheduledTick> later;
+
+		// Cells with a tick scheduled.
+		U64 scheduled[CHUNK_VOLUME / 64];
+		U32 count;
+	};
+
+	struct ChunkTicks {
+		const Chunk *chunk;
+		U16 randomBlocks[BLOCK_TICK_SECTIONS];
+		U32 randomTotal;
+
+		// Allocated while the chunk has ticks scheduled.
+		TickWheel *wheel;
+	};
+
+	World *mWorld;
+	BlockBehaviour mBehaviours[BLOCK_TYPE_COUNT];
+	std::unordered_map<ChunkCoord, ChunkTicks*, ChunkCoordHash> mChunks;
+	std::vector<ChunkTicks*> mScheduledChunks;
+	std::vector<BlockTick> mScheduledBatches[BLOCK_TYPE_COUNT];
+	std::vector<BlockTick> mRandomBatches[BLOCK_TYPE_COUNT];
+	U64 mTick;
+	U64 mRandom;
+	F64 mTime;
+
+	Stats mFrameStats;
+	Stats mTotalStats;
+	U64 mFrameCount;
+
+	U32 nextRandom();
+	void countRandomBlocks(ChunkTicks &ticks) const;
+	void gatherScheduledTicks();
+	void gatherRandomTicks();
+	void dispatch();
+
+	bool hasRandomTick(BlockID block) const {
+		return block < BLOCK_TYPE_COUNT && mBehaviours[block].randomTick != nullptr;
+	}
+};
+
+#endif // _WORLD_BLOCKTICKSCHEDULER_HPP_
@@ -0,0 +1,162 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <string.h>
+#include "world/chunk.hpp"
+
+#define ALL_FACES ((1 << FACE_COUNT) - 1)
+
+// Index offset of the neighbouring block across each face.
+static const S32 sFaceSteps[FACE_COUNT] = {
+	-1, 1,
+	-CHUNK_SIZE * CHUNK_SIZE, CHUNK_SIZE * CHUNK_SIZE,
+	-CHUNK_SIZE, CHUNK_SIZE
+};
+
+Chunk::Chunk(const ChunkCoord &coord) {
+	mCoord = coord;
+	mMesh = nullptr;
+	mMeshDirty = false;
+	mHasOccluders = false;
+	memset(mOccluderLayers, NO_OCCLUDER_LAYER, sizeof(mOccluderLayers));
+	memset(mFaceConnections, ALL_FACES, sizeof(mFaceConnections));
+	memset(mBlocks, 0, sizeof(mBlocks));
+}
+
+void Chunk::updateOccluders() {
+	mHasOccluders = false;
+	for (U32 face = 0; face < FACE_COUNT; ++face) {
+		const U32 axis = face / 2;
+		for (U32 quadrant = 0; quadrant < OCCLUDER_QUADRANTS; ++quadrant) {
+			const S32 firstU = (quadrant & 1) ? OCCLUDER_QUADRANT_SIZE : 0;
+			const S32 firstV = (quadrant & 2) ? OCCLUDER_QUADRANT_SIZE : 0;
+			U8 &layer = mOccluderLayers[face * OCCLUDER_QUADRANTS + quadrant];
+			layer = NO_OCCLUDER_LAYER;
+
+			// Walk inwards from the face until a layer is opaque all across.
+			for (S32 depth = 0; depth < CHUNK_SIZE && layer == NO_OCCLUDER_LAYER; ++depth) {
+				S32 p[3];
+				p[axis] = (face & 1) ? CHUNK_SIZE - 1 - depth : depth;
+				bool opaque = true;
+				for (S32 v = firstV; v < firstV + OCCLUDER_QUADRANT_SIZE && opaque; ++v) {
+					for (S32 u = firstU; u < firstU + OCCLUDER_QUADRANT_SIZE; ++u) {
+						p[(axis + 1) % 3] = u;
+						p[(axis + 2) % 3] = v;
+						if (!isOpaqueBlock(getBlock(p[0], p[1], p[2]))) {
+							opaque = false;
+							break;
+						}
+					}
+				}
+				if (opaque) {
+					layer = static_cast<U8>(depth);
+					mHasOccluders = true;
+				}
+			}
+		}
+	}
+}
+
+void Chunk::updateFaceConnections() {
+	U64 visited[CHUNK_VOLUME / 64];
+	const U32 opaqueCount = markOpaqueBlocks(visited);
+	if (opaqueCount == 0) {
+		memset(mFaceConnections, ALL_FACES, sizeof(mFaceConnections));
+		return;
+	}
+	memset(mFaceConnections, 0, sizeof(mFaceConnections));
+	if (opaqueCount == CHUNK_VOLUME)
+		return;
+
+	U16 stack[CHUNK_VOLUME];
+	for (U32 start = 0; start < CHUNK_VOLUME; ++start) {
+		if (visited[start >> 6] & (1ULL << (start & 63)))
+			continue;
+
+		const U32 faces = fillFaces(start, visited, stack);
+		for (U32 face = 0; face < FACE_COUNT; ++face) {
+			if (faces & (1 << face))
+				mFaceConnections[face] |= static_cast<U8>(faces);
+		}
+	}
+}
+
+U32 Chunk::getFacesReachableFrom(S32 x, S32 y, S32 z) const {
+	U64 visited[CHUNK_VOLUME / 64];
+	markOpaqueBlocks(visited);
+
+	const U32 start = getIndex(x, y, z);
+	if (visited[start >> 6] & (1ULL << (start & 63)))
+		return 0;
+
+	U16 stack[CHUNK_VOLUME];
+	return fillFaces(start, visited, stack);
+}
+
+U32 Chunk::markOpaqueBlocks(U64 *visited) const {
+	memset(visited, 0, CHUNK_VOLUME / 8);
+	U32 opaqueCount = 0;
+	for (U32 i = 0; i < CHUNK_VOLUME; ++i) {
+		if (isOpaqueBlock(mBlocks[i])) {
+			visited[i >> 6] |= 1ULL << (i & 63);
+			++opaqueCount;
+		}
+	}
+	return opaqueCount;
+}
+
+U32 Chunk::fillFaces(U32 start, U64 *visited, U16 *stack) const {
+	U32 faces = 0;
+	U32 top = 0;
+	stack[top++] = static_cast<U16>(start);
+	visited[start >> 6] |= 1ULL << (start & 63);
+	while (top > 0) {
+		const U32 index = stack[--top];
+		const U32 position[3] = {
+			index & (CHUNK_SIZE - 1),
+			index >> (CHUNK_SHIFT * 2),
+			(index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1)
+		};
+		for (U32 face = 0; face < FACE_COUNT; ++face) {
+			const U32 edge = (face & 1) ? CHUNK_SIZE - 1 : 0;
+			if (position[face / 2] == edge) {
+				faces |= 1 << face;
+				continue;
+			}
+
+			const U32 neighbor = static_cast<U32>(static_cast<S32>(index) + sFaceSteps[face]);
+			if (visited[neighbor >> 6] & (1ULL << (neighbor & 63)))
+				continue;
+			visited[neighbor >> 6] |= 1ULL << (neighbor & 63);
+			stack[top++] = static_cast<U16>(neighbor);
+		}
+	}
+	return faces;
+}
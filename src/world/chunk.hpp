@@ -0,0 +1,198 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_CHUNK_HPP_
+#define _WORLD_CHUNK_HPP_
+
+#include <stddef.h>
+#include "core/types.hpp"
+#include "world/block.hpp"
+
+struct ChunkMesh;
+
+#define CHUNK_SHIFT 4
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+#define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+
+/**
+ * Chunk faces are split in four quadrants for occlusion culling.
+ */
+#define OCCLUDER_QUADRANTS 4
+#define OCCLUDER_QUADRANT_SIZE (CHUNK_SIZE / 2)
+#define NO_OCCLUDER_LAYER 0xFF
+
+struct ChunkCoord {
+	S32 x;
+	S32 y;
+	S32 z;
+
+	bool operator==(const ChunkCoord &other) const {
+		return x == other.x && y == other.y && z == other.z;
+	}
+
+	bool operator!=(const ChunkCoord &other) const {
+		return !(*this == other);
+	}
+};
+
+struct ChunkCoordHash {
+	size_t operator()(const ChunkCoord &coord) const {
+		// Large primes from "Optimized Spatial Hashing for Collision Detection
+		// of Deformable Objects" (Teschner et al.)
+		return static_cast<size_t>((static_cast<U32>(coord.x) * 73856093U) ^ (static_cast<U32>(coord.y) * 19349663U) ^ (static_cast<U32>(coord.z) * 83492791U));
+	}
+};
+
+class Chunk {
+public:
+	Chunk(const ChunkCoord &coord);
+
+	const ChunkCoord& getCoord() const {
+		return mCoord;
+	}
+
+	BlockID getBlock(S32 x, S32 y, S32 z) const {
+		return mBlocks[getIndex(x, y, z)];
+	}
+
+	void setBlock(S32 x, S32 y, S32 z, BlockID block) {
+		mBlocks[getIndex(x, y, z)] = block;
+	}
+
+	BlockID getBlockAtIndex(U32 index) const {
+		return mBlocks[index];
+	}
+
+	void setBlockAtIndex(U32 index, BlockID block) {
+		mBlocks[index] = block;
+	}
+
+	/**
+	 * Raw access to the voxel data, laid out as described by getIndex().
+	 */
+	BlockID* getBlocks() {
+		return mBlocks;
+	}
+
+	const BlockID* getBlocks() const {
+		return mBlocks;
+	}
+
+	/**
+	 * Voxels are stored x-major, then z, then y so that a horizontal slice of
+	 * the chunk is contiguous in memory.
+	 */
+	static U32 getIndex(S32 x, S32 y, S32 z) {
+		return static_cast<U32>((y * CHUNK_SIZE + z) * CHUNK_SIZE + x);
+	}
+
+	/**
+	 * The CPU side mesh, owned by the chunk and returned to the ChunkPool along
+	 * with it. Null until the chunk has been meshed.
+	 */
+	ChunkMesh* getMesh() const {
+		return mMesh;
+	}
+
+	void setMesh(ChunkMesh *mesh) {
+		mMesh = mesh;
+	}
+
+	/**
+	 * Set when the mesh no longer matches the voxels of the chunk or of its
+	 * neighbours.
+	 */
+	bool isMeshDirty() const {
+		return mMeshDirty;
+	}
+
+	void setMeshDirty(bool dirty) {
+		mMeshDirty = dirty;
+	}
+
+	/**
+	 * Depth from the face of the first layer of the chunk that is opaque across
+	 * the whole quadrant, so nothing can be seen through it, or
+	 * NO_OCCLUDER_LAYER. Quadrant bit 0 picks the upper half on the first axis
+	 * following the face's axis, bit 1 on the second. Updated when the chunk
+	 * is meshed.
+	 */
+	U8 getOccluderLayer(U32 face, U32 quadrant) const {
+		return mOccluderLayers[face * OCCLUDER_QUADRANTS + quadrant];
+	}
+
+	bool hasOccluders() const {
+		return mHasOccluders;
+	}
+
+	void updateOccluders();
+
+	/**
+	 * Whether a line of sight can enter the chunk through one face and leave
+	 * through the other, going through air and translucent blocks only. Updated when the
+	 * chunk is meshed.
+	 */
+	bool canSeeThrough(U32 from, U32 to) const {
+		return (mFaceConnections[from] >> to) & 1;
+	}
+
+	/**
+	 * Flood fills the blocks that aren't opaque to find which faces they connect.
+	 */
+	void updateFaceConnections();
+
+	/**
+	 * Mask of the faces reachable from the block at a local position through
+	 * blocks that aren't opaque, none if the block is opaque.
+	 */
+	U32 getFacesReachableFrom(S32 x, S32 y, S32 z) const;
+
+private:
+	ChunkCoord mCoord;
+	ChunkMesh *mMesh;
+	bool mMeshDirty;
+	bool mHasOccluders;
+	U8 mOccluderLayers[FACE_COUNT * OCCLUDER_QUADRANTS];
+	U8 mFaceConnections[FACE_COUNT];
+	BlockID mBlocks[CHUNK_VOLUME];
+
+	/**
+	 * Sets the bits of the opaque blocks in visited and returns their amount.
+	 */
+	U32 markOpaqueBlocks(U64 *visited) const;
+
+	/**
+	 * Flood fills the blocks that aren't opaque from start, returning the mask of the
+	 * faces the fill touched.
+	 */
+	U32 fillFaces(U32 start, U64 *visited, U16 *stack) const;
+};
+
+#endif // _WORLD_CHUNK_HPP_
@@ -0,0 +1,207 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include "world/chunkMesher.hpp"
+#include "world/blockMaterials.hpp"
+#include "world/world.hpp"
+
+// Corners of every face, counter clockwise when seen from outside the block.
+static const U8 sFaceCorners[FACE_COUNT][4][3] = {
+	{ { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 }, { 0, 0, 0 } },
+	{ { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } },
+	{ { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } },
+	{ { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+	{ { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } },
+	{ { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 }, { 0, 0, 1 } }
+};
+
+static const S32 sFaceNormals[FACE_COUNT][3] = {
+	{ -1, 0, 0 },
+	{ 1, 0, 0 },
+	{ 0, -1, 0 },
+	{ 0, 1, 0 },
+	{ 0, 0, -1 },
+	{ 0, 0, 1 }
+};
+
+void ChunkMesher::gatherBlocks(const World *world, const Chunk *chunk, BlockID *grid) {
+	for (U32 i = 0; i < MESHER_GRID_VOLUME; ++i)
+		grid[i] = BlockType::AIR;
+
+	const BlockID *blocks = chunk->getBlocks();
+	for (S32 y = 0; y < CHUNK_SIZE; ++y) {
+		for (S32 z = 0; z < CHUNK_SIZE; ++z) {
+			const BlockID *row = blocks + Chunk::getIndex(0, y, z);
+			BlockID *dest = grid + getGridIndex(0, y, z);
+			for (S32 x = 0; x < CHUNK_SIZE; ++x)
+				dest[x] = row[x];
+		}
+	}
+
+	// Only the layer of each neighbour that touches this chunk matters.
+	const ChunkCoord &coord = chunk->getCoord();
+	for (U32 face = 0; face < FACE_COUNT; ++face) {
+		const S32 *normal = sFaceNormals[face];
+		const Chunk *neighbor = world->getChunk({ coord.x + normal[0], coord.y + normal[1], coord.z + normal[2] });
+		if (neighbor == nullptr)
+			continue;
+
+		for (S32 a = 0; a < CHUNK_SIZE; ++a) {
+			for (S32 b = 0; b < CHUNK_SIZE; ++b) {
+				// Local position inside the chunk grid of the border cell, and the
+				// cell of the neighbour it mirrors.
+				S32 x, y, z;
+				if (normal[0] != 0) {
+					x = normal[0] > 0 ? CHUNK_SIZE : -1;
+					y = a;
+					z = b;
+				} else if (normal[1] != 0) {
+					x = a;
+					y = normal[1] > 0 ? CHUNK_SIZE : -1;
+					z = b;
+				} else {
+					x = a;
+					y = b;
+					z = normal[2] > 0 ? CHUNK_SIZE : -1;
+				}
+				grid[getGridIndex(x, y, z)] = neighbor->getBlock(x & (CHUNK_SIZE - 1), y & (CHUNK_SIZE - 1), z & (CHUNK_SIZE - 1));
+			}
+		}
+	}
+}
+
+U32 ChunkMesher::buildMesh(const BlockID *grid, std::vector<ChunkVertex> &vertices) {
+	vertices.clear();
+
+	S32 neighborOffsets[FACE_COUNT];
+	for (U32 face = 0; face < FACE_COUNT; ++face) {
+		const S32 *normal = sFaceNormals[face];
+		neighborOffsets[face] = (normal[1] * MESHER_GRID_SIZE + normal[2]) * MESHER_GRID_SIZE + normal[0];
+	}
+
+	// Opaque quads on the first pass and translucent ones on the second, so
+	// each set is contiguous.
+	U32 translucentOffset = 0;
+	for (U32 pass = 0; pass < 2; ++pass) {
+		const bool translucent = pass == 1;
+		for (S32 y = 0; y < CHUNK_SIZE; ++y) {
+			for (S32 z = 0; z < CHUNK_SIZE; ++z) {
+				for (S32 x = 0; x < CHUNK_SIZE; ++x) {
+					const U32 index = getGridIndex(x, y, z);
+					const BlockID block = grid[index];
+					if (translucent ? !isTranslucentBlock(block) : !isOpaqueBlock(block))
+						continue;
+
+					for (U32 face = 0; face < FACE_COUNT; ++face) {
+						const BlockID neighbor = grid[index + neighborOffsets[face]];
+						// Translucent blocks only show towards the air, so a face
+						// between two translucent blocks isn't drawn twice.
+						if (isOpaqueBlock(neighbor) || (translucent && isTranslucentBlock(neighbor)))
+							continue;
+
+						const U16 layer = BlockMaterials::getLayer(block, face);
+						for (U32 corner = 0; corner < 4; ++corner) {
+							ChunkVertex vertex;
+							vertex.x = static_cast<U8>(x + sFaceCorners[face][corner][0]);
+							vertex.y = static_cast<U8>(y + sFaceCorners[face][corner][1]);
+							vertex.z = static_cast<U8>(z + sFaceCorners[face][corner][2]);
+							vertex.face = static_cast<U8>(face);
+							vertex.block = block;
+							vertex.layer = layer;
+							vertices.push_back(vertex);
+						}
+					}
+				}
+			}
+		}
+		if (!translucent)
+			translucentOffset = static_cast<U32>(vertices.size());
+	}
+	return translucentOffset;
+}
+
+void ChunkMesher::sortQuads(const ChunkVertex *vertices, U32 quadCount, const glm::vec3 &eye, std::vector<U32> &scratch, ChunkVertex *sorted) {
+	if (quadCount == 0)
+		return;
+
+	// Squared distances to the centres, with the centres scaled by four to
+	// keep the sums of the corners.
+	const glm::vec3 eye4 = eye * 4.0f;
+	auto getDistance = [&](U32 quad) {
+		const ChunkVertex *v = vertices + quad * 4;
+		const glm::vec3 offset = glm::vec3(
+			static_cast<F32>(v[0].x + v[1].x + v[2].x + v[3].x),
+			static_cast<F32>(v[0].y + v[1].y + v[2].y + v[3].y),
+			static_cast<F32>(v[0].z + v[1].z + v[2].z + v[3].z)
+		) - eye4;
+		return glm::dot(offset, offset);
+	};
+
+	F32 nearest = FLT_MAX;
+	F32 farthest = 0.0f;
+	for (U32 i = 0; i < quadCount; ++i) {
+		const F32 distance = getDistance(i);
+		nearest = std::min(nearest, distance);
+		farthest = std::max(farthest, distance);
+	}
+
+	// 16 bit keys over the range of distances in the chunk, farthest first,
+	// above the quad index. Two 8 bit passes sort them.
+	scratch.resize(quadCount * 2);
+	U32 *keys = scratch.data();
+	U32 *swapped = keys + quadCount;
+	const F32 scale = farthest > nearest ? 65535.0f / (farthest - nearest) : 0.0f;
+	for (U32 i = 0; i < quadCount; ++i) {
+		const U32 key = 65535 - static_cast<U32>((getDistance(i) - nearest) * scale);
+		keys[i] = (key << 16) | i;
+	}
+	for (U32 shift = 16; shift < 32; shift += 8) {
+		U32 histogram[256];
+		memset(histogram, 0, sizeof(histogram));
+		for (U32 i = 0; i < quadCount; ++i)
+			++histogram[(keys[i] >> shift) & 0xFF];
+
+		U32 offset = 0;
+		for (U32 bucket = 0; bucket < 256; ++bucket) {
+			const U32 count = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += count;
+		}
+		for (U32 i = 0; i < quadCount; ++i)
+			swapped[histogram[(keys[i] >> shift) & 0xFF]++] = keys[i];
+		std::swap(keys, swapped);
+	}
+
+	for (U32 i = 0; i < quadCount; ++i)
+		memcpy(sorted + i * 4, vertices + (keys[i] & 0xFFFF) * 4, sizeof(ChunkVertex) * 4);
+}
@@ -0,0 +1,139 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_CHUNKMESHER_HPP_
+#define _WORLD_CHUNKMESHER_HPP_
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+class World;
+
+/**
+ * Mesh vertex, packed into 8 bytes. Positions are relative to the origin of
+ * the chunk the mesh belongs to.
+ */
+struct ChunkVertex {
+	U8 x;
+	U8 y;
+	U8 z;
+	U8 face;
+	BlockID block;
+
+	/**
+	 * Texture array layer of the face, from BlockMaterials.
+	 */
+	U16 layer;
+};
+
+/**
+ * Most vertices a chunk mesh can have. Two neighbouring cells show at most
+ * one face between them: opaque blocks show towards anything but opaque
+ * blocks, translucent ones only towards air. That makes one quad for every
+ * pair of neighbouring cells inside the chunk and one for every cell face on
+ * its border, 3 * 16 * 16 * 15 + 6 * 16 * 16 = 13056 quads.
+ */
+#define MAX_CHUNK_MESH_QUADS (3 * CHUNK_SIZE * CHUNK_SIZE * (CHUNK_SIZE - 1) + FACE_COUNT * CHUNK_SIZE * CHUNK_SIZE)
+#define MAX_CHUNK_MESH_VERTICES (MAX_CHUNK_MESH_QUADS * 4)
+
+/**
+ * CPU side mesh of a chunk. Meshes are made of quads, four vertices each,
+ * which are drawn with the indices 0 1 2 0 2 3 so no index data is stored.
+ * The opaque quads come first, followed by the translucent ones. The vertex
+ * storage is a fixed size block owned by the ChunkPool.
+ */
+struct ChunkMesh {
+	ChunkVertex *vertices;
+	U32 vertexCount;
+	U32 translucentOffset;
+	U32 capacity;
+	U32 sizeClass;
+
+	/**
+	 * Changes every time the vertices are set, so renderers can tell when
+	 * their copy of the mesh is stale.
+	 */
+	U32 version;
+
+	U32 getQuadCount() const {
+		return vertexCount / 4;
+	}
+
+	U32 getOpaqueQuadCount() const {
+		return translucentOffset / 4;
+	}
+
+	U32 getTranslucentQuadCount() const {
+		return (vertexCount - translucentOffset) / 4;
+	}
+
+	bool isEmpty() const {
+		return vertexCount == 0;
+	}
+};
+
+/**
+ * Edge length of the block grid the mesher reads, the chunk with a one block
+ * border taken from its neighbours.
+ */
+#define MESHER_GRID_SIZE (CHUNK_SIZE + 2)
+#define MESHER_GRID_VOLUME (MESHER_GRID_SIZE * MESHER_GRID_SIZE * MESHER_GRID_SIZE)
+
+namespace ChunkMesher {
+	/**
+	 * Copies the chunk and the bordering layer of its six neighbours into a
+	 * MESHER_GRID_SIZE^3 grid. Neighbours that are not loaded read as air.
+	 */
+	void gatherBlocks(const World *world, const Chunk *chunk, BlockID *grid);
+
+	/**
+	 * Emits a quad for every opaque block face that can be seen past its
+	 * neighbour, then for every translucent block face that borders air,
+	 * reading the blocks from a grid filled by gatherBlocks(). Reserve
+	 * MAX_CHUNK_MESH_VERTICES in vertices to never grow it. Returns the index
+	 * of the first translucent vertex.
+	 */
+	U32 buildMesh(const BlockID *grid, std::vector<ChunkVertex> &vertices);
+
+	/**
+	 * Writes the quads sorted back to front as seen from eye, in the space of
+	 * the vertices, to sorted. Sorts on the distance to the quads' centres
+	 * with a radix sort, so the cost is linear in the amount of quads.
+	 */
+	void sortQuads(const ChunkVertex *vertices, U32 quadCount, const glm::vec3 &eye, std::vector<U32> &scratch, ChunkVertex *sorted);
+
+	inline U32 getGridIndex(S32 x, S32 y, S32 z) {
+		return static_cast<U32>(((y + 1) * MESHER_GRID_SIZE + (z + 1)) * MESHER_GRID_SIZE + (x + 1));
+	}
+}
+
+#endif // _WORLD_CHUNKMESHER_HPP_
@@ -0,0 +1,150 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <new>
+#include "world/chunkPool.hpp"
+#include "world/chunkMesher.hpp"
+
+ChunkPool::ChunkPool(bool hugePages) :
+	mChunks(sizeof(Chunk), CHUNKS_PER_SLAB, hugePages),
+	mNodes(CHUNK_NODE_SIZE, 1024, false),
+	mMeshes(sizeof(ChunkMesh), 1024, false) {
+	mMeshVersion = 0;
+	assert((1U << (MESH_SIZE_CLASS_SHIFT + MESH_SIZE_CLASS_COUNT - 1)) >= MAX_CHUNK_MESH_VERTICES);
+	assert((1U << (MESH_SIZE_CLASS_SHIFT + MESH_SIZE_CLASS_COUNT - 2)) < MAX_CHUNK_MESH_VERTICES);
+	for (U32 i = 0; i < MESH_SIZE_CLASS_COUNT; ++i) {
+		const size_t blockSize = (static_cast<size_t>(1) << (MESH_SIZE_CLASS_SHIFT + i)) * sizeof(ChunkVertex);
+		const U32 blocksPerSlab = blockSize < MESH_SLAB_SIZE ? static_cast<U32>(MESH_SLAB_SIZE / blockSize) : 1;
+		mVertexPools[i] = new FixedPool(blockSize, blocksPerSlab, hugePages);
+	}
+}
+
+ChunkPool::~ChunkPool() {
+	for (U32 i = 0; i < MESH_SIZE_CLASS_COUNT; ++i)
+		delete mVertexPools[i];
+}
+
+Chunk* ChunkPool::allocateChunk(const ChunkCoord &coord) {
+	void *memory = mChunks.allocate();
+	if (memory == nullptr)
+		return nullptr;
+	return new (memory) Chunk(coord);
+}
+
+void ChunkPool::freeChunk(Chunk *chunk) {
+	if (chunk == nullptr)
+		return;
+
+	if (chunk->getMesh() != nullptr)
+		freeMesh(chunk->getMesh());
+	chunk->~Chunk();
+	mChunks.free(chunk);
+}
+
+ChunkMesh* ChunkPool::allocateMesh() {
+	ChunkMesh *mesh = static_cast<ChunkMesh*>(mMeshes.allocate());
+	mesh->vertices = nullptr;
+	mesh->vertexCount = 0;
+	mesh->translucentOffset = 0;
+	mesh->capacity = 0;
+	mesh->sizeClass = 0;
+	mesh->version = ++mMeshVersion;
+	return mesh;
+}
+
+void ChunkPool::freeMesh(ChunkMesh *mesh) {
+	if (mesh->vertices != nullptr)
+		mVertexPools[mesh->sizeClass]->free(mesh->vertices);
+	mMeshes.free(mesh);
+}
+
+void ChunkPool::setMeshVertices(ChunkMesh *mesh, const ChunkVertex *vertices, U32 count, U32 translucentOffset) {
+	assert(count <= MAX_CHUNK_MESH_VERTICES);
+	assert(translucentOffset <= count);
+
+	if (count == 0) {
+		if (mesh->vertices != nullptr)
+			mVertexPools[mesh->sizeClass]->free(mesh->vertices);
+		mesh->vertices = nullptr;
+		mesh->capacity = 0;
+	} else {
+		U32 sizeClass = getSizeClass(count);
+
+		// Keep the current block unless it is too small or much too large.
+		if (mesh->vertices == nullptr || mesh->sizeClass < sizeClass || mesh->sizeClass > sizeClass + 1) {
+			if (mesh->vertices != nullptr)
+				mVertexPools[mesh->sizeClass]->free(mesh->vertices);
+
+			// Rather take a free block of the next class up than grow the pool.
+			if (!mVertexPools[sizeClass]->hasFreeElement() && sizeClass + 1 < MESH_SIZE_CLASS_COUNT && mVertexPools[sizeClass + 1]->hasFreeElement())
+				++sizeClass;
+
+			mesh->vertices = static_cast<ChunkVertex*>(mVertexPools[sizeClass]->allocate());
+			mesh->capacity = 1U << (MESH_SIZE_CLASS_SHIFT + sizeClass);
+			mesh->sizeClass = sizeClass;
+		}
+		memcpy(mesh->vertices, vertices, count * sizeof(ChunkVertex));
+	}
+	mesh->vertexCount = count;
+	mesh->translucentOffset = translucentOffset;
+	mesh->version = ++mMeshVersion;
+}
+
+U32 ChunkPool::getSizeClass(U32 vertexCount) {
+	U32 sizeClass = 0;
+	while ((1U << (MESH_SIZE_CLASS_SHIFT + sizeClass)) < vertexCount)
+		++sizeClass;
+	return sizeClass;
+}
+
+ChunkPool::Stats ChunkPool::getStats() const {
+	Stats stats;
+	stats.chunksUsed = mChunks.getUsedCount();
+	stats.chunkCapacity = mChunks.getCapacity();
+	stats.meshesUsed = mMeshes.getUsedCount();
+	stats.meshBytes = 0;
+	stats.meshCapacityBytes = 0;
+	stats.slabCount = mChunks.getSlabCount() + mNodes.getSlabCount() + mMeshes.getSlabCount();
+	for (U32 i = 0; i < MESH_SIZE_CLASS_COUNT; ++i) {
+		const FixedPool *pool = mVertexPools[i];
+		stats.meshBytes += pool->getUsedCount() * pool->getElementSize();
+		stats.meshCapacityBytes += pool->getCapacity() * pool->getElementSize();
+		stats.slabCount += pool->getSlabCount();
+	}
+	return stats;
+}
+
+void ChunkPool::printStats() const {
+	Stats stats = getStats();
+	printf("Chunk pool: %u of %u chunks, %u meshes using %.2f of %.2f MB, %u slabs\n", stats.chunksUsed, stats.chunkCapacity, stats.meshesUsed, stats.meshBytes / (1024.0 * 1024.0), stats.meshCapacityBytes / (1024.0 * 1024.0), stats.slabCount);
+}
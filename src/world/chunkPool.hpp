@@ -0,0 +1,130 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_CHUNKPOOL_HPP_
+#define _WORLD_CHUNKPOOL_HPP_
+
+#include "core/fixedPool.hpp"
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+struct ChunkMesh;
+struct ChunkVertex;
+
+#define CHUNKS_PER_SLAB 64
+
+/**
+ * Size of the pooled nodes of the world's chunk map.
+ */
+#define CHUNK_NODE_SIZE 64
+
+/**
+ * Mesh vertex blocks come in power of two size classes, the smallest holding
+ * 1 << MESH_SIZE_CLASS_SHIFT vertices and the largest the power of two at or
+ * above MAX_CHUNK_MESH_VERTICES.
+ */
+#define MESH_SIZE_CLASS_SHIFT 8
+#define MESH_SIZE_CLASS_COUNT 9
+
+/**
+ * Slabs of the mesh vertex pools are about this large.
+ */
+#define MESH_SLAB_SIZE (1024 * 1024)
+
+/**
+ * Recycles everything a chunk owns, so streaming chunks in and out as the
+ * camera moves reuses the same memory instead of going back to the heap.
+ * Chunks, chunk map nodes, meshes and their vertex blocks all come from slab
+ * pools.
+ */
+class ChunkPool {
+public:
+	struct Stats {
+		U32 chunksUsed;
+		U32 chunkCapacity;
+		U32 meshesUsed;
+
+		/**
+		 * Bytes of vertex blocks in use and held by the pools.
+		 */
+		size_t meshBytes;
+		size_t meshCapacityBytes;
+
+		/**
+		 * Slabs allocated by all of the pools together.
+		 */
+		U32 slabCount;
+	};
+
+	ChunkPool(bool hugePages);
+	~ChunkPool();
+
+	Chunk* allocateChunk(const ChunkCoord &coord);
+	void freeChunk(Chunk *chunk);
+
+	/**
+	 * Returns an empty mesh.
+	 */
+	ChunkMesh* allocateMesh();
+
+	/**
+	 * Releases the mesh along with its vertex block.
+	 */
+	void freeMesh(ChunkMesh *mesh);
+
+	/**
+	 * Copies the vertices into the mesh. The mesh keeps its block while that
+	 * fits them and is at most one size class larger than the smallest that
+	 * does, so a mesh that changes size a little isn't moved every time.
+	 * Otherwise it moves to a block of the smallest class that fits, or of
+	 * the class above when that one has a free block and the smallest would
+	 * have to grow its pool. The vertices from translucentOffset on are the
+	 * translucent quads.
+	 */
+	void setMeshVertices(ChunkMesh *mesh, const ChunkVertex *vertices, U32 count, U32 translucentOffset);
+
+	FixedPool& getNodePool() {
+		return mNodes;
+	}
+
+	Stats getStats() const;
+	void printStats() const;
+
+private:
+	FixedPool mChunks;
+	FixedPool mNodes;
+	FixedPool mMeshes;
+	FixedPool *mVertexPools[MESH_SIZE_CLASS_COUNT];
+	U32 mMeshVersion;
+
+	static U32 getSizeClass(U32 vertexCount);
+};
+
+#endif // _WORLD_CHUNKPOOL_HPP_
@@ -0,0 +1,371 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include "world/editLog.hpp"
+#include "world/fluidSimulation.hpp"
+#include "world/regionFile.hpp"
+#include "world/world.hpp"
+
+// x, y, z, index, old, new, checksum
+#define EDIT_RECORD_SIZE (sizeof(S32) * 3 + sizeof(U16) * 4)
+
+const U32 EditLog::FLUSH_INTERVAL_MS;
+const U32 EditLog::COMPACT_EDIT_THRESHOLD;
+const U32 EditLog::COMPACT_INTERVAL_MS;
+
+static U16 checksum(const U8 *data, size_t length) {
+	// Fletcher-16
+	U16 a = 0;
+	U16 b = 0;
+	for (size_t i = 0; i < length; ++i) {
+		a = (a + data[i]) % 255;
+		b = (b + a) % 255;
+	}
+	return static_cast<U16>((b << 8) | a);
+}
+
+static void encodeEdit(const BlockEdit &edit, U8 *out) {
+	memcpy(out + 0, &edit.coord.x, sizeof(S32));
+	memcpy(out + 4, &edit.coord.y, sizeof(S32));
+	memcpy(out + 8, &edit.coord.z, sizeof(S32));
+	memcpy(out + 12, &edit.index, sizeof(U16));
+	memcpy(out + 14, &edit.oldBlock, sizeof(U16));
+	memcpy(out + 16, &edit.newBlock, sizeof(U16));
+
+	U16 sum = checksum(out, EDIT_RECORD_SIZE - sizeof(U16));
+	memcpy(out + 18, &sum, sizeof(U16));
+}
+
+static bool decodeEdit(const U8 *in, BlockEdit &edit) {
+	U16 sum;
+	memcpy(&sum, in + 18, sizeof(U16));
+	if (sum != checksum(in, EDIT_RECORD_SIZE - sizeof(U16)))
+		return false;
+
+	memcpy(&edit.coord.x, in + 0, sizeof(S32));
+	memcpy(&edit.coord.y, in + 4, sizeof(S32));
+	memcpy(&edit.coord.z, in + 8, sizeof(S32));
+	memcpy(&edit.index, in + 12, sizeof(U16));
+	memcpy(&edit.oldBlock, in + 14, sizeof(U16));
+	memcpy(&edit.newBlock, in + 16, sizeof(U16));
+	return edit.index < CHUNK_VOLUME;
+}
+
+EditLog::EditLog() {
+	mFile = nullptr;
+	mQuit = false;
+	mCompactionFailed = false;
+	mEditsSinceCompaction = 0;
+	mLastCompaction = std::chrono::steady_clock::now();
+}
+
+EditLog::~EditLog() {
+	close();
+}
+
+bool EditLog::open(const std::string &savePath) {
+	close();
+
+	mSavePath = savePath;
+	mLogPath = savePath + ".editlog";
+	mFile = fopen(mLogPath.c_str(), "ab");
+	if (mFile == nullptr) {
+		printf("Unable to open edit log %s\n", mLogPath.c_str());
+		return false;
+	}
+
+	mQuit = false;
+	mLastCompaction = std::chrono::steady_clock::now();
+	mThread = std::thread(&EditLog::writerThread, this);
+	return true;
+}
+
+void EditLog::close() {
+	if (mThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mCondition.notify_one();
+		mThread.join();
+	}
+
+	if (mFile != nullptr) {
+		fclose(mFile);
+		mFile = nullptr;
+	}
+}
+
+U32 EditLog::replay(World *world) {
+	FILE *file = fopen(mLogPath.c_str(), "rb");
+	if (file == nullptr)
+		return 0;
+
+	U32 count = 0;
+	U8 record[EDIT_RECORD_SIZE];
+	BlockEdit edit;
+	bool torn = false;
+	while (true) {
+		const size_t read = fread(record, 1, EDIT_RECORD_SIZE, file);
+		if (read == 0)
+			break;
+
+		// A short or bad record means we crashed in the middle of a write.
+		// Nothing after it was ever acknowledged as durable.
+		if (read != EDIT_RECORD_SIZE || !decodeEdit(record, edit)) {
+			torn = true;
+			break;
+		}
+
+		Chunk *chunk = world->createChunk(edit.coord);
+		const BlockID oldBlock = chunk->getBlockAtIndex(edit.index);
+		chunk->setBlockAtIndex(edit.index, edit.newBlock);
+		world->notifyBlockChanged(chunk, edit.index, oldBlock);
+		mDirtyChunks.insert(edit.coord);
+
+		// Fluid placed by an edit is a source that flows again.
+		const glm::ivec3 local(edit.index & (CHUNK_SIZE - 1), edit.index >> (CHUNK_SHIFT * 2), (edit.index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1));
+		world->getFluids().activate(glm::ivec3(edit.coord.x, edit.coord.y, edit.coord.z) * CHUNK_SIZE + local);
+		++count;
+	}
+	fclose(file);
+
+	// Cut the torn record off before anything is appended after it, otherwise
+	// the next replay would stop there and drop the edits behind it.
+	if (torn && mFile != nullptr) {
+		if (!truncateFile(mFile, static_cast<U64>(count) * EDIT_RECORD_SIZE))
+			printf("Unable to truncate the torn end of edit log %s\n", mLogPath.c_str());
+	}
+
+	// Fold the replayed edits into the region files straight away.
+	if (count > 0)
+		compact(world);
+	return count;
+}
+
+void EditLog::append(const BlockEdit &edit) {
+	bool wake;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		wake = mPending.empty();
+		mPending.push_back(edit);
+	}
+	if (wake)
+		mCondition.notify_one();
+
+	mDirtyChunks.insert(edit.coord);
+	++mEditsSinceCompaction;
+}
+
+void EditLog::snapshotChunk(World *world, const Chunk *chunk) {
+	auto pos = mDirtyChunks.find(chunk->getCoord());
+	if (pos == mDirtyChunks.end())
+		return;
+
+	addSnapshot(world, chunk);
+	mDirtyChunks.erase(pos);
+}
+
+void EditLog::compact(World *world) {
+	for (const ChunkCoord &coord : mDirtyChunks) {
+		const Chunk *chunk = world->getChunk(coord);
+		if (chunk != nullptr)
+			addSnapshot(world, chunk);
+	}
+	mDirtyChunks.clear();
+	mEditsSinceCompaction = 0;
+	mLastCompaction = std::chrono::steady_clock::now();
+
+	// An empty compaction still retries the chunks of one that failed.
+	if (mSnapshots.empty() && !mCompactionFailed)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Compaction compaction;
+		compaction.chunks = std::move(mSnapshots);
+		compaction.editOffset = mPending.size();
+		mPendingCompactions.push_back(std::move(compaction));
+	}
+	mSnapshots.clear();
+	mCondition.notify_one();
+}
+
+void EditLog::update(World *world) {
+	if (mEditsSinceCompaction >= COMPACT_EDIT_THRESHOLD) {
+		compact(world);
+		return;
+	}
+
+	if (!mDirtyChunks.empty() || !mSnapshots.empty() || mCompactionFailed) {
+		auto elapsed = std::chrono::steady_clock::now() - mLastCompaction;
+		if (elapsed >= std::chrono::milliseconds(COMPACT_INTERVAL_MS))
+			compact(world);
+	}
+}
+
+void EditLog::addSnapshot(World *world, const Chunk *chunk) {
+	ChunkSnapshot snapshot;
+	snapshot.coord = chunk->getCoord();
+	snapshot.blocks.assign(chunk->getBlocks(), chunk->getBlocks() + CHUNK_VOLUME);
+	world->getFluids().removeFlowingFluid(snapshot.coord, snapshot.blocks.data());
+	mSnapshots.push_back(std::move(snapshot));
+}
+
+void EditLog::writerThread() {
+	std::vector<BlockEdit> edits;
+	std::vector<Compaction> compactions;
+	auto lastSync = std::chrono::steady_clock::now();
+
+	for (;;) {
+		bool quit;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() {
+				return mQuit || !mPending.empty() || !mPendingCompactions.empty();
+			});
+
+			// Rate limit syncs so that a burst of edits is grouped into a single
+			// sync instead of one per edit.
+			if (!mQuit) {
+				mCondition.wait_until(lock, lastSync + std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this]() {
+					return mQuit;
+				});
+			}
+
+			edits.swap(mPending);
+			compactions.swap(mPendingCompactions);
+			quit = mQuit;
+		}
+
+		size_t cursor = 0;
+		for (const Compaction &compaction : compactions) {
+			writeEdits(edits.data() + cursor, compaction.editOffset - cursor);
+			cursor = compaction.editOffset;
+			writeCompaction(compaction);
+		}
+		if (cursor < edits.size())
+			writeEdits(edits.data() + cursor, edits.size() - cursor);
+		if (!edits.empty() && mFile != nullptr) {
+			if (!syncFile(mFile))
+				printf("Unable to sync edit log %s\n", mLogPath.c_str());
+		}
+		lastSync = std::chrono::steady_clock::now();
+
+		edits.clear();
+		compactions.clear();
+
+		if (quit)
+			break;
+	}
+}
+
+bool EditLog::writeEdits(const BlockEdit *edits, size_t count) {
+	if (count == 0 || mFile == nullptr)
+		return true;
+
+	std::vector<U8> buffer(count * EDIT_RECORD_SIZE);
+	for (size_t i = 0; i < count; ++i)
+		encodeEdit(edits[i], buffer.data() + i * EDIT_RECORD_SIZE);
+
+	if (fwrite(buffer.data(), buffer.size(), 1, mFile) != 1) {
+		printf("Unable to write to edit log %s\n", mLogPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void EditLog::writeCompaction(const Compaction &compaction) {
+	// Group the chunks by region so every region file is opened and synced
+	// once. The sort has to be stable as a later snapshot of the same chunk
+	// supersedes an earlier one, so the chunks of failed compactions go first.
+	std::vector<const ChunkSnapshot*> chunks;
+	chunks.reserve(mRetryChunks.size() + compaction.chunks.size());
+	for (const ChunkSnapshot &snapshot : mRetryChunks)
+		chunks.push_back(&snapshot);
+	for (const ChunkSnapshot &snapshot : compaction.chunks)
+		chunks.push_back(&snapshot);
+
+	std::stable_sort(chunks.begin(), chunks.end(), [](const ChunkSnapshot *a, const ChunkSnapshot *b) {
+		ChunkCoord ra = RegionFile::getRegionCoord(a->coord);
+		ChunkCoord rb = RegionFile::getRegionCoord(b->coord);
+		if (ra.x != rb.x)
+			return ra.x < rb.x;
+		if (ra.y != rb.y)
+			return ra.y < rb.y;
+		return ra.z < rb.z;
+	});
+
+	bool success = true;
+	size_t i = 0;
+	while (i < chunks.size()) {
+		ChunkCoord regionCoord = RegionFile::getRegionCoord(chunks[i]->coord);
+		RegionFile region(mSavePath, regionCoord);
+		bool opened = region.open(true);
+
+		for (; i < chunks.size() && RegionFile::getRegionCoord(chunks[i]->coord) == regionCoord; ++i) {
+			if (!opened || !region.writeChunk(chunks[i]->coord, chunks[i]->blocks.data()))
+				success = false;
+		}
+		if (!opened || !region.sync())
+			success = false;
+	}
+
+	if (!success) {
+		// Keep the log around, it still holds every edit of the snapshots, and
+		// write them again with the next compaction.
+		// Only the latest snapshot of every chunk is kept.
+		printf("Unable to compact edit log %s into region files\n", mLogPath.c_str());
+		std::vector<ChunkSnapshot> retry;
+		std::unordered_map<ChunkCoord, size_t, ChunkCoordHash> latest;
+		for (const ChunkSnapshot *snapshot : chunks) {
+			auto pos = latest.insert(std::make_pair(snapshot->coord, retry.size()));
+			if (pos.second)
+				retry.push_back(*snapshot);
+			else
+				retry[pos.first->second] = *snapshot;
+		}
+		mRetryChunks.swap(retry);
+		mCompactionFailed = true;
+		return;
+	}
+
+	// Every edit logged so far is now stored in the region files.
+	mRetryChunks.clear();
+	mCompactionFailed = false;
+	if (mFile != nullptr)
+		fclose(mFile);
+	mFile = fopen(mLogPath.c_str(), "wb");
+	if (mFile == nullptr)
+		printf("Unable to truncate edit log %s\n", mLogPath.c_str());
+}
@@ -0,0 +1,177 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_EDITLOG_HPP_
+#define _WORLD_EDITLOG_HPP_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+class World;
+
+struct BlockEdit {
+	ChunkCoord coord;
+	U16 index;
+	BlockID oldBlock;
+	BlockID newBlock;
+};
+
+/**
+ * Append only write-ahead log of block edits.
+ *
+ * Edits are queued by the game thread and written out by a background thread
+ * that syncs the log to disk in batches every FLUSH_INTERVAL_MS, so an edit is
+ * durable within a few milliseconds without the frame ever touching the disk.
+ * Periodically the edited chunks are compacted into their region files and the
+ * log is truncated. On startup the log is replayed on top of the region files.
+ */
+class EditLog {
+public:
+	/**
+	 * How often the writer thread syncs queued edits to the disk.
+	 */
+	static const U32 FLUSH_INTERVAL_MS = 4;
+
+	/**
+	 * Compaction is triggered when either this many edits have been logged or
+	 * COMPACT_INTERVAL_MS has elapsed since the previous compaction.
+	 */
+	static const U32 COMPACT_EDIT_THRESHOLD = 8192;
+	static const U32 COMPACT_INTERVAL_MS = 30000;
+
+	EditLog();
+	~EditLog();
+
+	/**
+	 * Opens the log stored alongside the region files of savePath and starts
+	 * the writer thread.
+	 */
+	bool open(const std::string &savePath);
+
+	/**
+	 * Flushes every queued edit and compaction and stops the writer thread.
+	 */
+	void close();
+
+	/**
+	 * Applies every edit in the log to the world, loading chunks as required.
+	 * Must be called after open() and before the log is attached to the world
+	 * or any new edits are appended.
+	 * Returns the amount of edits that were replayed.
+	 */
+	U32 replay(World *world);
+
+	void append(const BlockEdit &edit);
+
+	/**
+	 * Copies the voxels of a chunk that has been edited since the last
+	 * compaction so they get written out by the next compaction. Called when a
+	 * chunk is about to be unloaded.
+	 */
+	void snapshotChunk(World *world, const Chunk *chunk);
+
+	/**
+	 * Snapshots every chunk edited since the last compaction and hands them
+	 * to the writer thread, which stores them in the region files and then
+	 * truncates the log. Chunks of a compaction that could not be written are
+	 * written again with the next one, and the log is only truncated once
+	 * every snapshot handed over has been stored.
+	 */
+	void compact(World *world);
+
+	/**
+	 * Called once per tick from the game thread; schedules compaction.
+	 */
+	void update(World *world);
+
+private:
+	struct ChunkSnapshot {
+		ChunkCoord coord;
+		std::vector<BlockID> blocks;
+	};
+
+	struct Compaction {
+		std::vector<ChunkSnapshot> chunks;
+
+		/**
+		 * The amount of queued edits that are contained in the snapshots. Edits
+		 * queued after them must survive the log truncation.
+		 */
+		size_t editOffset;
+	};
+
+	std::string mSavePath;
+	std::string mLogPath;
+	FILE *mFile;
+
+	std::thread mThread;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mQuit;
+
+	// Shared with the writer thread, guarded by mMutex.
+	std::vector<BlockEdit> mPending;
+	std::vector<Compaction> mPendingCompactions;
+
+	// Only touched by the writer thread. The chunks of compactions that
+	// failed, the log is not truncated until they are written.
+	std::vector<ChunkSnapshot> mRetryChunks;
+
+	// Set by the writer thread while there are chunks to retry, so the game
+	// thread keeps scheduling compactions.
+	std::atomic<bool> mCompactionFailed;
+
+	// Only touched by the game thread.
+	std::unordered_set<ChunkCoord, ChunkCoordHash> mDirtyChunks;
+	std::vector<ChunkSnapshot> mSnapshots;
+	U32 mEditsSinceCompaction;
+	std::chrono::steady_clock::time_point mLastCompaction;
+
+	/**
+	 * Copies the voxels of a chunk as they are saved, which leaves out the
+	 * flowing fluid.
+	 */
+	void addSnapshot(World *world, const Chunk *chunk);
+
+	void writerThread();
+	bool writeEdits(const BlockEdit *edits, size_t count);
+	void writeCompaction(const Compaction &compaction);
+};
+
+#endif // _WORLD_EDITLOG_HPP_
@@ -0,0 +1,454 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "world/fluidSimulation.hpp"
+#include "core/threadPool.hpp"
+#include "world/world.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define FLUID_STEP_TIME (1.0 / FLUID_STEP_RATE)
+
+struct FluidDesc {
+	BlockID block;
+
+	// Furthest the fluid flows sideways from where it lies, in cells.
+	U8 spread;
+
+	// Steps between updates of the fluid.
+	U8 interval;
+};
+
+static const FluidDesc sFluids[] = {
+	{ BlockType::WATER, 7, 1 },
+	{ BlockType::LAVA, 3, 4 }
+};
+
+// The cells whose next state depends on a cell: the one below it, the ones
+// beside it and the ones above those, which it is the ground under.
+static const S32 sWakeOffsets[][3] = {
+	{ 0, -1, 0 },
+	{ -1, 0, 0 }, { 1, 0, 0 }, { 0, 0, -1 }, { 0, 0, 1 },
+	{ -1, 1, 0 }, { 1, 1, 0 }, { 0, 1, -1 }, { 0, 1, 1 }
+};
+
+static const S32 sSideOffsets[4][2] = {
+	{ -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 }
+};
+
+static const FluidDesc* getFluid(BlockID block) {
+	for (const FluidDesc &fluid : sFluids) {
+		if (fluid.block == block)
+			return &fluid;
+	}
+	return nullptr;
+}
+
+static U32 getPhase(const ChunkCoord &coord) {
+	return static_cast<U32>((coord.x & 1) | ((coord.y & 1) << 1) | ((coord.z & 1) << 2));
+}
+
+static U32 findLowestBit(U64 value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return index;
+#else
+	return static_cast<U32>(__builtin_ctzll(value));
+#endif
+}
+
+static U32 countBits(U64 value) {
+#ifdef _MSC_VER
+	return static_cast<U32>(__popcnt64(value));
+#else
+	return static_cast<U32>(__builtin_popcountll(value));
+#endif
+}
+
+FluidSimulation::FluidSimulation(World *world) {
+	mWorld = world;
+	mTime = 0.0;
+	mStep = 0;
+	memset(&mLastStep, 0, sizeof(mLastStep));
+	memset(&mTotal, 0, sizeof(mTotal));
+}
+
+FluidSimulation::~FluidSimulation() {
+	for (auto &pair : mChunks)
+		delete pair.second;
+}
+
+void FluidSimulation::activate(const glm::ivec3 &pos) {
+	FluidChunk *fluid = getFluidChunk(World::getChunkCoord(pos));
+	if (fluid == nullptr)
+		return;
+
+	const glm::ivec3 local = World::getLocalPosition(pos);
+	fluid->depths[Chunk::getIndex(local.x, local.y, local.z)] = 0;
+
+	// Unlike a cell changed by the simulation the block itself may have
+	// become air that fluid flows into.
+	wake(pos);
+	for (const S32 *offset : sWakeOffsets)
+		wake(pos + glm::ivec3(offset[0], offset[1], offset[2]));
+}
+
+void FluidSimulation::addChunk(const Chunk *chunk) {
+	FluidChunk *fluid = nullptr;
+	const BlockID *blocks = chunk->getBlocks();
+	for (U32 index = 0; index < CHUNK_VOLUME; ++index) {
+		if (!isFluidBlock(blocks[index]))
+			continue;
+
+		if (fluid == nullptr)
+			fluid = getFluidChunk(chunk->getCoord());
+
+		// Within the chunk only the air the fluid may flow into needs waking.
+		const S32 x = static_cast<S32>(index & (CHUNK_SIZE - 1));
+		const S32 y = static_cast<S32>(index >> (CHUNK_SHIFT * 2));
+		const S32 z = static_cast<S32>((index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1));
+		for (const S32 *offset : sWakeOffsets) {
+			const S32 nx = x + offset[0];
+			const S32 ny = y + offset[1];
+			const S32 nz = z + offset[2];
+			if (nx < 0 || ny < 0 || nz < 0 || nx >= CHUNK_SIZE || ny >= CHUNK_SIZE || nz >= CHUNK_SIZE) {
+				const glm::ivec3 base = glm::ivec3(fluid->coord.x, fluid->coord.y, fluid->coord.z) * CHUNK_SIZE;
+				wake(base + glm::ivec3(nx, ny, nz));
+				continue;
+			}
+
+			const U32 neighbor = Chunk::getIndex(nx, ny, nz);
+			if (blocks[neighbor] == BlockType::AIR)
+				fluid->pending[neighbor >> 6] |= 1ULL << (neighbor & 63);
+		}
+	}
+
+	if (fluid != nullptr && !fluid->queued) {
+		fluid->queued = true;
+		mQueued.push_back(fluid);
+	}
+}
+
+void FluidSimulation::removeChunk(const ChunkCoord &coord) {
+	auto pos = mChunks.find(coord);
+	if (pos == mChunks.end())
+		return;
+
+	if (pos->second->queued)
+		mQueued.erase(std::find(mQueued.begin(), mQueued.end(), pos->second));
+	delete pos->second;
+	mChunks.erase(pos);
+}
+
+void FluidSimulation::removeFlowingFluid(const ChunkCoord &coord, BlockID *blocks) const {
+	auto pos = mChunks.find(coord);
+	if (pos == mChunks.end())
+		return;
+
+	// Fluid only ever flows into air.
+	const U8 *depths = pos->second->depths;
+	for (U32 index = 0; index < CHUNK_VOLUME; ++index) {
+		if (depths[index] != 0 && isFluidBlock(blocks[index]))
+			blocks[index] = BlockType::AIR;
+	}
+}
+
+U32 FluidSimulation::update(F64 delta) {
+	mTime += delta;
+	U32 steps = 0;
+	while (mTime >= FLUID_STEP_TIME && steps < FLUID_MAX_STEPS_PER_UPDATE) {
+		step();
+		mTime -= FLUID_STEP_TIME;
+		++steps;
+	}
+
+	// Fall behind instead of catching up over the next frames.
+	if (mTime >= FLUID_STEP_TIME)
+		mTime = 0.0;
+	return steps;
+}
+
+void FluidSimulation::step() {
+	++mStep;
+	memset(&mLastStep, 0, sizeof(mLastStep));
+	mLastStep.steps = 1;
+
+	for (U32 phase = 0; phase < FLUID_PHASE_COUNT; ++phase)
+		mPhases[phase].clear();
+	for (FluidChunk *fluid : mQueued) {
+		memcpy(fluid->active, fluid->pending, sizeof(fluid->active));
+		memset(fluid->pending, 0, sizeof(fluid->pending));
+		fluid->queued = false;
+		mPhases[getPhase(fluid->coord)].push_back(fluid);
+	}
+	mQueued.clear();
+
+	for (U32 phase = 0; phase < FLUID_PHASE_COUNT; ++phase) {
+		const std::vector<FluidChunk*> &chunks = mPhases[phase];
+		gThreadPool.parallelFor(static_cast<U32>(chunks.size()), 1, [this, &chunks](U32 start, U32 end) {
+			for (U32 i = start; i < end; ++i)
+				updateChunk(*chunks[i]);
+		});
+
+		// Cells woken across the border may belong to a chunk of a later
+		// phase, they are evaluated in the next step all the same.
+		for (FluidChunk *fluid : chunks) {
+			Chunk *chunk = mWorld->getChunk(fluid->coord);
+			for (const Change &change : fluid->changes)
+				mWorld->notifyBlockChanged(chunk, change.index, change.oldBlock, false);
+			for (const glm::ivec3 &pos : fluid->wakes)
+				wake(pos);
+			if (fluid->woken && !fluid->queued) {
+				fluid->queued = true;
+				mQueued.push_back(fluid);
+			}
+
+			++mLastStep.chunks;
+			mLastStep.cells += fluid->cells;
+			mLastStep.changes += fluid->changes.size();
+			fluid->changes.clear();
+			fluid->wakes.clear();
+			fluid->woken = false;
+		}
+	}
+
+	mTotal.steps += mLastStep.steps;
+	mTotal.chunks += mLastStep.chunks;
+	mTotal.cells += mLastStep.cells;
+	mTotal.changes += mLastStep.changes;
+}
+
+U32 FluidSimulation::getActiveCellCount() const {
+	U32 count = 0;
+	for (const FluidChunk *fluid : mQueued) {
+		for (U32 word = 0; word < FLUID_ACTIVE_WORDS; ++word)
+			count += countBits(fluid->pending[word]);
+	}
+	return count;
+}
+
+void FluidSimulation::printStats() const {
+	const F64 steps = mTotal.steps > 0 ? static_cast<F64>(mTotal.steps) : 1.0;
+	printf("Fluids: %llu steps, %.1f chunks and %.1f cells evaluated per step, %llu cells changed\n", static_cast<unsigned long long>(mTotal.steps), mTotal.chunks / steps, mTotal.cells / steps, static_cast<unsigned long long>(mTotal.changes));
+}
+
+FluidSimulation::FluidChunk* FluidSimulation::getFluidChunk(const ChunkCoord &coord) {
+	auto pos = mChunks.find(coord);
+	if (pos != mChunks.end())
+		return pos->second;
+	if (mWorld->getChunk(coord) == nullptr)
+		return nullptr;
+
+	FluidChunk *fluid = new FluidChunk;
+	fluid->coord = coord;
+	memset(fluid->active, 0, sizeof(fluid->active));
+	memset(fluid->pending, 0, sizeof(fluid->pending));
+	memset(fluid->depths, 0, sizeof(fluid->depths));
+	fluid->queued = false;
+	fluid->woken = false;
+	fluid->cells = 0;
+	mChunks[coord] = fluid;
+	return fluid;
+}
+
+void FluidSimulation::wake(const glm::ivec3 &pos) {
+	FluidChunk *fluid = getFluidChunk(World::getChunkCoord(pos));
+	if (fluid == nullptr)
+		return;
+
+	const glm::ivec3 local = World::getLocalPosition(pos);
+	const U32 index = Chunk::getIndex(local.x, local.y, local.z);
+	fluid->pending[index >> 6] |= 1ULL << (index & 63);
+	if (!fluid->queued) {
+		fluid->queued = true;
+		mQueued.push_back(fluid);
+	}
+}
+
+void FluidSimulation::wakeAround(FluidChunk &fluid, S32 x, S32 y, S32 z) {
+	for (const S32 *offset : sWakeOffsets) {
+		const S32 nx = x + offset[0];
+		const S32 ny = y + offset[1];
+		const S32 nz = z + offset[2];
+		if (nx < 0 || ny < 0 || nz < 0 || nx >= CHUNK_SIZE || ny >= CHUNK_SIZE || nz >= CHUNK_SIZE) {
+			const glm::ivec3 base = glm::ivec3(fluid.coord.x, fluid.coord.y, fluid.coord.z) * CHUNK_SIZE;
+			fluid.wakes.push_back(base + glm::ivec3(nx, ny, nz));
+			continue;
+		}
+
+		const U32 index = Chunk::getIndex(nx, ny, nz);
+		fluid.pending[index >> 6] |= 1ULL << (index & 63);
+		fluid.woken = true;
+	}
+}
+
+void FluidSimulation::updateChunk(FluidChunk &fluid) {
+	// Only written by the serial parts of a step, so the lookups are safe.
+	Neighborhood around;
+	for (S32 z = -1; z <= 1; ++z) {
+		for (S32 y = -1; y <= 1; ++y) {
+			for (S32 x = -1; x <= 1; ++x) {
+				const ChunkCoord coord = { fluid.coord.x + x, fluid.coord.y + y, fluid.coord.z + z };
+				const U32 slot = (z + 1) * 9 + (y + 1) * 3 + (x + 1);
+				auto pos = mChunks.find(coord);
+				around.chunks[slot] = mWorld->getChunk(coord);
+				around.fluids[slot] = pos != mChunks.end() ? pos->second : nullptr;
+			}
+		}
+	}
+
+	fluid.cells = 0;
+	for (U32 word = 0; word < FLUID_ACTIVE_WORDS; ++word) {
+		U64 bits = fluid.active[word];
+		while (bits != 0) {
+			const U32 index = word * 64 + findLowestBit(bits);
+			bits &= bits - 1;
+			++fluid.cells;
+
+			Change change;
+			const S32 x = static_cast<S32>(index & (CHUNK_SIZE - 1));
+			const S32 y = static_cast<S32>(index >> (CHUNK_SHIFT * 2));
+			const S32 z = static_cast<S32>((index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1));
+			const CellResult result = evaluateCell(around, x, y, z, change);
+			if (result == CELL_CHANGED) {
+				change.index = static_cast<U16>(index);
+				fluid.changes.push_back(change);
+			} else if (result == CELL_WAITING) {
+				fluid.pending[word] |= 1ULL << (index & 63);
+				fluid.woken = true;
+			}
+		}
+	}
+
+	// Applied once every cell has been evaluated, so that fluid moves a
+	// single cell per step within the chunk regardless of the order.
+	Chunk *chunk = around.chunks[13];
+	for (const Change &change : fluid.changes) {
+		chunk->setBlockAtIndex(change.index, change.newBlock);
+		fluid.depths[change.index] = change.depth;
+		wakeAround(fluid, change.index & (CHUNK_SIZE - 1), change.index >> (CHUNK_SHIFT * 2), (change.index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1));
+	}
+}
+
+FluidSimulation::CellResult FluidSimulation::evaluateCell(const Neighborhood &around, S32 x, S32 y, S32 z, Change &change) const {
+	BlockID block;
+	U8 depth;
+	readCell(around, x, y, z, block, depth);
+	const FluidDesc *fluid = getFluid(block);
+
+	// Sources and solid blocks stay as they are.
+	if (fluid != nullptr ? depth == 0 : block != BlockType::AIR)
+		return CELL_SETTLED;
+
+	// Take the shallowest feed, flowing fluid only takes its own kind.
+	BlockID feed = BlockType::AIR;
+	U32 feedDepth = 0;
+	BlockID other;
+	U8 otherDepth;
+	readCell(around, x, y + 1, z, other, otherDepth);
+	if (isFluidBlock(other) && (fluid == nullptr || other == block)) {
+		feed = other;
+		feedDepth = 1;
+	}
+	for (const S32 *side : sSideOffsets) {
+		readCell(around, x + side[0], y, z + side[1], other, otherDepth);
+		const FluidDesc *sideFluid = getFluid(other);
+		if (sideFluid == nullptr || (fluid != nullptr && other != block))
+			continue;
+		if (otherDepth + 1U > sideFluid->spread || (feed != BlockType::AIR && otherDepth + 1U >= feedDepth))
+			continue;
+
+		// Fluid spreads sideways where it lies on something and falls
+		// everywhere else.
+		BlockID ground;
+		U8 groundDepth;
+		readCell(around, x + side[0], y - 1, z + side[1], ground, groundDepth);
+		if (ground == BlockType::AIR || (isFluidBlock(ground) && groundDepth != 0))
+			continue;
+
+		feed = other;
+		feedDepth = otherDepth + 1U;
+	}
+
+	if (feed == block && (feed == BlockType::AIR || feedDepth == depth))
+		return CELL_SETTLED;
+
+	// A cell that drains goes at the pace of the fluid it held.
+	const FluidDesc *changing = fluid != nullptr ? fluid : getFluid(feed);
+	if (mStep % changing->interval != 0)
+		return CELL_WAITING;
+
+	change.oldBlock = block;
+	change.newBlock = feed;
+	change.depth = static_cast<U8>(feedDepth);
+	return CELL_CHANGED;
+}
+
+void FluidSimulation::readCell(const Neighborhood &around, S32 x, S32 y, S32 z, BlockID &block, U8 &depth) {
+	U32 slot = 13;
+	if (x < 0) {
+		x += CHUNK_SIZE;
+		slot -= 1;
+	} else if (x >= CHUNK_SIZE) {
+		x -= CHUNK_SIZE;
+		slot += 1;
+	}
+	if (y < 0) {
+		y += CHUNK_SIZE;
+		slot -= 3;
+	} else if (y >= CHUNK_SIZE) {
+		y -= CHUNK_SIZE;
+		slot += 3;
+	}
+	if (z < 0) {
+		z += CHUNK_SIZE;
+		slot -= 9;
+	} else if (z >= CHUNK_SIZE) {
+		z -= CHUNK_SIZE;
+		slot += 9;
+	}
+
+	const Chunk *chunk = around.chunks[slot];
+	if (chunk == nullptr) {
+		block = BlockType::STONE;
+		depth = 0;
+		return;
+	}
+
+	const U32 index = Chunk::getIndex(x, y, z);
+	block = chunk->getBlockAtIndex(index);
+	depth = around.fluids[slot] != nullptr ? around.fluids[slot]->depths[index] : 0;
+}
@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_FLUIDSIMULATION_HPP_
+#define _WORLD_FLUIDSIMULATION_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+class World;
+
+#define FLUID_ACTIVE_WORDS (CHUNK_VOLUME / 64)
+
+/**
+ * Chunks of the same phase are at least two chunks apart on one axis, so
+ * none of them touch, not even along an edge or a corner.
+ */
+#define FLUID_PHASE_COUNT 8
+
+// Steps per second, and most steps caught up on in one update.
+#define FLUID_STEP_RATE 20
+#define FLUID_MAX_STEPS_PER_UPDATE 4
+
+/**
+ * Cellular automaton for the fluid blocks. Every fluid cell has a depth, the
+ * amount of cells it has flowed sideways from a source. Sources are depth 0
+ * and never change, fluid falls into the air below it at depth 1 and spreads
+ * sideways from where it lies on something at one more, up to the spread of
+ * the fluid. Flowing fluid that is no longer fed drains away.
+ *
+ * Only active cells are evaluated, kept in a bitset per chunk. A cell that
+ * changes wakes the cells whose next state depends on it for the next step,
+ * and World::setBlock() wakes the cells around an edit, so the cost of a step
+ * follows the area that is flowing rather than the size of the world.
+ *
+ * A step updates the chunks in FLUID_PHASE_COUNT checkerboard phases, the
+ * chunks of a phase in parallel. A chunk only writes its own blocks and
+ * reads up to a block into its neighbours, which are never in its phase.
+ * Wakes across chunk borders are applied between the phases.
+ *
+ * Only the sources are saved, the flowing fluid is kept out of the edit log
+ * and the region files. The fluid of a chunk loaded from a save is taken as
+ * sources and woken, so the flow comes back from them.
+ */
+class FluidSimulation {
+public:
+	struct Stats {
+		U64 steps;
+		U64 chunks;
+		U64 cells;
+		U64 changes;
+	};
+
+	FluidSimulation(World *world);
+	~FluidSimulation();
+
+	/**
+	 * Wakes the cells around a block that was set from outside of the
+	 * simulation. Fluid placed there becomes a source.
+	 */
+	void activate(const glm::ivec3 &pos);
+
+	/**
+	 * Wakes the cells around the fluid of a chunk loaded from a save.
+	 */
+	void addChunk(const Chunk *chunk);
+
+	/**
+	 * Drops the state of a chunk that is being unloaded.
+	 */
+	void removeChunk(const ChunkCoord &coord);
+
+	/**
+	 * Turns the flowing fluid in a copy of the voxels of a chunk back into
+	 * the air it flowed into, leaving the sources.
+	 */
+	void removeFlowingFluid(const ChunkCoord &coord, BlockID *blocks) const;
+
+	/**
+	 * Runs the steps that are due after delta more seconds. Returns the
+	 * amount of steps that ran.
+	 */
+	U32 update(F64 delta);
+
+	/**
+	 * Evaluates every cell that was woken since the last step.
+	 */
+	void step();
+
+	/**
+	 * Cells and chunks woken for the next step.
+	 */
+	U32 getActiveCellCount() const;
+
+	U32 getActiveChunkCount() const {
+		return static_cast<U32>(mQueued.size());
+	}
+
+	const Stats& getLastStepStats() const {
+		return mLastStep;
+	}
+
+	const Stats& getTotalStats() const {
+		return mTotal;
+	}
+
+	void printStats() const;
+
+private:
+	enum CellResult {
+		CELL_SETTLED,
+		CELL_CHANGED,
+
+		// The cell changes once its fluid's next update comes around.
+		CELL_WAITING
+	};
+
+	struct Change {
+		U16 index;
+		U8 depth;
+		BlockID oldBlock;
+		BlockID newBlock;
+	};
+
+	struct FluidChunk {
+		ChunkCoord coord;
+		U64 active[FLUID_ACTIVE_WORDS];
+
+		// Cells woken for the next step.
+		U64 pending[FLUID_ACTIVE_WORDS];
+		bool queued;
+
+		U8 depths[CHUNK_VOLUME];
+
+		// Filled by the chunk's update and drained between the phases.
+		std::vector<Change> changes;
+		std::vector<glm::ivec3> wakes;
+		bool woken;
+		U32 cells;
+	};
+
+	/**
+	 * The chunks and fluid state around the chunk being updated, 3x3x3 with
+	 * the chunk itself in the middle.
+	 */
+	struct Neighborhood {
+		Chunk *chunks[27];
+		const FluidChunk *fluids[27];
+	};
+
+	World *mWorld;
+	std::unordered_map<ChunkCoord, FluidChunk*, ChunkCoordHash> mChunks;
+	std::vector<FluidChunk*> mQueued;
+	std::vector<FluidChunk*> mPhases[FLUID_PHASE_COUNT];
+	F64 mTime;
+	U64 mStep;
+	Stats mLastStep;
+	Stats mTotal;
+
+	FluidChunk* getFluidChunk(const ChunkCoord &coord);
+	void wake(const glm::ivec3 &pos);
+	void wakeAround(FluidChunk &fluid, S32 x, S32 y, S32 z);
+	void updateChunk(FluidChunk &fluid);
+	CellResult evaluateCell(const Neighborhood &around, S32 x, S32 y, S32 z, Change &change) const;
+
+	/**
+	 * Reads a cell up to a block outside of the chunk in the middle. Cells of
+	 * chunks that aren't loaded read as stone.
+	 */
+	static void readCell(const Neighborhood &around, S32 x, S32 y, S32 z, BlockID &block, U8 &depth);
+};
+
+#endif // _WORLD_FLUIDSIMULATION_HPP_
@@ -0,0 +1,233 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include "world/lodTerrain.hpp"
+#include "world/world.hpp"
+
+// Frames a node's mesh is kept after it was last selected, so moving back and
+// forth across a level boundary doesn't rebuild it every time.
+#define LOD_NODE_LIFETIME 300
+
+LodTerrain::LodTerrain(World *world) {
+	mWorld = world;
+	mUpdated = false;
+	mFrame = 0;
+	mSourceVersion = 0;
+	mBuildsLeft = 0;
+	mMeshScratch.reserve(MAX_CHUNK_MESH_VERTICES);
+}
+
+LodTerrain::~LodTerrain() {
+	for (auto &pair : mNodes) {
+		if (pair.second.mesh != nullptr)
+			mWorld->getPool().freeMesh(pair.second.mesh);
+	}
+}
+
+void LodTerrain::update(const glm::vec3 &cameraPosition, U32 maxBuilds) {
+	++mFrame;
+	mBuildsLeft = maxBuilds;
+	mSelectedNodes.clear();
+	mFullDetail.clear();
+	mUpdated = true;
+
+	// Start from the coarsest nodes covering the loaded chunks.
+	const U32 rootLevel = LOD_LEVEL_COUNT - 1;
+	mRoots.clear();
+	for (const auto &pair : mSources) {
+		if (pair.first.level == rootLevel)
+			mRoots.insert(pair.first);
+	}
+	for (const LodKey &root : mRoots)
+		selectNode(root, cameraPosition);
+
+	for (auto it = mNodes.begin(); it != mNodes.end();) {
+		if (mFrame - it->second.lastSelected > LOD_NODE_LIFETIME) {
+			if (it->second.mesh != nullptr)
+				mWorld->getPool().freeMesh(it->second.mesh);
+			it = mNodes.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void LodTerrain::gatherDownsampled(const ChunkCoord &origin, U32 level, BlockID *grid) {
+	const S32 chunks = 1 << level;
+	std::fill(grid, grid + MESHER_GRID_VOLUME, static_cast<BlockID>(AIR));
+	mCellCounts.assign(CHUNK_VOLUME * BLOCK_TYPE_COUNT, 0);
+
+	// Count the opaque blocks of every type falling into each cell.
+	for (S32 cy = 0; cy < chunks; ++cy) {
+		for (S32 cz = 0; cz < chunks; ++cz) {
+			for (S32 cx = 0; cx < chunks; ++cx) {
+				const Chunk *chunk = mWorld->getChunk({ origin.x + cx, origin.y + cy, origin.z + cz });
+				if (chunk == nullptr)
+					continue;
+
+				const BlockID *blocks = chunk->getBlocks();
+				for (S32 y = 0; y < CHUNK_SIZE; ++y) {
+					for (S32 z = 0; z < CHUNK_SIZE; ++z) {
+						for (S32 x = 0; x < CHUNK_SIZE; ++x) {
+							const BlockID block = blocks[Chunk::getIndex(x, y, z)];
+							if (!isOpaqueBlock(block))
+								continue;
+
+							const U32 cell = Chunk::getIndex((cx * CHUNK_SIZE + x) >> level, (cy * CHUNK_SIZE + y) >> level, (cz * CHUNK_SIZE + z) >> level);
+							++mCellCounts[cell * BLOCK_TYPE_COUNT + std::min<U32>(block, BLOCK_TYPE_COUNT - 1)];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	const U32 cellVolume = 1U << (level * 3);
+	for (S32 y = 0; y < CHUNK_SIZE; ++y) {
+		for (S32 z = 0; z < CHUNK_SIZE; ++z) {
+			for (S32 x = 0; x < CHUNK_SIZE; ++x) {
+				const U16 *counts = &mCellCounts[Chunk::getIndex(x, y, z) * BLOCK_TYPE_COUNT];
+				U32 solid = 0;
+				U32 common = AIR;
+				for (U32 block = 0; block < BLOCK_TYPE_COUNT; ++block) {
+					solid += counts[block];
+					if (counts[block] > counts[common])
+						common = block;
+				}
+				if (solid * 2 >= cellVolume)
+					grid[ChunkMesher::getGridIndex(x, y, z)] = static_cast<BlockID>(common);
+			}
+		}
+	}
+}
+
+void LodTerrain::selectNode(const LodKey &key, const glm::vec3 &cameraPosition) {
+	if (key.level == 0) {
+		if (mWorld->getChunk(key.origin) != nullptr)
+			mFullDetail.insert(key.origin);
+		return;
+	}
+
+	auto source = mSources.find(key);
+	if (source == mSources.end())
+		return;
+	const U32 version = source->second.version;
+
+	const F32 size = static_cast<F32>(CHUNK_SIZE << key.level);
+	const glm::vec3 min = glm::vec3(key.origin.x, key.origin.y, key.origin.z) * static_cast<F32>(CHUNK_SIZE);
+	const glm::vec3 closest = glm::clamp(cameraPosition, min, min + glm::vec3(size));
+	const bool split = glm::length(closest - cameraPosition) < LOD_SPLIT_DISTANCE * size;
+
+	if (!split && prepareNode(key, version)) {
+		const Node &node = mNodes[key];
+		if (!node.mesh->isEmpty()) {
+			LodNode selected;
+			selected.key = key;
+			selected.mesh = node.mesh;
+			mSelectedNodes.push_back(selected);
+		}
+		return;
+	}
+
+	const S32 half = 1 << (key.level - 1);
+	for (S32 i = 0; i < 8; ++i) {
+		LodKey child;
+		child.origin.x = key.origin.x + ((i & 1) ? half : 0);
+		child.origin.y = key.origin.y + ((i & 2) ? half : 0);
+		child.origin.z = key.origin.z + ((i & 4) ? half : 0);
+		child.level = key.level - 1;
+		selectNode(child, cameraPosition);
+	}
+}
+
+bool LodTerrain::prepareNode(const LodKey &key, U32 version) {
+	Node &node = mNodes[key];
+	if (node.mesh == nullptr)
+		node.sourceVersion = 0;
+	node.lastSelected = mFrame;
+
+	if (node.mesh != nullptr && node.sourceVersion == version)
+		return true;
+
+	// Keep drawing an out of date mesh until there is time to rebuild it.
+	if (mBuildsLeft == 0)
+		return node.mesh != nullptr;
+	--mBuildsLeft;
+
+	BlockID grid[MESHER_GRID_VOLUME];
+	gatherDownsampled(key.origin, key.level, grid);
+	const U32 translucentOffset = ChunkMesher::buildMesh(grid, mMeshScratch);
+	if (node.mesh == nullptr)
+		node.mesh = mWorld->getPool().allocateMesh();
+	mWorld->getPool().setMeshVertices(node.mesh, mMeshScratch.data(), static_cast<U32>(mMeshScratch.size()), translucentOffset);
+	node.sourceVersion = version;
+	return true;
+}
+
+void LodTerrain::addChunk(const ChunkCoord &coord) {
+	updateSources(coord, 1);
+}
+
+void LodTerrain::removeChunk(const ChunkCoord &coord) {
+	updateSources(coord, -1);
+}
+
+void LodTerrain::markChunkChanged(const ChunkCoord &coord) {
+	updateSources(coord, 0);
+}
+
+void LodTerrain::updateSources(const ChunkCoord &coord, S32 loadedChunks) {
+	const U32 version = ++mSourceVersion;
+	for (U32 level = 1; level < LOD_LEVEL_COUNT; ++level) {
+		const LodKey key = getNodeKey(coord, level);
+		auto pos = mSources.find(key);
+		if (pos == mSources.end()) {
+			if (loadedChunks <= 0)
+				continue;
+			pos = mSources.insert(std::make_pair(key, Source())).first;
+			pos->second.loadedChunks = 0;
+		}
+
+		pos->second.version = version;
+		pos->second.loadedChunks += loadedChunks;
+		if (pos->second.loadedChunks == 0)
+			mSources.erase(pos);
+	}
+}
+
+LodKey LodTerrain::getNodeKey(const ChunkCoord &coord, U32 level) {
+	LodKey key;
+	key.origin.x = (coord.x >> level) << level;
+	key.origin.y = (coord.y >> level) << level;
+	key.origin.z = (coord.z >> level) << level;
+	key.level = level;
+	return key;
+}
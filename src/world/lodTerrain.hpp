@@ -0,0 +1,183 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_LODTERRAIN_HPP_
+#define _WORLD_LODTERRAIN_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+#include "world/chunkMesher.hpp"
+
+class World;
+
+/**
+ * Levels of detail, level L covering 2^L chunks along every axis at 2^L
+ * blocks per cell. Level 0 is the regular chunk mesh.
+ */
+#define LOD_LEVEL_COUNT 4
+
+/**
+ * A node is split into its children while the camera is closer to it than
+ * this many times its edge length.
+ */
+#define LOD_SPLIT_DISTANCE 2.0f
+
+struct LodKey {
+	/**
+	 * The first chunk the node covers, aligned to 2^level chunks.
+	 */
+	ChunkCoord origin;
+	U32 level;
+
+	bool operator==(const LodKey &other) const {
+		return origin == other.origin && level == other.level;
+	}
+};
+
+struct LodKeyHash {
+	size_t operator()(const LodKey &key) const {
+		return ChunkCoordHash()(key.origin) ^ (static_cast<size_t>(key.level) * 2654435761U);
+	}
+};
+
+struct LodNode {
+	LodKey key;
+	ChunkMesh *mesh;
+};
+
+/**
+ * Picks a level of detail for every loaded region of the world based on the
+ * distance to the camera and meshes distant regions from downsampled voxel
+ * grids, so far away terrain costs about as many triangles per node as a
+ * single chunk.
+ *
+ * A downsampled grid is meshed by the regular chunk mesher, with the vertices
+ * scaled by 2^level when drawn. The grid's border reads as air, so every node
+ * is closed off by skirt walls along its sides. Where a neighbour is drawn at
+ * another level the walls cover the cracks between the two, anywhere else
+ * they face into solid ground and are never seen.
+ */
+class LodTerrain {
+public:
+	LodTerrain(World *world);
+	~LodTerrain();
+
+	/**
+	 * Selects the levels for the camera position and builds up to maxBuilds
+	 * node meshes that are missing or out of date. Nodes whose mesh isn't
+	 * built yet are drawn with their children until it is.
+	 */
+	void update(const glm::vec3 &cameraPosition, U32 maxBuilds);
+
+	/**
+	 * Downsampled nodes selected by the last update, level 1 and up.
+	 */
+	const std::vector<LodNode>& getNodes() const {
+		return mSelectedNodes;
+	}
+
+	/**
+	 * Whether the last update selected the chunk to be drawn at full detail.
+	 * Every chunk is before the first update.
+	 */
+	bool isFullDetail(const ChunkCoord &coord) const {
+		return !mUpdated || mFullDetail.count(coord) != 0;
+	}
+
+	/**
+	 * Coarsest nodes covering the loaded chunks as of the last update.
+	 */
+	const std::unordered_set<LodKey, LodKeyHash>& getRoots() const {
+		return mRoots;
+	}
+
+	/**
+	 * Keep the versions of the nodes covering a chunk up to date. The world
+	 * calls these when a chunk is loaded or unloaded and when its blocks
+	 * change.
+	 */
+	void addChunk(const ChunkCoord &coord);
+	void removeChunk(const ChunkCoord &coord);
+	void markChunkChanged(const ChunkCoord &coord);
+
+	/**
+	 * Fills a mesher grid with the 2^level chunks cubed starting at origin,
+	 * each cell holding the most common opaque block of its 2^level blocks
+	 * cubed when at least half of them are opaque. The border reads as air.
+	 */
+	void gatherDownsampled(const ChunkCoord &origin, U32 level, BlockID *grid);
+
+private:
+	struct Node {
+		ChunkMesh *mesh;
+
+		/**
+		 * Version of the covered chunks when the mesh was built, another one
+		 * means the chunks changed.
+		 */
+		U32 sourceVersion;
+		U64 lastSelected;
+	};
+
+	/**
+	 * The chunks covered by a node. The version is taken from a counter every
+	 * time one of them is loaded, unloaded or changed.
+	 */
+	struct Source {
+		U32 version;
+		U32 loadedChunks;
+	};
+
+	World *mWorld;
+	std::unordered_map<LodKey, Node, LodKeyHash> mNodes;
+	std::unordered_map<LodKey, Source, LodKeyHash> mSources;
+	U32 mSourceVersion;
+	std::unordered_set<LodKey, LodKeyHash> mRoots;
+	std::vector<LodNode> mSelectedNodes;
+	std::unordered_set<ChunkCoord, ChunkCoordHash> mFullDetail;
+	bool mUpdated;
+	U64 mFrame;
+
+	U32 mBuildsLeft;
+	std::vector<U16> mCellCounts;
+	std::vector<ChunkVertex> mMeshScratch;
+
+	void selectNode(const LodKey &key, const glm::vec3 &cameraPosition);
+	bool prepareNode(const LodKey &key, U32 version);
+	void updateSources(const ChunkCoord &coord, S32 loadedChunks);
+
+	static LodKey getNodeKey(const ChunkCoord &coord, U32 level);
+};
+
+#endif // _WORLD_LODTERRAIN_HPP_
@@ -0,0 +1,117 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <limits>
+#include "core/threadPool.hpp"
+#include "world/raycast.hpp"
+#include "world/world.hpp"
+
+// Amount of rays that a worker claims at once in castRays.
+#define RAYCAST_BATCH_SIZE 256
+
+bool Raycast::castRay(const World *world, const glm::vec3 &origin, const glm::vec3 &direction, F32 maxDistance, RaycastHit &hit) {
+	hit.hit = false;
+
+	F32 length = glm::length(direction);
+	if (length == 0.0f)
+		return false;
+	const glm::vec3 dir = direction / length;
+
+	// Set up the traversal as described in "A Fast Voxel Traversal Algorithm
+	// for Ray Tracing" (Amanatides and Woo). tMax is the distance along the
+	// ray to the next voxel boundary on each axis and tDelta the distance
+	// between two boundaries.
+	const F32 infinity = std::numeric_limits<F32>::infinity();
+	glm::ivec3 cell = glm::ivec3(glm::floor(origin));
+	glm::ivec3 step;
+	glm::vec3 tMax;
+	glm::vec3 tDelta;
+	for (S32 axis = 0; axis < 3; ++axis) {
+		if (dir[axis] > 0.0f) {
+			step[axis] = 1;
+			tDelta[axis] = 1.0f / dir[axis];
+			tMax[axis] = (static_cast<F32>(cell[axis] + 1) - origin[axis]) * tDelta[axis];
+		} else if (dir[axis] < 0.0f) {
+			step[axis] = -1;
+			tDelta[axis] = -1.0f / dir[axis];
+			tMax[axis] = (origin[axis] - static_cast<F32>(cell[axis])) * tDelta[axis];
+		} else {
+			step[axis] = 0;
+			tDelta[axis] = infinity;
+			tMax[axis] = infinity;
+		}
+	}
+
+	// Only go through the chunk table when the ray crosses into a new chunk.
+	const Chunk *chunk = world->getChunk(World::getChunkCoord(cell));
+	glm::ivec3 normal(0);
+	F32 distance = 0.0f;
+
+	for (;;) {
+		if (chunk != nullptr) {
+			glm::ivec3 local = World::getLocalPosition(cell);
+			BlockID block = chunk->getBlock(local.x, local.y, local.z);
+			if (isSolidBlock(block)) {
+				hit.hit = true;
+				hit.position = cell;
+				hit.normal = normal;
+				hit.distance = distance;
+				hit.block = block;
+				return true;
+			}
+		}
+
+		S32 axis;
+		if (tMax.x < tMax.y)
+			axis = tMax.x < tMax.z ? 0 : 2;
+		else
+			axis = tMax.y < tMax.z ? 1 : 2;
+
+		distance = tMax[axis];
+		if (distance > maxDistance)
+			return false;
+
+		cell[axis] += step[axis];
+		tMax[axis] += tDelta[axis];
+		normal = glm::ivec3(0);
+		normal[axis] = -step[axis];
+
+		S32 local = cell[axis] & (CHUNK_SIZE - 1);
+		if (local == (step[axis] > 0 ? 0 : CHUNK_SIZE - 1))
+			chunk = world->getChunk(World::getChunkCoord(cell));
+	}
+}
+
+void Raycast::castRays(const World *world, const Ray *rays, RaycastHit *hits, U32 count) {
+	gThreadPool.parallelFor(count, RAYCAST_BATCH_SIZE, [world, rays, hits](U32 start, U32 end) {
+		for (U32 i = start; i < end; ++i)
+			castRay(world, rays[i].origin, rays[i].direction, rays[i].maxDistance, hits[i]);
+	});
+}
@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_RAYCAST_HPP_
+#define _WORLD_RAYCAST_HPP_
+
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "world/block.hpp"
+
+class World;
+
+struct Ray {
+	glm::vec3 origin;
+	glm::vec3 direction;
+	F32 maxDistance;
+};
+
+struct RaycastHit {
+	bool hit;
+
+	/**
+	 * The solid voxel that the ray hit.
+	 */
+	glm::ivec3 position;
+
+	/**
+	 * Normal of the face that the ray entered through. position + normal is
+	 * the empty voxel in front of the hit, which is where a placed block goes.
+	 * Zero if the ray started inside a solid voxel.
+	 */
+	glm::ivec3 normal;
+
+	F32 distance;
+	BlockID block;
+};
+
+namespace Raycast {
+	/**
+	 * Walks the voxel grid along the ray using the Amanatides-Woo DDA and
+	 * reports the first solid voxel within maxDistance. Voxels inside chunks
+	 * that are not loaded are treated as air.
+	 */
+	bool castRay(const World *world, const glm::vec3 &origin, const glm::vec3 &direction, F32 maxDistance, RaycastHit &hit);
+
+	/**
+	 * Casts count rays spread across the worker threads of gThreadPool,
+	 * writing one hit per ray. The world must not be modified until the call
+	 * returns.
+	 */
+	void castRays(const World *world, const Ray *rays, RaycastHit *hits, U32 count);
+}
+
+#endif // _WORLD_RAYCAST_HPP_
@@ -0,0 +1,162 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "world/regionFile.hpp"
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+#define REGION_HEADER_SIZE REGION_CHUNK_COUNT
+#define REGION_SLOT_SIZE (CHUNK_VOLUME * sizeof(BlockID))
+
+bool syncFile(FILE *file) {
+	if (fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool truncateFile(FILE *file, U64 size) {
+	if (fflush(file) != 0)
+		return false;
+#ifdef _WIN32
+	if (_chsize_s(_fileno(file), static_cast<__int64>(size)) != 0)
+		return false;
+#else
+	if (ftruncate(fileno(file), static_cast<off_t>(size)) != 0)
+		return false;
+#endif
+	return syncFile(file);
+}
+
+RegionFile::RegionFile(const std::string &savePath, const ChunkCoord &regionCoord) {
+	mRegionCoord = regionCoord;
+	mPath = savePath + "." + std::to_string(regionCoord.x) + "." + std::to_string(regionCoord.y) + "." + std::to_string(regionCoord.z) + ".region";
+	mFile = nullptr;
+}
+
+RegionFile::~RegionFile() {
+	close();
+}
+
+bool RegionFile::open(bool create) {
+	close();
+
+	mFile = fopen(mPath.c_str(), "r+b");
+	if (mFile == nullptr && create) {
+		mFile = fopen(mPath.c_str(), "w+b");
+		if (mFile == nullptr)
+			return false;
+
+		// Write out an empty header.
+		U8 header[REGION_HEADER_SIZE] = { 0 };
+		if (fwrite(header, sizeof(header), 1, mFile) != 1) {
+			close();
+			return false;
+		}
+	}
+	return mFile != nullptr;
+}
+
+void RegionFile::close() {
+	if (mFile != nullptr) {
+		fclose(mFile);
+		mFile = nullptr;
+	}
+}
+
+bool RegionFile::readChunk(Chunk *chunk) {
+	if (mFile == nullptr)
+		return false;
+
+	U32 slot = getSlot(chunk->getCoord());
+	U8 present = 0;
+	if (fseek(mFile, static_cast<long>(slot), SEEK_SET) != 0 || fread(&present, 1, 1, mFile) != 1 || !present)
+		return false;
+
+	if (fseek(mFile, static_cast<long>(REGION_HEADER_SIZE + slot * REGION_SLOT_SIZE), SEEK_SET) != 0)
+		return false;
+	return fread(chunk->getBlocks(), REGION_SLOT_SIZE, 1, mFile) == 1;
+}
+
+bool RegionFile::writeChunk(const ChunkCoord &coord, const BlockID *blocks) {
+	if (mFile == nullptr)
+		return false;
+
+	U32 slot = getSlot(coord);
+	U8 present = 0;
+	if (fseek(mFile, static_cast<long>(slot), SEEK_SET) != 0)
+		return false;
+	if (fread(&present, 1, 1, mFile) != 1)
+		present = 0;
+
+	if (fseek(mFile, static_cast<long>(REGION_HEADER_SIZE + slot * REGION_SLOT_SIZE), SEEK_SET) != 0)
+		return false;
+	if (fwrite(blocks, REGION_SLOT_SIZE, 1, mFile) != 1)
+		return false;
+	if (present)
+		return true;
+
+	// The voxel data has to hit the disk before the slot is flagged as present,
+	// otherwise a crash could expose a half written chunk. Overwriting a slot
+	// that is already present is safe since replaying the edit log repairs it.
+	if (!syncFile(mFile))
+		return false;
+
+	present = 1;
+	if (fseek(mFile, static_cast<long>(slot), SEEK_SET) != 0)
+		return false;
+	return fwrite(&present, 1, 1, mFile) == 1;
+}
+
+bool RegionFile::sync() {
+	if (mFile == nullptr)
+		return false;
+	return syncFile(mFile);
+}
+
+ChunkCoord RegionFile::getRegionCoord(const ChunkCoord &chunkCoord) {
+	ChunkCoord region;
+	region.x = chunkCoord.x >> REGION_SHIFT;
+	region.y = chunkCoord.y >> REGION_SHIFT;
+	region.z = chunkCoord.z >> REGION_SHIFT;
+	return region;
+}
+
+U32 RegionFile::getSlot(const ChunkCoord &chunkCoord) {
+	const S32 mask = REGION_SIZE - 1;
+	return static_cast<U32>(((chunkCoord.y & mask) * REGION_SIZE + (chunkCoord.z & mask)) * REGION_SIZE + (chunkCoord.x & mask));
+}
@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_REGIONFILE_HPP_
+#define _WORLD_REGIONFILE_HPP_
+
+#include <stdio.h>
+#include <string>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+#define REGION_SHIFT 3
+#define REGION_SIZE (1 << REGION_SHIFT)
+#define REGION_CHUNK_COUNT (REGION_SIZE * REGION_SIZE * REGION_SIZE)
+
+/**
+ * A region file stores REGION_SIZE^3 chunks in fixed size slots. The file
+ * starts with one presence byte per slot followed by the raw voxel data of
+ * every slot, so a chunk can be read or rewritten with a single seek.
+ */
+class RegionFile {
+public:
+	RegionFile(const std::string &savePath, const ChunkCoord &regionCoord);
+	~RegionFile();
+
+	/**
+	 * Opens the region file. If create is true the file is created when it
+	 * does not already exist.
+	 */
+	bool open(bool create);
+	void close();
+
+	/**
+	 * Reads the chunk's voxels from the file. Returns false if the chunk has
+	 * never been written to this region.
+	 */
+	bool readChunk(Chunk *chunk);
+	bool writeChunk(const ChunkCoord &coord, const BlockID *blocks);
+
+	/**
+	 * Flushes and syncs the file to the disk.
+	 */
+	bool sync();
+
+	static ChunkCoord getRegionCoord(const ChunkCoord &chunkCoord);
+
+private:
+	std::string mPath;
+	ChunkCoord mRegionCoord;
+	FILE *mFile;
+
+	static U32 getSlot(const ChunkCoord &chunkCoord);
+};
+
+/**
+ * Syncs the contents of a stdio file to the disk.
+ */
+bool syncFile(FILE *file);
+
+/**
+ * Cuts a stdio file off after size bytes and syncs it to the disk.
+ */
+bool truncateFile(FILE *file, U64 size);
+
+#endif // _WORLD_REGIONFILE_HPP_
@@ -0,0 +1,177 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include "world/smoothMesher.hpp"
+#include "world/block.hpp"
+
+// Cells meshed along every axis, the node and its border.
+#define SMOOTH_CELL_COUNT (CHUNK_SIZE + SMOOTH_BORDER * 2)
+
+#define NO_VERTEX 0xFFFF
+
+// Slopes flatter than these are covered in grass or dirt, steeper ones show
+// bare stone.
+#define SMOOTH_GRASS_SLOPE 0.7f
+#define SMOOTH_DIRT_SLOPE 0.4f
+
+static inline U32 getCellIndex(S32 x, S32 y, S32 z) {
+	return static_cast<U32>(((y + SMOOTH_BORDER) * SMOOTH_CELL_COUNT + (z + SMOOTH_BORDER)) * SMOOTH_CELL_COUNT + (x + SMOOTH_BORDER));
+}
+
+static inline bool isSkirtCell(S32 x, S32 y, S32 z) {
+	const S32 first = -SMOOTH_BORDER;
+	const S32 last = CHUNK_SIZE + SMOOTH_BORDER - 1;
+	return x == first || y == first || z == first || x == last || y == last || z == last;
+}
+
+static inline S8 packNormal(F32 value) {
+	return static_cast<S8>(lroundf(value * 127.0f));
+}
+
+static U16 addCellVertex(const F32 *densities, S32 x, S32 y, S32 z, std::vector<SmoothVertex> &vertices) {
+	// Corner i of the cell is offset by bit 0 on x, bit 1 on y and bit 2 on z.
+	F32 corners[8];
+	U32 solid = 0;
+	for (U32 i = 0; i < 8; ++i) {
+		corners[i] = densities[SmoothMesher::getSampleIndex(x + (i & 1), y + ((i >> 1) & 1), z + ((i >> 2) & 1))];
+		if (corners[i] > 0.0f)
+			solid |= 1 << i;
+	}
+	if (solid == 0 || solid == 0xFF)
+		return NO_VERTEX;
+
+	// Average the points where the surface crosses the twelve edges.
+	F32 position[3] = { 0.0f, 0.0f, 0.0f };
+	U32 crossings = 0;
+	for (U32 axis = 0; axis < 3; ++axis) {
+		const U32 bit = 1 << axis;
+		for (U32 a = 0; a < 8; ++a) {
+			if ((a & bit) != 0 || ((solid >> a) & 1) == ((solid >> (a | bit)) & 1))
+				continue;
+
+			const F32 t = corners[a] / (corners[a] - corners[a | bit]);
+			for (U32 i = 0; i < 3; ++i)
+				position[i] += (i == axis) ? t : static_cast<F32>((a >> i) & 1);
+			++crossings;
+		}
+	}
+
+	// The density rises into the ground, so the surface faces down its
+	// gradient.
+	F32 normal[3] = { 0.0f, 0.0f, 0.0f };
+	for (U32 i = 0; i < 8; ++i) {
+		for (U32 axis = 0; axis < 3; ++axis)
+			normal[axis] += ((i >> axis) & 1) ? -corners[i] : corners[i];
+	}
+	F32 length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	if (length < 1e-6f) {
+		normal[0] = 0.0f;
+		normal[1] = 1.0f;
+		normal[2] = 0.0f;
+		length = 1.0f;
+	}
+	for (U32 axis = 0; axis < 3; ++axis)
+		normal[axis] /= length;
+
+	SmoothVertex vertex;
+	vertex.x = static_cast<F32>(x) + position[0] / crossings;
+	vertex.y = static_cast<F32>(y) + position[1] / crossings;
+	vertex.z = static_cast<F32>(z) + position[2] / crossings;
+	if (isSkirtCell(x, y, z)) {
+		vertex.x -= normal[0];
+		vertex.y -= normal[1];
+		vertex.z -= normal[2];
+	}
+	vertex.normalX = packNormal(normal[0]);
+	vertex.normalY = packNormal(normal[1]);
+	vertex.normalZ = packNormal(normal[2]);
+	if (normal[1] > SMOOTH_GRASS_SLOPE)
+		vertex.material = BlockType::GRASS;
+	else if (normal[1] > SMOOTH_DIRT_SLOPE)
+		vertex.material = BlockType::DIRT;
+	else
+		vertex.material = BlockType::STONE;
+
+	vertices.push_back(vertex);
+	return static_cast<U16>(vertices.size() - 1);
+}
+
+void SmoothMesher::buildMesh(const F32 *densities, SmoothMesh &mesh) {
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	U16 cellVertices[SMOOTH_CELL_COUNT * SMOOTH_CELL_COUNT * SMOOTH_CELL_COUNT];
+	const S32 first = -SMOOTH_BORDER;
+	const S32 end = CHUNK_SIZE + SMOOTH_BORDER;
+	for (S32 y = first; y < end; ++y) {
+		for (S32 z = first; z < end; ++z) {
+			for (S32 x = first; x < end; ++x)
+				cellVertices[getCellIndex(x, y, z)] = addCellVertex(densities, x, y, z, mesh.vertices);
+		}
+	}
+
+	// Join up the four cells around every edge the surface crosses. The edge
+	// along axis starts at p, the cells lie behind it on the two other axes.
+	for (U32 axis = 0; axis < 3; ++axis) {
+		const U32 u = (axis + 1) % 3;
+		const U32 v = (axis + 2) % 3;
+		S32 p[3];
+		for (p[1] = first; p[1] <= end; ++p[1]) {
+			for (p[2] = first; p[2] <= end; ++p[2]) {
+				for (p[0] = first; p[0] <= end; ++p[0]) {
+					if (p[axis] == end || p[u] == first || p[v] == first || p[u] == end || p[v] == end)
+						continue;
+
+					S32 q[3] = { p[0], p[1], p[2] };
+					++q[axis];
+					const bool solid = densities[getSampleIndex(p[0], p[1], p[2])] > 0.0f;
+					if (solid == (densities[getSampleIndex(q[0], q[1], q[2])] > 0.0f))
+						continue;
+
+					U16 quad[4];
+					for (U32 i = 0; i < 4; ++i) {
+						S32 c[3] = { p[0], p[1], p[2] };
+						c[u] -= (i == 0 || i == 3) ? 1 : 0;
+						c[v] -= (i == 0 || i == 1) ? 1 : 0;
+						quad[i] = cellVertices[getCellIndex(c[0], c[1], c[2])];
+					}
+
+					// Counter clockwise seen from the air side.
+					static const U32 front[6] = { 0, 1, 2, 0, 2, 3 };
+					static const U32 back[6] = { 0, 2, 1, 0, 3, 2 };
+					const U32 *order = solid ? front : back;
+					for (U32 i = 0; i < 6; ++i)
+						mesh.indices.push_back(quad[order[i]]);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_SMOOTHMESHER_HPP_
+#define _WORLD_SMOOTHMESHER_HPP_
+
+#include <vector>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+/**
+ * Smooth mesh vertex, packed into 16 bytes. Positions are in cells relative
+ * to the origin of the node the mesh belongs to.
+ */
+struct SmoothVertex {
+	F32 x;
+	F32 y;
+	F32 z;
+	S8 normalX;
+	S8 normalY;
+	S8 normalZ;
+	U8 material;
+};
+
+/**
+ * CPU side mesh of a smooth terrain node, an indexed triangle list.
+ */
+struct SmoothMesh {
+	std::vector<SmoothVertex> vertices;
+	std::vector<U16> indices;
+
+	/**
+	 * Changes every time the mesh is rebuilt, see ChunkMesh::version.
+	 */
+	U32 version;
+
+	U32 getTriangleCount() const {
+		return static_cast<U32>(indices.size() / 3);
+	}
+
+	bool isEmpty() const {
+		return indices.empty();
+	}
+};
+
+/**
+ * Cells sampled around a node on every side. The first ring overlaps the
+ * neighbouring nodes so that nodes of the same level meet without a seam, the
+ * outer ring is pushed into the ground as a skirt that covers the cracks
+ * against nodes of other levels.
+ */
+#define SMOOTH_BORDER 2
+
+/**
+ * Edge length of the density grid the mesher reads, one sample per cell
+ * corner of the CHUNK_SIZE cells of a node and its border.
+ */
+#define SMOOTH_GRID_SIZE (CHUNK_SIZE + SMOOTH_BORDER * 2 + 1)
+#define SMOOTH_GRID_VOLUME (SMOOTH_GRID_SIZE * SMOOTH_GRID_SIZE * SMOOTH_GRID_SIZE)
+
+namespace SmoothMesher {
+	/**
+	 * Extracts the surface where the densities cross zero with Surface Nets.
+	 * Every cell the surface passes through gets one vertex at the average of
+	 * its edge crossings, and every grid edge with a sign change is joined up
+	 * as a quad between the four cells around it.
+	 */
+	void buildMesh(const F32 *densities, SmoothMesh &mesh);
+
+	/**
+	 * Index of the sample at the cell corner x, y, z, which range from
+	 * -SMOOTH_BORDER to CHUNK_SIZE + SMOOTH_BORDER.
+	 */
+	inline U32 getSampleIndex(S32 x, S32 y, S32 z) {
+		return static_cast<U32>(((y + SMOOTH_BORDER) * SMOOTH_GRID_SIZE + (z + SMOOTH_BORDER)) * SMOOTH_GRID_SIZE + (x + SMOOTH_BORDER));
+	}
+}
+
+#endif // _WORLD_SMOOTHMESHER_HPP_
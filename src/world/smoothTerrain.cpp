@@ -0,0 +1,231 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include "world/smoothTerrain.hpp"
+#include "core/threadPool.hpp"
+#include "world/terrainGenerator.hpp"
+#include "world/world.hpp"
+
+// Smooth meshes take a lot longer to build than they take memory, so they
+// are kept around for longer than the voxel nodes.
+#define SMOOTH_NODE_LIFETIME 600
+
+SmoothTerrain::SmoothTerrain(World *world) {
+	mWorld = world;
+	mViewDistance = 0.0f;
+	mFrame = 0;
+	mMeshVersion = 0;
+	mBuildsLeft = 0;
+}
+
+SmoothTerrain::~SmoothTerrain() {
+	clearNodes();
+}
+
+void SmoothTerrain::setViewDistance(F32 distance) {
+	mViewDistance = distance;
+	if (mViewDistance <= 0.0f) {
+		mSelectedNodes.clear();
+		clearNodes();
+	}
+}
+
+void SmoothTerrain::update(const glm::vec3 &cameraPosition, U32 maxBuilds) {
+	mSelectedNodes.clear();
+	if (mViewDistance <= 0.0f || mWorld->getTerrainGenerator() == nullptr)
+		return;
+
+	++mFrame;
+	mBuildsLeft = maxBuilds;
+
+	// Start from the coarsest nodes within the view distance that the surface
+	// can pass through.
+	F32 minY, maxY;
+	TerrainGenerator::getSurfaceRange(minY, maxY);
+	const U32 rootLevel = SMOOTH_LEVEL_COUNT - 1;
+	const S32 rootChunks = 1 << rootLevel;
+	const F32 rootSize = static_cast<F32>(CHUNK_SIZE << rootLevel);
+	const glm::ivec3 first(floorf((cameraPosition.x - mViewDistance) / rootSize), floorf(minY / rootSize), floorf((cameraPosition.z - mViewDistance) / rootSize));
+	const glm::ivec3 last(floorf((cameraPosition.x + mViewDistance) / rootSize), floorf(maxY / rootSize), floorf((cameraPosition.z + mViewDistance) / rootSize));
+	for (S32 y = first.y; y <= last.y; ++y) {
+		for (S32 z = first.z; z <= last.z; ++z) {
+			for (S32 x = first.x; x <= last.x; ++x) {
+				LodKey root;
+				root.origin = { x * rootChunks, y * rootChunks, z * rootChunks };
+				root.level = rootLevel;
+				selectNode(root, cameraPosition);
+			}
+		}
+	}
+
+	for (auto it = mNodes.begin(); it != mNodes.end();) {
+		if (mFrame - it->second.lastSelected > SMOOTH_NODE_LIFETIME) {
+			delete it->second.mesh;
+			it = mNodes.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void SmoothTerrain::sampleDensities(const LodKey &key, F32 *densities) const {
+	const TerrainGenerator *generator = mWorld->getTerrainGenerator();
+	const F32 cell = static_cast<F32>(1 << key.level);
+	const glm::vec3 origin = glm::vec3(key.origin.x, key.origin.y, key.origin.z) * static_cast<F32>(CHUNK_SIZE);
+
+	gThreadPool.parallelFor(SMOOTH_GRID_SIZE * SMOOTH_GRID_SIZE, SMOOTH_GRID_SIZE, [&](U32 start, U32 end) {
+		F32 column[SMOOTH_GRID_SIZE];
+		for (U32 i = start; i < end; ++i) {
+			const S32 x = static_cast<S32>(i % SMOOTH_GRID_SIZE) - SMOOTH_BORDER;
+			const S32 z = static_cast<S32>(i / SMOOTH_GRID_SIZE) - SMOOTH_BORDER;
+			generator->getDensityColumn(origin.x + x * cell, origin.z + z * cell, origin.y - SMOOTH_BORDER * cell, cell, SMOOTH_GRID_SIZE, column);
+			for (S32 y = 0; y < SMOOTH_GRID_SIZE; ++y)
+				densities[SmoothMesher::getSampleIndex(x, y - SMOOTH_BORDER, z)] = column[y];
+		}
+	});
+}
+
+void SmoothTerrain::selectNode(const LodKey &key, const glm::vec3 &cameraPosition) {
+	if (!isInRange(key, cameraPosition))
+		return;
+
+	LodKey children[8];
+	const S32 half = 1 << (key.level - 1);
+	for (S32 i = 0; i < 8; ++i) {
+		children[i].origin.x = key.origin.x + ((i & 1) ? half : 0);
+		children[i].origin.y = key.origin.y + ((i & 2) ? half : 0);
+		children[i].origin.z = key.origin.z + ((i & 4) ? half : 0);
+		children[i].level = key.level - 1;
+	}
+
+	// The voxel terrain draws its roots itself.
+	const U32 minLevel = LOD_LEVEL_COUNT - 1;
+	if (overlapsVoxelTerrain(key)) {
+		if (key.level > minLevel) {
+			for (const LodKey &child : children)
+				selectNode(child, cameraPosition);
+		}
+		return;
+	}
+
+	const F32 size = static_cast<F32>(CHUNK_SIZE << key.level);
+	const glm::vec3 min = glm::vec3(key.origin.x, key.origin.y, key.origin.z) * static_cast<F32>(CHUNK_SIZE);
+	const glm::vec3 closest = glm::clamp(cameraPosition, min, min + glm::vec3(size));
+	const bool split = key.level > minLevel && glm::length(closest - cameraPosition) < LOD_SPLIT_DISTANCE * size;
+
+	if (!split) {
+		if (prepareNode(key))
+			addSelected(key);
+		return;
+	}
+
+	// Keep drawing this node until all of the children replacing it are built.
+	bool childrenBuilt = true;
+	for (const LodKey &child : children) {
+		if (isInRange(child, cameraPosition) && !isBuilt(child))
+			childrenBuilt = false;
+	}
+	if (!childrenBuilt && prepareNode(key)) {
+		for (const LodKey &child : children) {
+			if (isInRange(child, cameraPosition))
+				prepareNode(child);
+		}
+		addSelected(key);
+		return;
+	}
+
+	for (const LodKey &child : children)
+		selectNode(child, cameraPosition);
+}
+
+bool SmoothTerrain::isInRange(const LodKey &key, const glm::vec3 &cameraPosition) const {
+	F32 minY, maxY;
+	TerrainGenerator::getSurfaceRange(minY, maxY);
+
+	const F32 size = static_cast<F32>(CHUNK_SIZE << key.level);
+	const glm::vec3 min = glm::vec3(key.origin.x, key.origin.y, key.origin.z) * static_cast<F32>(CHUNK_SIZE);
+	if (min.y > maxY || min.y + size < minY)
+		return false;
+
+	const glm::vec3 closest = glm::clamp(cameraPosition, min, min + glm::vec3(size));
+	return glm::length(closest - cameraPosition) <= mViewDistance;
+}
+
+bool SmoothTerrain::overlapsVoxelTerrain(const LodKey &key) const {
+	const S32 chunks = 1 << key.level;
+	for (const LodKey &root : mWorld->getLodTerrain().getRoots()) {
+		if (root.origin.x >= key.origin.x && root.origin.x < key.origin.x + chunks &&
+			root.origin.y >= key.origin.y && root.origin.y < key.origin.y + chunks &&
+			root.origin.z >= key.origin.z && root.origin.z < key.origin.z + chunks)
+			return true;
+	}
+	return false;
+}
+
+bool SmoothTerrain::isBuilt(const LodKey &key) const {
+	auto pos = mNodes.find(key);
+	return pos != mNodes.end() && pos->second.mesh != nullptr;
+}
+
+bool SmoothTerrain::prepareNode(const LodKey &key) {
+	Node &node = mNodes[key];
+	node.lastSelected = mFrame;
+	if (node.mesh != nullptr)
+		return true;
+
+	if (mBuildsLeft == 0)
+		return false;
+	--mBuildsLeft;
+
+	mDensities.resize(SMOOTH_GRID_VOLUME);
+	sampleDensities(key, mDensities.data());
+	node.mesh = new SmoothMesh();
+	SmoothMesher::buildMesh(mDensities.data(), *node.mesh);
+	node.mesh->version = ++mMeshVersion;
+	return true;
+}
+
+void SmoothTerrain::addSelected(const LodKey &key) {
+	const SmoothMesh *mesh = mNodes[key].mesh;
+	if (mesh->isEmpty())
+		return;
+
+	SmoothNode selected;
+	selected.key = key;
+	selected.mesh = mesh;
+	mSelectedNodes.push_back(selected);
+}
+
+void SmoothTerrain::clearNodes() {
+	for (auto &pair : mNodes)
+		delete pair.second.mesh;
+	mNodes.clear();
+}
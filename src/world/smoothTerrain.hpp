@@ -0,0 +1,124 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_SMOOTHTERRAIN_HPP_
+#define _WORLD_SMOOTHTERRAIN_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "world/lodTerrain.hpp"
+#include "world/smoothMesher.hpp"
+
+class World;
+
+/**
+ * Smooth nodes use the levels from the coarsest voxel level up to this one,
+ * the largest covering 2048 blocks.
+ */
+#define SMOOTH_LEVEL_COUNT 8
+
+struct SmoothNode {
+	LodKey key;
+	const SmoothMesh *mesh;
+};
+
+/**
+ * Draws the terrain beyond the loaded chunks for long view distances. Nodes
+ * are meshed straight from the density field of the terrain generator with
+ * the SmoothMesher, so they don't need any chunks loaded and their cost is
+ * set by the sample count rather than the area covered.
+ *
+ * Nodes are picked from an octree of LodKeys the same way as LodTerrain picks
+ * its levels, starting at the coarsest level and splitting while the camera is
+ * close. Nodes overlapping the voxel terrain's roots are split down until they
+ * are replaced by it. A node is drawn in place of its children until all of
+ * them are built.
+ */
+class SmoothTerrain {
+public:
+	SmoothTerrain(World *world);
+	~SmoothTerrain();
+
+	/**
+	 * Distance up to which nodes are drawn. Zero, the default, turns the
+	 * smooth terrain off.
+	 */
+	void setViewDistance(F32 distance);
+
+	F32 getViewDistance() const {
+		return mViewDistance;
+	}
+
+	/**
+	 * Selects the nodes for the camera position and builds up to maxBuilds
+	 * missing node meshes. Does nothing without a terrain generator.
+	 */
+	void update(const glm::vec3 &cameraPosition, U32 maxBuilds);
+
+	/**
+	 * Non empty nodes selected by the last update.
+	 */
+	const std::vector<SmoothNode>& getNodes() const {
+		return mSelectedNodes;
+	}
+
+	/**
+	 * Samples the generator's densities at the cell corners of the node and
+	 * its border, split across the thread pool.
+	 */
+	void sampleDensities(const LodKey &key, F32 *densities) const;
+
+private:
+	struct Node {
+		SmoothMesh *mesh;
+		U64 lastSelected;
+	};
+
+	World *mWorld;
+	F32 mViewDistance;
+	std::unordered_map<LodKey, Node, LodKeyHash> mNodes;
+	std::vector<SmoothNode> mSelectedNodes;
+	U64 mFrame;
+	U32 mMeshVersion;
+	U32 mBuildsLeft;
+	std::vector<F32> mDensities;
+
+	void selectNode(const LodKey &key, const glm::vec3 &cameraPosition);
+	bool isInRange(const LodKey &key, const glm::vec3 &cameraPosition) const;
+	bool overlapsVoxelTerrain(const LodKey &key) const;
+	bool isBuilt(const LodKey &key) const;
+	bool prepareNode(const LodKey &key);
+	void addSelected(const LodKey &key);
+	void clearNodes();
+};
+
+#endif // _WORLD_SMOOTHTERRAIN_HPP_
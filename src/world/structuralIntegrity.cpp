@@ -0,0 +1,431 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "world/structuralIntegrity.hpp"
+#include "world/world.hpp"
+
+// The block above goes first and the one below last, so that the fill pops
+// the block below first and heads for the ground.
+static const glm::ivec3 sNeighborOffsets[FACE_COUNT] = {
+	glm::ivec3(0, 1, 0),
+	glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0),
+	glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1),
+	glm::ivec3(0, -1, 0)
+};
+
+static glm::ivec3 getWorldPosition(const ChunkCoord &coord, U32 index) {
+	return glm::ivec3(coord.x, coord.y, coord.z) * CHUNK_SIZE + glm::ivec3(index & (CHUNK_SIZE - 1), index >> (CHUNK_SHIFT * 2), (index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1));
+}
+
+static U32 getLocalIndex(const glm::ivec3 &position) {
+	const glm::ivec3 local = World::getLocalPosition(position);
+	return Chunk::getIndex(local.x, local.y, local.z);
+}
+
+StructuralIntegrity::StructuralIntegrity(World *world) {
+	mWorld = world;
+	mSeedCursor = 0;
+	mFill.active = false;
+	mFill.restart = false;
+	mFill.anchored = false;
+	mVisitedUsed = 0;
+	mLastVisited = nullptr;
+	mNextStructureId = 0;
+	mMoving = false;
+	memset(&mFrameStats, 0, sizeof(mFrameStats));
+	memset(&mTotalStats, 0, sizeof(mTotalStats));
+	mFrameCount = 0;
+}
+
+StructuralIntegrity::~StructuralIntegrity() {
+	for (VisitedChunk *visited : mVisitedPool)
+		delete visited;
+}
+
+void StructuralIntegrity::onBlockChanged(const Chunk *chunk, U32 index, BlockID oldBlock) {
+	// The falling structures move their own blocks.
+	if (mMoving)
+		return;
+
+	const BlockID block = chunk->getBlockAtIndex(index);
+	if (isSolidBlock(oldBlock) == isSolidBlock(block))
+		return;
+
+	const glm::ivec3 position = getWorldPosition(chunk->getCoord(), index);
+	if (isSolidBlock(block)) {
+		// A block added next to a part the fill has been through could be its
+		// way to the ground.
+		if (!mFill.active || mFill.restart)
+			return;
+		for (U32 i = 0; i < FACE_COUNT; ++i) {
+			if (!isVisited(position + sNeighborOffsets[i]))
+				continue;
+			VisitedChunk *visited = getVisitedChunk(chunk->getCoord());
+			visited->bits[index >> 6] |= 1ULL << (index & 63);
+			mFill.stack.push_back({ position, block });
+			break;
+		}
+		return;
+	}
+
+	// What was supported through the block before may not be anymore.
+	mFill.anchored = false;
+	if (mFill.active && isVisited(position))
+		mFill.restart = true;
+	for (U32 i = 0; i < FACE_COUNT; ++i)
+		mSeeds.push_back(position + sNeighborOffsets[i]);
+}
+
+void StructuralIntegrity::removeChunk(const ChunkCoord &coord) {
+	size_t i = 0;
+	while (i < mStructures.size()) {
+		bool inside = false;
+		for (const StructureCell &cell : mStructures[i].cells) {
+			if (World::getChunkCoord(cell.position) == coord) {
+				inside = true;
+				break;
+			}
+		}
+		if (!inside) {
+			++i;
+			continue;
+		}
+
+		landStructure(mStructures[i]);
+		mStructures[i] = std::move(mStructures.back());
+		mStructures.pop_back();
+	}
+
+	// The visited chunks may point at the chunk.
+	clearVisited();
+	mFill.anchored = false;
+	if (mFill.active)
+		mFill.restart = true;
+}
+
+void StructuralIntegrity::update(F64 delta) {
+	if (mFrameStats.visitedCells > 0 || mFrameStats.movedBlocks > 0)
+		++mFrameCount;
+	memset(&mFrameStats, 0, sizeof(mFrameStats));
+	if (isIdle())
+		return;
+
+	const auto start = std::chrono::steady_clock::now();
+	U32 budget = STRUCTURE_VISIT_BUDGET;
+	while (budget > 0 && (mFill.active || startFill())) {
+		bool anchored;
+		if (!continueFill(budget, anchored))
+			break;
+		finishFill(anchored);
+	}
+	mFrameStats.visitedCells += STRUCTURE_VISIT_BUDGET - budget;
+	mTotalStats.visitedCells += STRUCTURE_VISIT_BUDGET - budget;
+
+	updateStructures(delta);
+
+	const F64 seconds = std::chrono::duration<F64>(std::chrono::steady_clock::now() - start).count();
+	mFrameStats.seconds += seconds;
+	mTotalStats.seconds += seconds;
+}
+
+void StructuralIntegrity::printStats() const {
+	const F64 frames = mFrameCount > 0 ? static_cast<F64>(mFrameCount) : 1.0;
+	printf("Structural integrity: %llu fills over %llu frames visited %llu cells, %llu islands fell and %llu landed\n", static_cast<unsigned long long>(mTotalStats.fills), static_cast<unsigned long long>(mFrameCount), static_cast<unsigned long long>(mTotalStats.visitedCells), static_cast<unsigned long long>(mTotalStats.islands), static_cast<unsigned long long>(mTotalStats.landed));
+	printf("   %.1f cells visited, %.1f blocks moved and %.3f ms per frame\n", mTotalStats.visitedCells / frames, mTotalStats.movedBlocks / frames, mTotalStats.seconds * 1000.0 / frames);
+}
+
+StructuralIntegrity::VisitedChunk* StructuralIntegrity::getVisitedChunk(const ChunkCoord &coord) {
+	if (mLastVisited != nullptr && mLastVisitedCoord == coord)
+		return mLastVisited;
+
+	VisitedChunk *&visited = mVisitedChunks[coord];
+	if (visited == nullptr) {
+		const Chunk *chunk = mWorld->getChunk(coord);
+		if (chunk == nullptr) {
+			mVisitedChunks.erase(coord);
+			return nullptr;
+		}
+
+		if (mVisitedUsed == mVisitedPool.size())
+			mVisitedPool.push_back(new VisitedChunk);
+		visited = mVisitedPool[mVisitedUsed++];
+		visited->chunk = chunk;
+		memset(visited->bits, 0, sizeof(visited->bits));
+	}
+	mLastVisitedCoord = coord;
+	mLastVisited = visited;
+	return visited;
+}
+
+void StructuralIntegrity::clearVisited() {
+	mVisitedChunks.clear();
+	mVisitedUsed = 0;
+	mLastVisited = nullptr;
+}
+
+bool StructuralIntegrity::isVisited(const glm::ivec3 &position) const {
+	auto pos = mVisitedChunks.find(World::getChunkCoord(position));
+	if (pos == mVisitedChunks.end())
+		return false;
+
+	const U32 index = getLocalIndex(position);
+	return (pos->second->bits[index >> 6] & (1ULL << (index & 63))) != 0;
+}
+
+bool StructuralIntegrity::isFalling(const glm::ivec3 &position) const {
+	return !mFallingCells.empty() && mFallingCells.find(getCellKey(position)) != mFallingCells.end();
+}
+
+bool StructuralIntegrity::startFill() {
+	while (mSeedCursor < mSeeds.size()) {
+		const glm::ivec3 seed = mSeeds[mSeedCursor++];
+
+		// The last fill went through the block and found support.
+		if (mFill.anchored && isVisited(seed))
+			continue;
+
+		mFill.seed = seed;
+		resetFill();
+		if (mFill.active) {
+			++mFrameStats.fills;
+			++mTotalStats.fills;
+			return true;
+		}
+	}
+	mSeeds.clear();
+	mSeedCursor = 0;
+	return false;
+}
+
+void StructuralIntegrity::resetFill() {
+	clearVisited();
+	mFill.stack.clear();
+	mFill.cells.clear();
+	mFill.active = false;
+	mFill.restart = false;
+	mFill.anchored = false;
+
+	VisitedChunk *visited = getVisitedChunk(World::getChunkCoord(mFill.seed));
+	if (visited == nullptr)
+		return;
+
+	const U32 index = getLocalIndex(mFill.seed);
+	const BlockID block = visited->chunk->getBlockAtIndex(index);
+	if (!isSolidBlock(block) || isFalling(mFill.seed))
+		return;
+
+	visited->bits[index >> 6] |= 1ULL << (index & 63);
+	mFill.stack.push_back({ mFill.seed, block });
+	mFill.active = true;
+}
+
+bool StructuralIntegrity::continueFill(U32 &budget, bool &anchored) {
+	if (mFill.restart) {
+		resetFill();
+		if (!mFill.active) {
+			anchored = true;
+			return true;
+		}
+	}
+
+	while (!mFill.stack.empty()) {
+		if (budget == 0)
+			return false;
+		--budget;
+
+		const StructureCell cell = mFill.stack.back();
+		mFill.stack.pop_back();
+		if (mFill.cells.size() >= STRUCTURE_MAX_ISLAND) {
+			anchored = true;
+			return true;
+		}
+		mFill.cells.push_back(cell);
+
+		for (U32 i = 0; i < FACE_COUNT; ++i) {
+			const glm::ivec3 neighbor = cell.position + sNeighborOffsets[i];
+			VisitedChunk *visited = getVisitedChunk(World::getChunkCoord(neighbor));
+			if (visited == nullptr) {
+				anchored = true;
+				return true;
+			}
+
+			const U32 index = getLocalIndex(neighbor);
+			const U64 bit = 1ULL << (index & 63);
+			if (visited->bits[index >> 6] & bit)
+				continue;
+			const BlockID block = visited->chunk->getBlockAtIndex(index);
+			if (!isSolidBlock(block) || isFalling(neighbor))
+				continue;
+
+			visited->bits[index >> 6] |= bit;
+			mFill.stack.push_back({ neighbor, block });
+		}
+	}
+	anchored = false;
+	return true;
+}
+
+void StructuralIntegrity::finishFill(bool anchored) {
+	mFill.active = false;
+	mFill.anchored = anchored;
+	if (anchored) {
+		mFill.cells.clear();
+		return;
+	}
+
+	FallingStructure structure;
+	structure.id = mNextStructureId++;
+	structure.cells.swap(mFill.cells);
+	structure.velocity = 0.0f;
+	structure.offset = 0.0f;
+	for (const StructureCell &cell : structure.cells)
+		mFallingCells[getCellKey(cell.position)] = structure.id;
+	mStructures.push_back(std::move(structure));
+	++mFrameStats.islands;
+	++mTotalStats.islands;
+}
+
+void StructuralIntegrity::updateStructures(F64 delta) {
+	const F32 dt = static_cast<F32>(delta);
+	U32 moved = 0;
+	size_t i = 0;
+	while (i < mStructures.size()) {
+		FallingStructure &structure = mStructures[i];
+		structure.velocity = std::min(structure.velocity + STRUCTURE_GRAVITY * dt, STRUCTURE_TERMINAL_VELOCITY);
+		structure.offset += structure.velocity * dt;
+
+		bool landed = false;
+		while (structure.offset >= 1.0f) {
+			// Out of moves for this update, carry on from here in the next.
+			if (moved >= STRUCTURE_MOVE_BUDGET) {
+				structure.offset = 1.0f;
+				break;
+			}
+
+			bool blocked;
+			if (!moveStructure(structure, blocked)) {
+				// Resting on another structure until that one moves on.
+				if (blocked) {
+					structure.velocity = 0.0f;
+					structure.offset = 0.0f;
+				} else {
+					landed = true;
+				}
+				break;
+			}
+			moved += static_cast<U32>(structure.cells.size());
+			structure.offset -= 1.0f;
+		}
+
+		if (!landed) {
+			++i;
+			continue;
+		}
+
+		landStructure(structure);
+		mStructures[i] = std::move(mStructures.back());
+		mStructures.pop_back();
+	}
+	mFrameStats.movedBlocks += moved;
+	mTotalStats.movedBlocks += moved;
+}
+
+bool StructuralIntegrity::moveStructure(FallingStructure &structure, bool &blocked) {
+	blocked = false;
+
+	// Blocks that were changed since, by an edit or sand falling on its own,
+	// are no longer part of the structure.
+	size_t count = 0;
+	for (const StructureCell &cell : structure.cells) {
+		if (mWorld->getBlock(cell.position) == cell.block) {
+			structure.cells[count++] = cell;
+			continue;
+		}
+
+		auto pos = mFallingCells.find(getCellKey(cell.position));
+		if (pos != mFallingCells.end() && pos->second == structure.id)
+			mFallingCells.erase(pos);
+	}
+	structure.cells.resize(count);
+	if (count == 0)
+		return false;
+
+	for (const StructureCell &cell : structure.cells) {
+		const glm::ivec3 below = cell.position - glm::ivec3(0, 1, 0);
+		auto pos = mFallingCells.find(getCellKey(below));
+		if (pos != mFallingCells.end()) {
+			if (pos->second == structure.id)
+				continue;
+			blocked = true;
+			return false;
+		}
+
+		// Chunks that aren't loaded read as air.
+		if (mWorld->getChunk(World::getChunkCoord(below)) == nullptr || isSolidBlock(mWorld->getBlock(below)))
+			return false;
+	}
+
+	// Clear every block first, the structure moves into its own cells.
+	mMoving = true;
+	for (const StructureCell &cell : structure.cells) {
+		mFallingCells.erase(getCellKey(cell.position));
+		mWorld->setBlock(cell.position, BlockType::AIR);
+	}
+	for (StructureCell &cell : structure.cells) {
+		cell.position.y -= 1;
+		mWorld->setBlock(cell.position, cell.block);
+		mFallingCells[getCellKey(cell.position)] = structure.id;
+	}
+	mMoving = false;
+	return true;
+}
+
+void StructuralIntegrity::landStructure(FallingStructure &structure) {
+	for (const StructureCell &cell : structure.cells) {
+		auto pos = mFallingCells.find(getCellKey(cell.position));
+		if (pos != mFallingCells.end() && pos->second == structure.id)
+			mFallingCells.erase(pos);
+	}
+
+	// The landed blocks are solid ground the fill hasn't seen.
+	if (mFill.active)
+		mFill.restart = true;
+	++mFrameStats.landed;
+	++mTotalStats.landed;
+}
+
+U64 StructuralIntegrity::getCellKey(const glm::ivec3 &position) {
+	const U64 mask = (1ULL << 21) - 1;
+	return ((static_cast<U64>(position.x) & mask) << 42) | ((static_cast<U64>(position.y) & mask) << 21) | (static_cast<U64>(position.z) & mask);
+}
@@ -0,0 +1,209 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_STRUCTURALINTEGRITY_HPP_
+#define _WORLD_STRUCTURALINTEGRITY_HPP_
+
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+class World;
+
+/**
+ * Cells the support search visits and blocks the falling structures move per
+ * update. A search that runs out is carried on in the next update.
+ */
+#define STRUCTURE_VISIT_BUDGET 16384
+#define STRUCTURE_MOVE_BUDGET 8192
+
+/**
+ * Islands with more blocks than this are taken as supported, so the search
+ * never walks the whole terrain.
+ */
+#define STRUCTURE_MAX_ISLAND 32768
+
+// Blocks per second squared and blocks per second.
+#define STRUCTURE_GRAVITY 20.0f
+#define STRUCTURE_TERMINAL_VELOCITY 40.0f
+
+/**
+ * Makes the solid blocks that lost their support fall.
+ *
+ * Removing a solid block queues its six neighbours. For each of them a flood
+ * fill through the solid blocks looks for support, trying the block below
+ * first so that it reaches the ground of the terrain in about as many steps
+ * as the block is high. Reaching a chunk that is not loaded counts as
+ * support, as does growing past STRUCTURE_MAX_ISLAND. Otherwise the blocks
+ * the fill found are a disconnected island and become a falling structure.
+ *
+ * A falling structure keeps its blocks in the world and moves them down a
+ * cell at a time as its velocity carries it, as one rigid body, until a block
+ * of it would move into a solid block or a chunk that is not loaded. The
+ * fills step around falling blocks.
+ *
+ * The fill work and the moved blocks are capped per update, so a large
+ * collapse is spread over the frames instead of stalling the edit.
+ */
+class StructuralIntegrity {
+public:
+	struct Stats {
+		U64 fills;
+		U64 visitedCells;
+		U64 islands;
+		U64 movedBlocks;
+		U64 landed;
+		F64 seconds;
+	};
+
+	StructuralIntegrity(World *world);
+	~StructuralIntegrity();
+
+	/**
+	 * Queues the support search around a solid block that was removed and
+	 * keeps a search that is underway up to date with the change.
+	 */
+	void onBlockChanged(const Chunk *chunk, U32 index, BlockID oldBlock);
+
+	/**
+	 * Lands the structures falling through a chunk that is being unloaded.
+	 */
+	void removeChunk(const ChunkCoord &coord);
+
+	/**
+	 * Carries on the support search and moves the falling structures by
+	 * delta more seconds, and starts the stats of a new frame.
+	 */
+	void update(F64 delta);
+
+	/**
+	 * True when there is no search queued and nothing is falling.
+	 */
+	bool isIdle() const {
+		return !mFill.active && mSeedCursor == mSeeds.size() && mStructures.empty();
+	}
+
+	U32 getFallingCount() const {
+		return static_cast<U32>(mStructures.size());
+	}
+
+	U32 getFallingBlockCount() const {
+		return static_cast<U32>(mFallingCells.size());
+	}
+
+	const Stats& getFrameStats() const {
+		return mFrameStats;
+	}
+
+	const Stats& getTotalStats() const {
+		return mTotalStats;
+	}
+
+	U64 getFrameCount() const {
+		return mFrameCount;
+	}
+
+	void printStats() const;
+
+private:
+	struct StructureCell {
+		glm::ivec3 position;
+		BlockID block;
+	};
+
+	struct FallingStructure {
+		U32 id;
+		std::vector<StructureCell> cells;
+		F32 velocity;
+
+		// Distance fallen since the last move, in blocks.
+		F32 offset;
+	};
+
+	struct Fill {
+		glm::ivec3 seed;
+		std::vector<StructureCell> stack;
+		std::vector<StructureCell> cells;
+		bool active;
+		bool restart;
+
+		/**
+		 * Whether the last fill that finished found support, while nothing was
+		 * removed since. Queued seeds it went through need no fill of their own.
+		 */
+		bool anchored;
+	};
+
+	struct VisitedChunk {
+		const Chunk *chunk;
+		U64 bits[CHUNK_VOLUME / 64];
+	};
+
+	World *mWorld;
+	std::vector<glm::ivec3> mSeeds;
+	size_t mSeedCursor;
+	Fill mFill;
+
+	// The cells the fill visited, per chunk.
+	std::unordered_map<ChunkCoord, VisitedChunk*, ChunkCoordHash> mVisitedChunks;
+	std::vector<VisitedChunk*> mVisitedPool;
+	size_t mVisitedUsed;
+	ChunkCoord mLastVisitedCoord;
+	VisitedChunk *mLastVisited;
+
+	std::vector<FallingStructure> mStructures;
+	std::unordered_map<U64, U32> mFallingCells;
+	U32 mNextStructureId;
+	bool mMoving;
+
+	Stats mFrameStats;
+	Stats mTotalStats;
+	U64 mFrameCount;
+
+	VisitedChunk* getVisitedChunk(const ChunkCoord &coord);
+	void clearVisited();
+	bool isVisited(const glm::ivec3 &position) const;
+	bool isFalling(const glm::ivec3 &position) const;
+
+	bool startFill();
+	void resetFill();
+	bool continueFill(U32 &budget, bool &anchored);
+	void finishFill(bool anchored);
+
+	void updateStructures(F64 delta);
+	bool moveStructure(FallingStructure &structure, bool &blocked);
+	void landStructure(FallingStructure &structure);
+
+	static U64 getCellKey(const glm::ivec3 &position);
+};
+
+#endif // _WORLD_STRUCTURALINTEGRITY_HPP_
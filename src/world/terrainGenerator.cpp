@@ -0,0 +1,140 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <open-simplex-noise.h>
+#include "world/terrainGenerator.hpp"
+
+#define TERRAIN_BASE_HEIGHT 24.0f
+
+// Amplitudes of the height and overhang noise.
+#define TERRAIN_HILL_AMPLITUDE 20.0f
+#define TERRAIN_DETAIL_AMPLITUDE 4.0f
+#define TERRAIN_OVERHANG_AMPLITUDE 6.0f
+
+// Open air near the surface below this height is filled with water. Caves
+// deeper than the overhangs reach stay dry.
+#define TERRAIN_SEA_LEVEL 16
+
+// How many blocks of dirt lie under the grass before we hit stone.
+#define TERRAIN_DIRT_DEPTH 3
+
+TerrainGenerator::TerrainGenerator(S64 seed) {
+	open_simplex_noise(seed, &mNoise);
+}
+
+TerrainGenerator::~TerrainGenerator() {
+	open_simplex_noise_free(mNoise);
+}
+
+F32 TerrainGenerator::getHeight(F32 x, F32 z) const {
+	F64 hills = open_simplex_noise2(mNoise, x / 96.0, z / 96.0) * TERRAIN_HILL_AMPLITUDE;
+	F64 detail = open_simplex_noise2(mNoise, x / 24.0, z / 24.0) * TERRAIN_DETAIL_AMPLITUDE;
+	return TERRAIN_BASE_HEIGHT + static_cast<F32>(hills + detail);
+}
+
+F32 TerrainGenerator::getDensity(F32 x, F32 y, F32 z) const {
+	return sampleDensity(getHeight(x, z), x, y, z);
+}
+
+void TerrainGenerator::getDensityColumn(F32 x, F32 z, F32 y, F32 step, U32 count, F32 *densities) const {
+	const F32 height = getHeight(x, z);
+	for (U32 i = 0; i < count; ++i)
+		densities[i] = sampleDensity(height, x, y + step * i, z);
+}
+
+void TerrainGenerator::getSurfaceRange(F32 &minY, F32 &maxY) {
+	const F32 range = TERRAIN_HILL_AMPLITUDE + TERRAIN_DETAIL_AMPLITUDE + TERRAIN_OVERHANG_AMPLITUDE;
+	minY = TERRAIN_BASE_HEIGHT - range;
+	maxY = TERRAIN_BASE_HEIGHT + range;
+}
+
+F32 TerrainGenerator::sampleDensity(F32 height, F32 x, F32 y, F32 z) const {
+	F32 density = height - y;
+
+	// Overhangs
+	density += static_cast<F32>(open_simplex_noise3(mNoise, x / 32.0, y / 32.0, z / 32.0)) * TERRAIN_OVERHANG_AMPLITUDE;
+
+	// Carve caves out of the tube where the noise crosses zero.
+	F32 cave = static_cast<F32>(open_simplex_noise3(mNoise, x / 48.0 + 1000.0, y / 24.0, z / 48.0));
+	if (cave > -0.08f && cave < 0.08f && y > 2.0f)
+		density = -1.0f;
+
+	return density;
+}
+
+void TerrainGenerator::generateChunk(Chunk *chunk) const {
+	const ChunkCoord &coord = chunk->getCoord();
+	const S32 baseX = coord.x * CHUNK_SIZE;
+	const S32 baseY = coord.y * CHUNK_SIZE;
+	const S32 baseZ = coord.z * CHUNK_SIZE;
+
+	// Sample each column up to the dirt depth above the chunk, so that we know
+	// how far below the surface every voxel is.
+	const S32 columnHeight = CHUNK_SIZE + TERRAIN_DIRT_DEPTH;
+	F32 column[CHUNK_SIZE + TERRAIN_DIRT_DEPTH];
+
+	for (S32 z = 0; z < CHUNK_SIZE; ++z) {
+		for (S32 x = 0; x < CHUNK_SIZE; ++x) {
+			const F32 worldX = static_cast<F32>(baseX + x);
+			const F32 worldZ = static_cast<F32>(baseZ + z);
+			const F32 height = getHeight(worldX, worldZ);
+
+			for (S32 y = 0; y < columnHeight; ++y)
+				column[y] = sampleDensity(height, worldX, static_cast<F32>(baseY + y), worldZ);
+
+			for (S32 y = 0; y < CHUNK_SIZE; ++y) {
+				const S32 worldY = baseY + y;
+				if (column[y] <= 0.0f) {
+					if (worldY <= TERRAIN_SEA_LEVEL && worldY > height - TERRAIN_OVERHANG_AMPLITUDE)
+						chunk->setBlock(x, y, z, BlockType::WATER);
+					continue;
+				}
+
+				BlockID block = BlockType::STONE;
+				if (column[y + 1] <= 0.0f) {
+					block = BlockType::GRASS;
+				} else {
+					for (S32 i = 2; i <= TERRAIN_DIRT_DEPTH; ++i) {
+						if (column[y + i] <= 0.0f) {
+							block = BlockType::DIRT;
+							break;
+						}
+					}
+				}
+
+				// Beaches and the beds of the lakes, but not the floors of the
+				// caves further down.
+				if (block != BlockType::STONE && worldY <= TERRAIN_SEA_LEVEL + 1 && worldY > height - TERRAIN_OVERHANG_AMPLITUDE - TERRAIN_DIRT_DEPTH)
+					block = BlockType::SAND;
+				chunk->setBlock(x, y, z, block);
+			}
+		}
+	}
+}
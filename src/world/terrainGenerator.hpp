@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_TERRAINGENERATOR_HPP_
+#define _WORLD_TERRAINGENERATOR_HPP_
+
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+
+struct osn_context;
+
+class TerrainGenerator {
+public:
+	TerrainGenerator(S64 seed);
+	~TerrainGenerator();
+
+	/**
+	 * Samples the terrain density field at a point in world space. Anything
+	 * with a density greater than zero is solid.
+	 */
+	F32 getDensity(F32 x, F32 y, F32 z) const;
+
+	/**
+	 * Samples count densities of the column at x, z starting at y and going up
+	 * by step, sharing the height lookup between them.
+	 */
+	void getDensityColumn(F32 x, F32 z, F32 y, F32 step, U32 count, F32 *densities) const;
+
+	/**
+	 * The band of heights the surface can lie in. Everything below is solid
+	 * apart from caves and everything above is air.
+	 */
+	static void getSurfaceRange(F32 &minY, F32 &maxY);
+
+	void generateChunk(Chunk *chunk) const;
+
+private:
+	osn_context *mNoise;
+
+	F32 getHeight(F32 x, F32 z) const;
+	F32 sampleDensity(F32 height, F32 x, F32 y, F32 z) const;
+};
+
+#endif // _WORLD_TERRAINGENERATOR_HPP_
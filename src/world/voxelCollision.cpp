@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include "world/voxelCollision.hpp"
+#include "world/world.hpp"
+
+// Boxes resting against a face can end up a rounding error inside of the
+// voxel. Shrink the overlap test by this much so they don't snag on it.
+#define COLLISION_EPSILON 0.0001f
+
+namespace {
+	/**
+	 * Looks up voxels while remembering the last chunk, since neighbouring
+	 * lookups nearly always land in the same chunk.
+	 */
+	class BlockSampler {
+	public:
+		BlockSampler(const World *world) : mWorld(world), mChunk(nullptr), mValid(false) {}
+
+		bool isSolid(S32 x, S32 y, S32 z) {
+			glm::ivec3 pos(x, y, z);
+			ChunkCoord coord = World::getChunkCoord(pos);
+			if (!mValid || coord != mCoord) {
+				mCoord = coord;
+				mChunk = mWorld->getChunk(coord);
+				mValid = true;
+			}
+
+			if (mChunk == nullptr)
+				return true;
+
+			glm::ivec3 local = World::getLocalPosition(pos);
+			return isSolidBlock(mChunk->getBlock(local.x, local.y, local.z));
+		}
+
+	private:
+		const World *mWorld;
+		const Chunk *mChunk;
+		ChunkCoord mCoord;
+		bool mValid;
+	};
+
+	/**
+	 * Clips the motion of the box along one axis against the solid voxels in
+	 * its path. The layers of voxels are walked from the box outwards so we
+	 * can stop at the first layer that blocks the box.
+	 */
+	F32 clipAxis(BlockSampler &sampler, const AABB &box, S32 axis, F32 motion) {
+		if (motion == 0.0f)
+			return 0.0f;
+
+		const S32 u = (axis + 1) % 3;
+		const S32 v = (axis + 2) % 3;
+
+		// Voxels the box overlaps on the other two axes. Touching faces don't
+		// count as overlap.
+		const S32 minU = static_cast<S32>(floorf(box.min[u] + COLLISION_EPSILON));
+		const S32 maxU = static_cast<S32>(ceilf(box.max[u] - COLLISION_EPSILON)) - 1;
+		const S32 minV = static_cast<S32>(floorf(box.min[v] + COLLISION_EPSILON));
+		const S32 maxV = static_cast<S32>(ceilf(box.max[v] - COLLISION_EPSILON)) - 1;
+
+		S32 start, end, step;
+		if (motion > 0.0f) {
+			start = static_cast<S32>(floorf(box.max[axis]));
+			end = static_cast<S32>(ceilf(box.max[axis] + motion)) - 1;
+			step = 1;
+		} else {
+			start = static_cast<S32>(ceilf(box.min[axis])) - 1;
+			end = static_cast<S32>(floorf(box.min[axis] + motion));
+			step = -1;
+		}
+
+		S32 cell[3];
+		for (S32 layer = start; layer * step <= end * step; layer += step) {
+			cell[axis] = layer;
+			for (S32 a = minU; a <= maxU; ++a) {
+				cell[u] = a;
+				for (S32 b = minV; b <= maxV; ++b) {
+					cell[v] = b;
+					if (!sampler.isSolid(cell[0], cell[1], cell[2]))
+						continue;
+
+					// Stop right at the face of the layer.
+					F32 limit;
+					if (step > 0)
+						limit = static_cast<F32>(layer) - box.max[axis];
+					else
+						limit = static_cast<F32>(layer + 1) - box.min[axis];
+
+					return step > 0 ? glm::clamp(limit, 0.0f, motion) : glm::clamp(limit, motion, 0.0f);
+				}
+			}
+		}
+		return motion;
+	}
+
+	/**
+	 * Moves the box along Y, X and Z in turn.
+	 */
+	glm::vec3 moveAxes(BlockSampler &sampler, AABB &box, const glm::vec3 &motion) {
+		glm::vec3 moved(0.0f);
+		static const S32 order[3] = { 1, 0, 2 };
+		for (S32 axis : order) {
+			moved[axis] = clipAxis(sampler, box, axis, motion[axis]);
+			box.min[axis] += moved[axis];
+			box.max[axis] += moved[axis];
+		}
+		return moved;
+	}
+}
+
+CollisionResult VoxelCollision::move(const World *world, AABB &box, const glm::vec3 &motion, F32 stepHeight) {
+	BlockSampler sampler(world);
+	CollisionResult result;
+
+	const AABB start = box;
+	result.motion = moveAxes(sampler, box, motion);
+	result.collidedX = result.motion.x != motion.x;
+	result.collidedY = result.motion.y != motion.y;
+	result.collidedZ = result.motion.z != motion.z;
+	result.onGround = result.collidedY && motion.y < 0.0f;
+	result.steppedUp = false;
+
+	// Try to climb up a ledge: lift the box, redo the horizontal move and put
+	// it back down. Only keep the result when it got us further.
+	if (stepHeight > 0.0f && result.onGround && (result.collidedX || result.collidedZ)) {
+		AABB stepBox = start;
+		glm::vec3 stepMotion(0.0f);
+
+		stepMotion.y = clipAxis(sampler, stepBox, 1, stepHeight);
+		stepBox = stepBox.translate(glm::vec3(0.0f, stepMotion.y, 0.0f));
+
+		glm::vec3 horizontal(motion.x, 0.0f, motion.z);
+		glm::vec3 moved = moveAxes(sampler, stepBox, horizontal);
+		stepMotion.x = moved.x;
+		stepMotion.z = moved.z;
+
+		F32 down = clipAxis(sampler, stepBox, 1, motion.y - stepMotion.y);
+		stepBox = stepBox.translate(glm::vec3(0.0f, down, 0.0f));
+		stepMotion.y += down;
+
+		F32 original = result.motion.x * result.motion.x + result.motion.z * result.motion.z;
+		F32 stepped = stepMotion.x * stepMotion.x + stepMotion.z * stepMotion.z;
+		if (stepped > original) {
+			box = stepBox;
+			result.motion = stepMotion;
+			result.collidedX = stepMotion.x != motion.x;
+			result.collidedZ = stepMotion.z != motion.z;
+			result.steppedUp = true;
+		}
+	}
+
+	return result;
+}
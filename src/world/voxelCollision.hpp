@@ -0,0 +1,78 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_VOXELCOLLISION_HPP_
+#define _WORLD_VOXELCOLLISION_HPP_
+
+#include <glm/glm.hpp>
+#include "core/aabb.hpp"
+#include "core/types.hpp"
+
+class World;
+
+struct CollisionResult {
+	/**
+	 * The distance that the box actually moved.
+	 */
+	glm::vec3 motion;
+
+	/**
+	 * Set per axis when the motion along that axis was blocked.
+	 */
+	bool collidedX;
+	bool collidedY;
+	bool collidedZ;
+
+	/**
+	 * True if the box landed on or is resting on a solid voxel.
+	 */
+	bool onGround;
+
+	/**
+	 * True if the box climbed up onto a ledge.
+	 */
+	bool steppedUp;
+};
+
+namespace VoxelCollision {
+	/**
+	 * Moves the box through the voxel grid, resolving the sweep one axis at a
+	 * time (Y, then X, then Z) against the solid voxels it overlaps. When the
+	 * horizontal motion is blocked while the box is on the ground, it attempts
+	 * to climb ledges up to stepHeight high. Voxels in chunks that are not
+	 * loaded are treated as solid so bodies never fall out of the world.
+	 *
+	 * Only voxels inside the swept box are looked at and no memory is
+	 * allocated, so this is cheap enough to run for thousands of bodies.
+	 */
+	CollisionResult move(const World *world, AABB &box, const glm::vec3 &motion, F32 stepHeight);
+}
+
+#endif // _WORLD_VOXELCOLLISION_HPP_
@@ -0,0 +1,257 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#include "world/world.hpp"
+#include "world/blockBehaviours.hpp"
+#include "world/blockTickScheduler.hpp"
+#include "world/editLog.hpp"
+#include "world/fluidSimulation.hpp"
+#include "world/lodTerrain.hpp"
+#include "world/regionFile.hpp"
+#include "world/smoothTerrain.hpp"
+#include "world/structuralIntegrity.hpp"
+#include "world/terrainGenerator.hpp"
+
+World::World(const std::string &savePath, bool hugePages) :
+	mPool(hugePages),
+	mChunks(0, ChunkCoordHash(), std::equal_to<ChunkCoord>(), PoolAllocator<std::pair<const ChunkCoord, Chunk*>>(mPool.getNodePool())) {
+	mSavePath = savePath;
+	mEditLog = nullptr;
+	mGenerator = nullptr;
+	mFluids = new FluidSimulation(this);
+	mTicks = new BlockTickScheduler(this);
+	BlockBehaviours::registerDefaults(*mTicks);
+	mStructure = new StructuralIntegrity(this);
+	mLod = new LodTerrain(this);
+	mSmooth = new SmoothTerrain(this);
+	mMeshScratch.reserve(MAX_CHUNK_MESH_VERTICES);
+}
+
+World::~World() {
+	delete mSmooth;
+	delete mLod;
+	delete mFluids;
+	delete mTicks;
+	delete mStructure;
+	for (auto &pair : mChunks)
+		mPool.freeChunk(pair.second);
+	mChunks.clear();
+}
+
+Chunk* World::getChunk(const ChunkCoord &coord) const {
+	auto pos = mChunks.find(coord);
+	if (pos == mChunks.end())
+		return nullptr;
+	return pos->second;
+}
+
+Chunk* World::createChunk(const ChunkCoord &coord) {
+	Chunk *chunk = getChunk(coord);
+	if (chunk != nullptr)
+		return chunk;
+
+	chunk = mPool.allocateChunk(coord);
+	bool loaded = false;
+	if (!mSavePath.empty()) {
+		RegionFile region(mSavePath, RegionFile::getRegionCoord(coord));
+		loaded = region.open(false) && region.readChunk(chunk);
+	}
+	if (!loaded && mGenerator != nullptr)
+		mGenerator->generateChunk(chunk);
+
+	mChunks[coord] = chunk;
+	if (loaded)
+		mFluids->addChunk(chunk);
+	mTicks->addChunk(chunk);
+	mLod->addChunk(coord);
+
+	// The neighbours may have faces towards this chunk that are now hidden.
+	markMeshDirty(coord);
+	markNeighborMeshesDirty(coord);
+	return chunk;
+}
+
+void World::destroyChunk(const ChunkCoord &coord) {
+	auto pos = mChunks.find(coord);
+	if (pos == mChunks.end())
+		return;
+
+	// Make sure that any logged edits make it into the region files before the
+	// voxel data goes away.
+	if (mEditLog != nullptr)
+		mEditLog->snapshotChunk(this, pos->second);
+
+	mFluids->removeChunk(coord);
+	mTicks->removeChunk(coord);
+	mStructure->removeChunk(coord);
+	mLod->removeChunk(coord);
+	mPool.freeChunk(pos->second);
+	mChunks.erase(pos);
+	markNeighborMeshesDirty(coord);
+}
+
+BlockID World::getBlock(const glm::ivec3 &pos) const {
+	const Chunk *chunk = getChunk(getChunkCoord(pos));
+	if (chunk == nullptr)
+		return BlockType::AIR;
+
+	glm::ivec3 local = getLocalPosition(pos);
+	return chunk->getBlock(local.x, local.y, local.z);
+}
+
+void World::setBlock(const glm::ivec3 &pos, BlockID block) {
+	Chunk *chunk = getChunk(getChunkCoord(pos));
+	if (chunk == nullptr)
+		return;
+
+	glm::ivec3 local = getLocalPosition(pos);
+	U32 index = Chunk::getIndex(local.x, local.y, local.z);
+	BlockID old = chunk->getBlockAtIndex(index);
+	if (old == block)
+		return;
+
+	chunk->setBlockAtIndex(index, block);
+	notifyBlockChanged(chunk, index, old);
+	mFluids->activate(pos);
+}
+
+void World::notifyBlockChanged(Chunk *chunk, U32 index, BlockID oldBlock, bool logged) {
+	// Blocks on the border of the chunk are also part of the neighbours' mesh.
+	const S32 x = static_cast<S32>(index & (CHUNK_SIZE - 1));
+	const S32 y = static_cast<S32>(index >> (CHUNK_SHIFT * 2));
+	const S32 z = static_cast<S32>((index >> CHUNK_SHIFT) & (CHUNK_SIZE - 1));
+	markMeshDirty(chunk->getCoord());
+	if (x == 0 || y == 0 || z == 0 || x == CHUNK_SIZE - 1 || y == CHUNK_SIZE - 1 || z == CHUNK_SIZE - 1)
+		markNeighborMeshesDirty(chunk->getCoord());
+
+	if (mEditLog != nullptr && logged) {
+		BlockEdit edit;
+		edit.coord = chunk->getCoord();
+		edit.index = static_cast<U16>(index);
+		edit.oldBlock = oldBlock;
+		edit.newBlock = chunk->getBlockAtIndex(index);
+		mEditLog->append(edit);
+	}
+	mTicks->onBlockChanged(chunk, index, oldBlock);
+	mStructure->onBlockChanged(chunk, index, oldBlock);
+}
+
+void World::setEditLog(EditLog *editLog) {
+	mEditLog = editLog;
+}
+
+void World::setTerrainGenerator(TerrainGenerator *generator) {
+	mGenerator = generator;
+}
+
+U32 World::updateMeshes(U32 maxChunks) {
+	BlockID grid[MESHER_GRID_VOLUME];
+
+	U32 meshed = 0;
+	size_t i = 0;
+	for (; i < mDirtyMeshes.size() && meshed < maxChunks; ++i) {
+		// Chunks that were unloaded or already meshed since are skipped.
+		Chunk *chunk = getChunk(mDirtyMeshes[i]);
+		if (chunk == nullptr || !chunk->isMeshDirty())
+			continue;
+
+		if (chunk->getMesh() == nullptr)
+			chunk->setMesh(mPool.allocateMesh());
+		chunk->updateOccluders();
+		chunk->updateFaceConnections();
+		ChunkMesher::gatherBlocks(this, chunk, grid);
+		const U32 translucentOffset = ChunkMesher::buildMesh(grid, mMeshScratch);
+		mPool.setMeshVertices(chunk->getMesh(), mMeshScratch.data(), static_cast<U32>(mMeshScratch.size()), translucentOffset);
+		chunk->setMeshDirty(false);
+		++meshed;
+	}
+	mDirtyMeshes.erase(mDirtyMeshes.begin(), mDirtyMeshes.begin() + i);
+	return meshed;
+}
+
+void World::updateFluids(F64 delta) {
+	mFluids->update(delta);
+}
+
+void World::updateBlockTicks(F64 delta) {
+	mTicks->update(delta);
+}
+
+void World::updateStructuralIntegrity(F64 delta) {
+	mStructure->update(delta);
+}
+
+void World::updateLods(const glm::vec3 &cameraPosition, U32 maxBuilds) {
+	mLod->update(cameraPosition, maxBuilds);
+
+	// Goes second as it fills in around the voxel terrain's roots.
+	mSmooth->update(cameraPosition, maxBuilds);
+}
+
+void World::setSmoothTerrainDistance(F32 distance) {
+	mSmooth->setViewDistance(distance);
+}
+
+void World::markMeshDirty(const ChunkCoord &coord) {
+	Chunk *chunk = getChunk(coord);
+	if (chunk == nullptr)
+		return;
+
+	// The downsampled meshes are built from the blocks, they are out of date
+	// even if the chunk's own mesh hasn't been rebuilt since the last change.
+	mLod->markChunkChanged(coord);
+	if (chunk->isMeshDirty())
+		return;
+
+	chunk->setMeshDirty(true);
+	mDirtyMeshes.push_back(coord);
+}
+
+void World::markNeighborMeshesDirty(const ChunkCoord &coord) {
+	markMeshDirty({ coord.x - 1, coord.y, coord.z });
+	markMeshDirty({ coord.x + 1, coord.y, coord.z });
+	markMeshDirty({ coord.x, coord.y - 1, coord.z });
+	markMeshDirty({ coord.x, coord.y + 1, coord.z });
+	markMeshDirty({ coord.x, coord.y, coord.z - 1 });
+	markMeshDirty({ coord.x, coord.y, coord.z + 1 });
+}
+
+ChunkCoord World::getChunkCoord(const glm::ivec3 &pos) {
+	// Arithmetic shift floors negative coordinates towards negative infinity.
+	ChunkCoord coord;
+	coord.x = pos.x >> CHUNK_SHIFT;
+	coord.y = pos.y >> CHUNK_SHIFT;
+	coord.z = pos.z >> CHUNK_SHIFT;
+	return coord;
+}
+
+glm::ivec3 World::getLocalPosition(const glm::ivec3 &pos) {
+	return glm::ivec3(pos.x & (CHUNK_SIZE - 1), pos.y & (CHUNK_SIZE - 1), pos.z & (CHUNK_SIZE - 1));
+}
@@ -0,0 +1,192 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016, Jeff Hutchinson
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the project nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-----------------------------------------------------------------------------
+
+#ifndef _WORLD_WORLD_HPP_
+#define _WORLD_WORLD_HPP_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "core/fixedPool.hpp"
+#include "core/types.hpp"
+#include "world/chunk.hpp"
+#include "world/chunkMesher.hpp"
+#include "world/chunkPool.hpp"
+
+class BlockTickScheduler;
+class EditLog;
+class FluidSimulation;
+class LodTerrain;
+class SmoothTerrain;
+class StructuralIntegrity;
+class TerrainGenerator;
+
+class World {
+public:
+	typedef std::unordered_map<ChunkCoord, Chunk*, ChunkCoordHash, std::equal_to<ChunkCoord>, PoolAllocator<std::pair<const ChunkCoord, Chunk*>>> ChunkMap;
+
+	/**
+	 * @param savePath The path prefix that region files are stored under. An
+	 *   empty path keeps the world in memory only.
+	 * @param hugePages Back the chunk pool with huge pages where possible.
+	 */
+	World(const std::string &savePath, bool hugePages = false);
+	~World();
+
+	const std::string& getSavePath() const {
+		return mSavePath;
+	}
+
+	Chunk* getChunk(const ChunkCoord &coord) const;
+
+	/**
+	 * Creates the chunk at coord, loading its voxels from the region files if
+	 * it was previously saved or generating them otherwise. Returns the
+	 * existing chunk if already loaded.
+	 */
+	Chunk* createChunk(const ChunkCoord &coord);
+	void destroyChunk(const ChunkCoord &coord);
+
+	BlockID getBlock(const glm::ivec3 &pos) const;
+
+	/**
+	 * Sets a block in world space. The edit is recorded in the edit log if one
+	 * is attached. Edits inside chunks that are not loaded are ignored.
+	 */
+	void setBlock(const glm::ivec3 &pos, BlockID block);
+
+	/**
+	 * Marks the meshes showing a block that was changed in the chunk's voxels
+	 * directly, records the change in the edit log and tells the block ticks
+	 * and the structural integrity.
+	 * setBlock() does this along with waking the fluids around the block.
+	 * @param logged False for changes that aren't saved, like the flowing
+	 *   fluid that is rebuilt from its sources.
+	 */
+	void notifyBlockChanged(Chunk *chunk, U32 index, BlockID oldBlock, bool logged = true);
+
+	void setEditLog(EditLog *editLog);
+	void setTerrainGenerator(TerrainGenerator *generator);
+
+	const TerrainGenerator* getTerrainGenerator() const {
+		return mGenerator;
+	}
+
+	/**
+	 * Rebuilds the CPU meshes of up to maxChunks chunks whose mesh is dirty, in
+	 * the order they were dirtied. Returns the amount of chunks meshed.
+	 */
+	U32 updateMeshes(U32 maxChunks);
+
+	const ChunkMap& getChunks() const {
+		return mChunks;
+	}
+
+	/**
+	 * Runs the fluid simulation steps that are due after delta seconds.
+	 */
+	void updateFluids(F64 delta);
+
+	FluidSimulation& getFluids() {
+		return *mFluids;
+	}
+
+	/**
+	 * Runs the block tick steps that are due after delta seconds.
+	 */
+	void updateBlockTicks(F64 delta);
+
+	BlockTickScheduler& getBlockTicks() {
+		return *mTicks;
+	}
+
+	/**
+	 * Searches for blocks that lost their support and moves the falling ones
+	 * by delta seconds.
+	 */
+	void updateStructuralIntegrity(F64 delta);
+
+	StructuralIntegrity& getStructuralIntegrity() {
+		return *mStructure;
+	}
+
+	/**
+	 * Selects the levels of detail to draw the world with from the camera
+	 * position and builds up to maxBuilds downsampled meshes, and as many
+	 * smooth meshes if the smooth terrain is on.
+	 */
+	void updateLods(const glm::vec3 &cameraPosition, U32 maxBuilds);
+
+	const LodTerrain& getLodTerrain() const {
+		return *mLod;
+	}
+
+	/**
+	 * Draws the terrain beyond the loaded chunks out to distance from the
+	 * generator's density field. Zero turns it off, which is the default.
+	 */
+	void setSmoothTerrainDistance(F32 distance);
+
+	const SmoothTerrain& getSmoothTerrain() const {
+		return *mSmooth;
+	}
+
+	const ChunkPool& getPool() const {
+		return mPool;
+	}
+
+	ChunkPool& getPool() {
+		return mPool;
+	}
+
+	static ChunkCoord getChunkCoord(const glm::ivec3 &pos);
+	static glm::ivec3 getLocalPosition(const glm::ivec3 &pos);
+
+private:
+	std::string mSavePath;
+	ChunkPool mPool;
+	ChunkMap mChunks;
+	EditLog *mEditLog;
+	TerrainGenerator *mGenerator;
+	FluidSimulation *mFluids;
+	BlockTickScheduler *mTicks;
+	StructuralIntegrity *mStructure;
+	LodTerrain *mLod;
+	SmoothTerrain *mSmooth;
+
+	std::vector<ChunkCoord> mDirtyMeshes;
+	std::vector<ChunkVertex> mMeshScratch;
+
+	void markMeshDirty(const ChunkCoord &coord);
+	void markNeighborMeshesDirty(const ChunkCoord &coord);
+};
+
+#endif // _WORLD_WORLD_HPP_